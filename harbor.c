@@ -0,0 +1,503 @@
+/** @file harbor.c
+    @brief
+    libharbor: the Harbor GPS and sensor reductions as library calls.
+
+    @details
+    harborLine() takes each line through the steps of hgps and hsensor:
+    the comment check, the parse, the calibration, the --from and --to
+    range, min_sats and the outlier filter.  It counts the lines into the
+    HSTAT and ends the parse and filter stages of its timers; the
+    callbacks end the stages of what they do with the line.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added harborRead(), for hgps and hsensor.
+    @endverbatim
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <math.h>
+#include "harbor.h"
+
+static void gpsLine( HARBOR *h, const char *str, size_t len );
+static void sensorLine( HARBOR *h, const char *str, size_t len );
+static void comment( HARBOR *h, const char *str, size_t len, size_t nlines,
+		     int why );
+static void average( HARBOR *h );
+
+/**
+   Adds values from raw to avg.
+   @param[in] navg Number of points in current average.
+   @param[in] raw Raw data values.
+   @param[in,out] avg Sums to be converted to averages by harborGpsMean().
+   @return navg+1.
+*/
+int harborGpsAdd( int navg, const GPSDATA *raw, GPSSUM *avg )
+{
+  if( navg < 1 )
+    { /* First data for new average */
+      avg->tsecs = raw->tsecs;
+      avg->mday = raw->mday;    /* Save date of first data point */
+      avg->month = raw->month;
+      avg->year = raw->year;
+      avg->hour = raw->hour;
+      avg->todaySecs = raw->hour*3600+raw->minute*60+raw->second;
+      avg->lat = raw->lat;
+      avg->lon = raw->lon;
+      avg->alt = raw->alt;
+      avg->nsats = raw->nsats;
+      navg = 0;
+    }
+  else
+    { /* Additional data for average */
+      int hh;
+
+      avg->tsecs += raw->tsecs;
+      if( raw->hour < avg->hour ) hh = raw->hour+24; /* rollover */
+      else hh = raw->hour;
+      avg->todaySecs += hh*3600+raw->minute*60+raw->second;
+      avg->lat += raw->lat;
+      avg->lon += raw->lon;
+      avg->alt += raw->alt;
+      avg->nsats += raw->nsats;
+    }
+  return navg+1;
+} /* harborGpsAdd */
+
+/**
+   Convert sums to averages.  An average time past midnight is given the
+   date of @a raw, as the first record of the period has the day before.
+   @param[in] navg Number of points in average, at least one.
+   @param[in] raw Latest data record, used for time information.
+   @param[in] avg Sums for the period.
+   @param[out] wide Averages.
+*/
+void harborGpsMean( int navg, const GPSDATA *raw, const GPSSUM *avg,
+		    GPSWIDE *wide )
+{
+  int hh, todaySecs;
+
+  wide->tsecs = avg->tsecs/navg;
+  wide->lat = avg->lat/navg;
+  wide->lon = avg->lon/navg;
+  wide->alt = avg->alt/navg;
+  wide->nsats = avg->nsats/navg;
+  todaySecs = avg->todaySecs/navg;
+  hh = todaySecs/3600;
+  wide->minute = (todaySecs-hh*3600)/60;
+  wide->second = todaySecs%60;
+  if( hh >= 24 )
+    { /* Use date from latest record */
+      wide->hour = hh-24;
+      wide->year = raw->year;
+      wide->month = raw->month;
+      wide->mday = raw->mday; /* could have a weird day at end of month */
+    }
+  else
+    { /* Use date from first record in avg */
+      wide->hour = hh;
+      wide->year = avg->year;
+      wide->month = avg->month;
+      wide->mday = avg->mday;
+    }
+} /* harborGpsMean */
+
+/**
+   Adds values from raw to avg, only for the vectors holding a field
+   selection.
+   @param[in] proj Fields averaged, or NULL for all.
+   @param[in] navg Number of points in current average.
+   @param[in] raw Raw data values.
+   @param[in,out] avg Sums to be converted to averages by
+   harborSensorMean().
+   @return navg+1.
+*/
+int harborSensorAdd( const SENSORPROJ *proj, int navg,
+		     const SENSORDATA *raw, SENSORSUM *avg )
+{
+  int i, n, nvec;
+
+  nvec = proj ? proj->nvec : SENSOR_NLANES/4;
+  if( navg < 1 )
+    { /* First data for new average */
+      for( n = 0; n < nvec; n++ )
+	{
+	  i = proj ? proj->vec[n] : n;
+	  avg->vec[i] = __builtin_convertvector( raw->vec[i], SENSORDVEC );
+	}
+      navg = 0;
+    }
+  else /* Additional data for average */
+    for( n = 0; n < nvec; n++ )
+      {
+	i = proj ? proj->vec[n] : n;
+	avg->vec[i] += __builtin_convertvector( raw->vec[i], SENSORDVEC );
+      }
+  return navg+1;
+} /* harborSensorAdd */
+
+/**
+   Subtracts the values of raw from avg, only for the vectors holding a
+   field selection.  The inverse of harborSensorAdd(), for a record
+   leaving a sliding window.
+   @param[in] proj Fields averaged, or NULL for all.
+   @param[in] navg Number of points in current average.
+   @param[in] raw Raw data values, as added to avg.
+   @param[in,out] avg Sums to be converted to averages by
+   harborSensorMean().
+   @return navg-1.
+*/
+int harborSensorDrop( const SENSORPROJ *proj, int navg,
+		      const SENSORDATA *raw, SENSORSUM *avg )
+{
+  int i, n, nvec;
+
+  nvec = proj ? proj->nvec : SENSOR_NLANES/4;
+  for( n = 0; n < nvec; n++ )
+    {
+      i = proj ? proj->vec[n] : n;
+      avg->vec[i] -= __builtin_convertvector( raw->vec[i], SENSORDVEC );
+    }
+  return navg-1;
+} /* harborSensorDrop */
+
+/**
+   Convert sums to averages, only for the vectors holding a field
+   selection.
+   @param[in] proj Fields averaged, or NULL for all.
+   @param[in] navg Number of points in average, at least one.
+   @param[in] avg Sums for the period.
+   @param[out] rec Averages.
+*/
+void harborSensorMean( const SENSORPROJ *proj, int navg,
+		       const SENSORSUM *avg, SENSORDATA *rec )
+{
+  int i, n, nvec;
+
+  nvec = proj ? proj->nvec : SENSOR_NLANES/4;
+  for( n = 0; n < nvec; n++ )
+    {
+      i = proj ? proj->vec[n] : n;
+      rec->vec[i] = __builtin_convertvector( avg->vec[i]/(double) navg,
+					     SENSORVEC );
+    }
+} /* harborSensorMean */
+
+/**
+   Set pipeline options to the defaults of the programs: no averaging, no
+   time range, no satellite minimum, no outlier filter, all sensor fields
+   in counts and no statistics.
+   @param[out] opt Options.
+   @param[in] type HARBOR_GPS or HARBOR_SENSOR.
+*/
+void harborOptions( HARBOROPTS *opt, int type )
+{
+  memset( opt, 0, sizeof(HARBOROPTS) );
+  opt->type = type;
+  opt->from = -HUGE_VALF;
+  opt->to = HUGE_VALF;
+} /* harborOptions */
+
+/**
+   Create a pipeline.  The options are copied, but the field selection,
+   calibration and statistics they point to must last until
+   harborClose().
+   @param[in] opt Options.
+   @param[in] calls Callbacks, or NULL for none.
+   @return Pipeline, or NULL with errno set: EINVAL for a bad type or
+   reject specification.
+*/
+HARBOR *harborOpen( const HARBOROPTS *opt, const HARBORCALLS *calls )
+{
+  HARBOR *h;
+  int i, c, nsel;
+
+  if( opt->type != HARBOR_GPS && opt->type != HARBOR_SENSOR )
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+  if( (h = calloc( 1, sizeof(HARBOR) )) == NULL ) return NULL;
+  h->opt = *opt;
+  if( calls ) h->calls = *calls;
+  h->t0 = -1.0;
+  if( opt->type == HARBOR_GPS )
+    h->nchk = 3; /* lat, lon, alt */
+  else
+    { /* The selected fields other than tsecs */
+      nsel = opt->fields ? opt->fields->nsel : SENSOR_NFIELDS;
+      for( i = 0; i < nsel; i++ )
+	if( (c = opt->fields ? opt->fields->field[i] : i) != 0 )
+	  h->chkField[h->nchk++] = c;
+    }
+  if( opt->reject && (h->filt = hfiltOpen( opt->reject, h->nchk )) == NULL )
+    {
+      free( h );
+      errno = EINVAL;
+      return NULL;
+    }
+  return h;
+} /* harborOpen */
+
+/**
+   Reduce one line.
+   @param[in,out] h Pipeline.
+   @param[in] str Line, with its newline unless it is the last line.
+   @param[in] len Length of line, at least one.
+*/
+void harborLine( HARBOR *h, const char *str, size_t len )
+{
+  hstatLine( h->opt.stats, len );
+  if( !isdigit( *str ) ) /* Not a data record */
+    comment( h, str, len, 1, HSTAT_COMMENTS );
+  else if( h->opt.type == HARBOR_GPS )
+    gpsLine( h, str, len );
+  else
+    sensorLine( h, str, len );
+} /* harborLine */
+
+/**
+   Reduce the lines of a reader, to its end or, in follow mode, to the
+   end of the data written so far.  A comment line is passed on together
+   with the comment lines after it that hreadComments() finds.
+   @param[in,out] h Pipeline.
+   @param[in,out] in Reader.
+*/
+void harborRead( HARBOR *h, HREADER *in )
+{
+  const char *str;
+  size_t len, first, nrun;
+
+  while( hreadLine( in, &str, &len ) )
+    if( isdigit( *str ) )
+      harborLine( h, str, len );
+    else
+      { /* With the comment lines that follow it */
+	hstatLine( h->opt.stats, len );
+	first = len;
+	nrun = hreadComments( in, str, &len, HSTAT_LONGLINE );
+	hstatComments( h->opt.stats, nrun-1, len-first );
+	comment( h, str, len, nrun, HSTAT_COMMENTS );
+      }
+} /* harborRead */
+
+/**
+   Reduce a GPS data line.
+   @param[in,out] h Pipeline.
+   @param[in] str Line.
+   @param[in] len Length of line.
+*/
+static void gpsLine( HARBOR *h, const char *str, size_t len )
+{
+  GPSDATA *raw = &h->gps;
+  float chk[3];
+
+  if( parseGPS( str, str+len, raw ) != GPS_NFIELDS )
+    { /* Insufficient data, treat as comment */
+      comment( h, str, len, 1, str[len-1] == '\n' ? HSTAT_MALFORMED :
+	       HSTAT_TRUNCATED );
+      return;
+    }
+  hstatLap( h->opt.stats, HSTAT_PARSE );
+  if( raw->tsecs < h->opt.from || raw->tsecs > h->opt.to )
+    {
+      hstatCount( h->opt.stats, HSTAT_RANGE );
+      return;
+    }
+  if( raw->nsats < h->opt.minSats )
+    { /* No GPS lock, ignore data */
+      comment( h, str, len, 1, HSTAT_MINSATS );
+      return;
+    }
+  if( h->filt )
+    { /* Position jumps are written as comments */
+      chk[0] = raw->lat;
+      chk[1] = raw->lon;
+      chk[2] = raw->alt;
+      if( hfiltCheck( h->filt, chk ) >= 0 )
+	{
+	  hstatLap( h->opt.stats, HSTAT_FILTER );
+	  comment( h, str, len, 1, HSTAT_REJECTED );
+	  return;
+	}
+    }
+  hstatLap( h->opt.stats, HSTAT_FILTER );
+  hstatCount( h->opt.stats, HSTAT_RECORDS );
+  raw->year += 2000; /* Convert to full year */
+  if( h->calls.record ) h->calls.record( h->calls.ctx, raw );
+  if( h->opt.avgSecs <= 0.0 ) return; /* No averaging */
+  if( raw->tsecs-h->t0 > h->opt.avgSecs || h->t0 < 0.0 )
+    { /* Average for last period */
+      average( h );
+      h->navg = harborGpsAdd( 0, raw, &h->gsum );
+      h->t0 = raw->tsecs;
+    }
+  else /* Accumulate data for next average */
+    h->navg = harborGpsAdd( h->navg, raw, &h->gsum );
+} /* gpsLine */
+
+/**
+   Reduce a sensor data line.
+   @param[in,out] h Pipeline.
+   @param[in] str Line.
+   @param[in] len Length of line.
+*/
+static void sensorLine( HARBOR *h, const char *str, size_t len )
+{
+  SENSORDATA *raw = &h->sensor;
+  float chk[SENSOR_NFIELDS];
+  int i;
+
+  if( parseSensorFields( str, str+len, h->opt.fields, raw ) !=
+      SENSOR_NFIELDS )
+    { /* Insufficient data, treat as comment */
+      comment( h, str, len, 1, str[len-1] == '\n' ? HSTAT_MALFORMED :
+	       HSTAT_TRUNCATED );
+      return;
+    }
+  if( h->opt.cal ) hcalApply( h->opt.cal, raw );
+  hstatLap( h->opt.stats, HSTAT_PARSE );
+  if( raw->tsecs < h->opt.from || raw->tsecs > h->opt.to )
+    {
+      hstatCount( h->opt.stats, HSTAT_RANGE );
+      return;
+    }
+  if( h->filt )
+    { /* Spikes are written as comments */
+      for( i = 0; i < h->nchk; i++ ) chk[i] = raw->v[h->chkField[i]];
+      if( hfiltCheck( h->filt, chk ) >= 0 )
+	{
+	  hstatLap( h->opt.stats, HSTAT_FILTER );
+	  comment( h, str, len, 1, HSTAT_REJECTED );
+	  return;
+	}
+    }
+  hstatLap( h->opt.stats, HSTAT_FILTER );
+  hstatCount( h->opt.stats, HSTAT_RECORDS );
+  if( h->calls.record ) h->calls.record( h->calls.ctx, raw );
+  if( h->opt.avgSecs <= 0.0 ) return; /* No averaging */
+  if( raw->tsecs-h->t0 > h->opt.avgSecs || h->t0 < 0.0 )
+    { /* Average for last period */
+      average( h );
+      h->navg = harborSensorAdd( h->opt.fields, 0, raw, &h->ssum );
+      h->t0 = raw->tsecs;
+    }
+  else /* Accumulate data for next average */
+    h->navg = harborSensorAdd( h->opt.fields, h->navg, raw, &h->ssum );
+} /* sensorLine */
+
+/**
+   Count a line that is passed on as a comment, and pass it on.
+   @param[in,out] h Pipeline.
+   @param[in] str Line, or run of comment lines.
+   @param[in] len Length of str.
+   @param[in] nlines Number of lines in str; the ones after the first
+   are already counted.
+   @param[in] why HSTAT_* reason.
+*/
+static void comment( HARBOR *h, const char *str, size_t len, size_t nlines,
+		     int why )
+{
+  hstatCount( h->opt.stats, why );
+  if( h->calls.comment )
+    h->calls.comment( h->calls.ctx, str, len, nlines, why );
+} /* comment */
+
+/**
+   Pass on the average of the current period, if it has any records.
+   @param[in] h Pipeline.
+*/
+static void average( HARBOR *h )
+{
+  GPSWIDE wide;
+  SENSORDATA rec;
+
+  if( h->navg < 1 || h->calls.average == NULL ) return;
+  if( h->opt.type == HARBOR_GPS )
+    {
+      harborGpsMean( h->navg, &h->gps, &h->gsum, &wide );
+      h->calls.average( h->calls.ctx, &wide, h->navg );
+    }
+  else
+    {
+      memset( &rec, 0, sizeof(rec) );
+      harborSensorMean( h->opt.fields, h->navg, &h->ssum, &rec );
+      h->calls.average( h->calls.ctx, &rec, h->navg );
+    }
+} /* average */
+
+/**
+   Reduce the next part of the input.  Complete lines are reduced where
+   they lie in @a buf; only a last line without its newline is kept, to
+   be finished by the next call or by harborFinish().
+   @param[in,out] h Pipeline.
+   @param[in] buf Input bytes.
+   @param[in] len Number of bytes.
+   @return 0 on success, or -1 with errno set if a line could not be kept.
+*/
+int harborFeed( HARBOR *h, const char *buf, size_t len )
+{
+  const char *p, *end = buf+len, *nl;
+  char *line;
+  size_t n, size;
+
+  p = buf;
+  while( p < end )
+    {
+      nl = memchr( p, '\n', end-p );
+      n = nl ? (size_t) (nl+1-p) : (size_t) (end-p);
+      if( h->len > 0 || nl == NULL )
+	{ /* Join to the kept part of the line, or keep it */
+	  if( h->len+n > h->size )
+	    {
+	      for( size = h->size ? h->size : 256; size < h->len+n; size *= 2 )
+		;
+	      if( (line = realloc( h->line, size )) == NULL ) return -1;
+	      h->line = line;
+	      h->size = size;
+	    }
+	  memcpy( h->line+h->len, p, n );
+	  h->len += n;
+	  if( nl )
+	    {
+	      harborLine( h, h->line, h->len );
+	      h->len = 0;
+	    }
+	}
+      else
+	harborLine( h, p, n );
+      p += n;
+    }
+  return 0;
+} /* harborFeed */
+
+/**
+   End the input: reduce a last line that has no newline and pass on the
+   average of the last period.  The pipeline may then be fed a new input.
+   @param[in,out] h Pipeline.
+*/
+void harborFinish( HARBOR *h )
+{
+  if( h->len > 0 ) harborLine( h, h->line, h->len );
+  h->len = 0;
+  average( h );
+  h->navg = 0;
+  h->t0 = -1.0;
+} /* harborFinish */
+
+/**
+   Free a pipeline.
+   @param[in] h Pipeline, or NULL.
+*/
+void harborClose( HARBOR *h )
+{
+  if( h == NULL ) return;
+  if( h->filt ) hfiltClose( h->filt );
+  free( h->line );
+  free( h );
+} /* harborClose */
@@ -0,0 +1,185 @@
+/** @file harbor.h
+    @brief
+    libharbor: the Harbor GPS and sensor reductions as library calls.
+
+    @details
+    The parsing, filtering and averaging of hgps and hsensor, for
+    programs that reduce Harbor data in-process instead of running the
+    executables and reading their text output.  A HARBOR pipeline is fed
+    raw CSV bytes as they arrive, in buffers of any size, with
+    harborFeed(), and hands each accepted record, each average and each
+    comment line to callbacks:
+    @verbatim
+    HARBOROPTS opt;
+    HARBORCALLS calls = { ctx, onRecord, onAverage, onComment };
+    harborOptions( &opt, HARBOR_GPS );
+    opt.avgSecs = 10.0;
+    opt.minSats = 4;
+    h = harborOpen( &opt, &calls );
+    while( (n = read( fd, buf, sizeof(buf) )) > 0 ) harborFeed( h, buf, n );
+    harborFinish( h );
+    harborClose( h );
+    @endverbatim
+    Lines are handed to the parser and to the comment callback as spans
+    of the caller's buffer, so nothing is copied except a line that runs
+    across the end of one buffer into the next, and the callbacks are
+    given records and averages in the structures of hrec.h with no text
+    formatting.  The records and averages are those hgps or hsensor with
+    the same options would write, before formatting.
+
+    harborRead() reduces the lines of an hread reader instead, copying a
+    run of comment lines to the comment callback in one go.  hgps and
+    hsensor read their input that way with no averaging, passing each
+    accepted record on to their own windows, so the steps a line goes
+    through are those of harborLine() in the programs and the library
+    alike.  The averaging arithmetic, harborGpsAdd() and harborGpsMean()
+    and the harborSensor ones, is what the programs use too; they add the
+    output files, several windows, threads and the other options that
+    work on whole files.
+
+    Build the library with
+    @verbatim
+    gcc -Wall -O2 -c harbor.c hrec.c hcsv.c hread.c hout.c hcol.c hfilt.c \
+        hcal.c hstat.c
+    ar rcs libharbor.a harbor.o hrec.o hcsv.o hread.o hout.o hcol.o hfilt.o \
+        hcal.o hstat.o
+    @endverbatim
+    and link with -lharbor -pthread -lz -lm.  The header may be included
+    from C++.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added harborRead(), for hgps and hsensor.
+    @endverbatim
+*/
+#ifndef HARBOR_H
+#define HARBOR_H
+#include <stddef.h>
+#include "hread.h"
+#include "hrec.h"
+#include "hfilt.h"
+#include "hcal.h"
+#include "hstat.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+   Sums for one GPS averaging period.  The floating point fields are
+   summed in double, so long windows keep the full precision of the float
+   inputs.
+*/
+typedef struct
+{
+  int mday, month, year; ///< Date of the first record
+  int hour;              ///< Hour of the first record
+  int todaySecs;         ///< Sum of seconds since midnight
+  int nsats;             ///< Sum of satellites in view
+  double tsecs;          ///< Sum of seconds since start of dataset
+  double lat, lon, alt;  ///< Sums of the position
+} GPSSUM;
+
+/**
+   Four double lanes, for summing SENSORVEC values.  Only 16-byte
+   alignment is assumed, which is what malloc() guarantees.
+*/
+typedef double SENSORDVEC __attribute__((vector_size(32), aligned(16)));
+
+/**
+   Sums for one sensor averaging period, in the lane order of SENSORDATA.
+   The sums are kept in double, so long windows keep the full precision
+   of the float inputs.
+*/
+typedef struct
+{
+  SENSORDVEC vec[SENSOR_NLANES/4]; ///< Sums as vectors
+} SENSORSUM;
+
+/**
+   Record types of a pipeline.
+*/
+enum { HARBOR_GPS, HARBOR_SENSOR };
+
+/**
+   Options of a pipeline, the library form of the hgps and hsensor
+   options.  Set the defaults with harborOptions().
+*/
+typedef struct
+{
+  int type;                 ///< HARBOR_GPS or HARBOR_SENSOR
+  float avgSecs;            ///< Averaging period, zero for no averages
+  float from, to;           ///< Range of record times to keep
+  int minSats;              ///< GPS: minimum satellites for a record
+  const char *reject;       ///< Outlier filter "k[,n]", or NULL
+  const SENSORPROJ *fields; ///< Sensor fields to convert, or NULL for all
+  const HCAL *cal;          ///< Sensor calibration, or NULL for counts
+  HSTAT *stats;             ///< Statistics to count into, or NULL
+} HARBOROPTS;
+
+/**
+   Callbacks of a pipeline.  Any may be NULL.  The pointers they are
+   given are valid only during the call.
+*/
+typedef struct
+{
+  void *ctx;                ///< Passed to each callback
+  /** Accepted record: a GPSDATA, with the full year, or a SENSORDATA. */
+  void (*record)( void *ctx, const void *rec );
+  /** Average of @a navg records: a GPSWIDE, or a SENSORDATA holding the
+      HARBOROPTS::fields selection. */
+  void (*average)( void *ctx, const void *avg, int navg );
+  /** Line written as a comment, including its newline if any, and why:
+      HSTAT_COMMENTS, HSTAT_MALFORMED, HSTAT_TRUNCATED, HSTAT_MINSATS or
+      HSTAT_REJECTED.  From harborRead() a comment may come with the
+      comment lines after it, @a nlines in all, as for houtComments(). */
+  void (*comment)( void *ctx, const char *line, size_t len, size_t nlines,
+		   int why );
+} HARBORCALLS;
+
+/**
+   Pipeline state.  Use harborOpen() to create one.
+*/
+typedef struct
+{
+  HARBOROPTS opt;           ///< Options
+  HARBORCALLS calls;        ///< Callbacks
+  HFILT *filt;              ///< Outlier filter, or NULL
+  int nchk;                 ///< Fields checked by filt
+  int chkField[SENSOR_NFIELDS]; ///< Sensor fields checked by filt
+  char *line;               ///< Line cut off by the end of a buffer
+  size_t len, size;         ///< Bytes in line and allocated
+  float t0;                 ///< Start time of the current period
+  int navg;                 ///< Records in the current period
+  GPSDATA gps;              ///< Last GPS line parsed
+  GPSSUM gsum;              ///< Sums of the current GPS period
+  SENSORDATA sensor;        ///< Last sensor record parsed
+  SENSORSUM ssum;           ///< Sums of the current sensor period
+} HARBOR;
+
+int harborGpsAdd( int navg, const GPSDATA *raw, GPSSUM *avg );
+void harborGpsMean( int navg, const GPSDATA *raw, const GPSSUM *avg,
+		    GPSWIDE *wide );
+int harborSensorAdd( const SENSORPROJ *proj, int navg,
+		     const SENSORDATA *raw, SENSORSUM *avg );
+int harborSensorDrop( const SENSORPROJ *proj, int navg,
+		      const SENSORDATA *raw, SENSORSUM *avg );
+void harborSensorMean( const SENSORPROJ *proj, int navg,
+		       const SENSORSUM *avg, SENSORDATA *rec );
+
+void harborOptions( HARBOROPTS *opt, int type );
+HARBOR *harborOpen( const HARBOROPTS *opt, const HARBORCALLS *calls );
+void harborLine( HARBOR *h, const char *str, size_t len );
+void harborRead( HARBOR *h, HREADER *in );
+int harborFeed( HARBOR *h, const char *buf, size_t len );
+void harborFinish( HARBOR *h );
+void harborClose( HARBOR *h );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARBOR_H */
@@ -0,0 +1,302 @@
+/** @file hbatch.c
+    @brief
+    Run hgps, hsensor or hjoin over many flight files on a worker pool.
+
+    @details
+    The hbatch program runs one command per input file, several at a time,
+    and writes each command's standard output to its own file.  Inputs are
+    started largest first so the long files do not finish last on a single
+    worker.  Each file is processed by its own process, so it behaves
+    exactly as a single run of the command would, and a failure affects
+    only that file.  A summary with the status, time and throughput of
+    every file is written to standard output.
+    @verbatim
+    Compile: gcc -Wall -O2 -o hbatch hbatch.c hout.c -pthread
+    Use: hbatch [-j nworkers] [-o output_%s.txt] command [args...]
+                -- input.csv... > summary.txt
+    @endverbatim
+    @arg @c -j @c nworkers is the number of files processed at once,
+    default the number of online CPUs
+    @arg @c -o @c output_%s.txt names the output file of each input; "%s"
+    is replaced by the input file name without its directory and ".csv"
+    suffix, default "%s.txt".  Inputs whose outputs would have the same
+    name, such as a/f.csv and b/f.csv, are an error, found before any
+    command is started; put them in separate runs with -o names of their
+    own.
+    @arg @c command and @c args are the program to run, such as hgps, and
+    its arguments.  Every argument "{}" is replaced by the input file
+    name; without one the input file name is the command's first
+    argument.
+    @arg @c input.csv are the files to process, for example from a glob
+
+    For example, to average every GPS file of a campaign over 10 seconds
+    with at least 4 satellites, four at a time:
+    @verbatim
+    hbatch -j 4 -o out/%s.txt ./hgps {} 10 4 -- flights/gps*.csv
+    @endverbatim
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Refuse inputs that would share an output file.
+    2026-Oct-14 Replace every "{}", not just the last.
+    @endverbatim
+*/
+/**
+   Code modification date
+*/
+#define CODE_MOD_DATE "Mod_Date:2026-Oct-14"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "hout.h"
+
+/**
+   One input file and the command run on it.
+*/
+typedef struct
+{
+  const char *input;  ///< Input file name
+  char *output;       ///< Output file name
+  off_t size;         ///< Size of the input in bytes
+  pid_t pid;          ///< Worker process, 0 if not started
+  double start;       ///< Start time
+  double secs;        ///< Elapsed time
+  int status;         ///< Status from waitpid()
+} JOB;
+
+int cmpSize( const void *a, const void *b );
+int cmpOutput( const void *a, const void *b );
+pid_t startJob( JOB *job, char **cmd, int ncmd, const int *inArg,
+		int nin );
+double now( void );
+
+int main( int argc, char **argv )
+{
+  int nworkers, njobs, ncmd, nin, running, next, nfail, c, i;
+  const char *outName, *base, *dot;
+  char *stem;
+  double t0, secs;
+  off_t total;
+  struct stat st;
+  JOB *job, **byName;
+  char **cmd;
+  int *inArg;
+  pid_t pid;
+
+  nworkers = sysconf( _SC_NPROCESSORS_ONLN );
+  if( nworkers < 1 ) nworkers = 1;
+  outName = "%s.txt";
+  while( (c = getopt( argc, argv, "+j:o:" )) != -1 )
+    switch( c )
+      {
+      case 'j':
+	nworkers = atoi( optarg );
+	break;
+      case 'o':
+	outName = optarg;
+	break;
+      default:
+	nworkers = 0;
+	break;
+      }
+  /* Command runs up to "--", the inputs follow */
+  for( i = optind; i < argc && strcmp( argv[i], "--" ); i++ )
+    ;
+  ncmd = i-optind;
+  njobs = argc-i-1;
+  if( nworkers < 1 || ncmd < 1 || njobs < 1 || !strstr( outName, "%s" ) )
+    {
+      fprintf( stderr, "Use: %s [-j nworkers] [-o output_%%s.txt] command "
+	       "[args...] -- input.csv... > summary.txt\n", argv[0] );
+      fprintf( stderr, "[%s]\n", CODE_MOD_DATE );
+      exit(EXIT_FAILURE);
+    }
+  /* Room for the input name and the terminating NULL */
+  if( (cmd = calloc( ncmd+2, sizeof(char *) )) == NULL ||
+      (inArg = calloc( ncmd, sizeof(int) )) == NULL ||
+      (job = calloc( njobs, sizeof(JOB) )) == NULL )
+    {
+      perror( argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  memcpy( cmd, argv+optind, ncmd*sizeof(char *) );
+  for( nin = 0, i = 0; i < ncmd; i++ )
+    if( strcmp( cmd[i], "{}" ) == 0 ) inArg[nin++] = i;
+  if( nin == 0 )
+    { /* Input first; getopt() permutes it past any options */
+      inArg[nin++] = 1;
+      memmove( cmd+2, cmd+1, (ncmd-1)*sizeof(char *) );
+      ncmd++;
+    }
+
+  /* Check the inputs and name the outputs */
+  for( total = 0, i = 0; i < njobs; i++ )
+    {
+      job[i].input = argv[argc-njobs+i];
+      if( stat( job[i].input, &st ) )
+	{
+	  perror( job[i].input );
+	  exit(EXIT_FAILURE);
+	}
+      job[i].size = st.st_size;
+      total += st.st_size;
+      base = (base = strrchr( job[i].input, '/' )) ? base+1 : job[i].input;
+      if( (stem = strdup( base )) == NULL )
+	{
+	  perror( argv[0] );
+	  exit(EXIT_FAILURE);
+	}
+      if( (dot = strrchr( stem, '.' )) && strcmp( dot, ".csv" ) == 0 )
+	stem[dot-stem] = '\0';
+      job[i].output = houtName( outName, stem );
+      free( stem );
+    }
+  /* Two commands writing one output would truncate each other's */
+  if( (byName = malloc( njobs*sizeof(JOB *) )) == NULL )
+    {
+      perror( argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  for( i = 0; i < njobs; i++ ) byName[i] = &job[i];
+  qsort( byName, njobs, sizeof(JOB *), cmpOutput );
+  for( nfail = 0, i = 1; i < njobs; i++ )
+    if( strcmp( byName[i-1]->output, byName[i]->output ) == 0 )
+      {
+	fprintf( stderr, "%s: %s and %s both write %s\n", argv[0],
+		 byName[i-1]->input, byName[i]->input, byName[i]->output );
+	nfail++;
+      }
+  free( byName );
+  if( nfail ) exit(EXIT_FAILURE);
+  qsort( job, njobs, sizeof(JOB), cmpSize );
+
+  /* Keep nworkers jobs running until all are done */
+  printf( "# %s", argv[0] );
+  for( i = 1; i < argc; i++ ) printf( " %s", argv[i] );
+  printf( "\n# status    seconds     MB/s  input -> output\n" );
+  fflush( stdout );
+  t0 = now();
+  nfail = 0;
+  for( running = next = 0; running > 0 || next < njobs; )
+    {
+      while( running < nworkers && next < njobs )
+	{
+	  job[next].pid = startJob( &job[next], cmd, ncmd, inArg, nin );
+	  next++;
+	  running++;
+	}
+      if( (pid = wait( &c )) < 0 )
+	{
+	  perror( "wait" );
+	  exit(EXIT_FAILURE);
+	}
+      for( i = 0; i < next && job[i].pid != pid; i++ )
+	;
+      if( i == next ) continue; /* Not one of ours */
+      running--;
+      job[i].status = c;
+      job[i].secs = now()-job[i].start;
+      if( WIFEXITED(c) && WEXITSTATUS(c) == EXIT_SUCCESS )
+	printf( "ok       " );
+      else
+	{
+	  nfail++;
+	  if( WIFEXITED(c) ) printf( "exit %-4d", WEXITSTATUS(c) );
+	  else printf( "signal %-2d", WIFSIGNALED(c) ? WTERMSIG(c) : 0 );
+	}
+      printf( " %9.3f %8.1f  %s -> %s\n", job[i].secs, job[i].size/1e6/
+	      (job[i].secs > 0.0 ? job[i].secs : 1e-9), job[i].input,
+	      job[i].output );
+      fflush( stdout );
+    }
+  secs = now()-t0;
+  printf( "# %d files, %d ok, %d failed, %.3f s, %.1f MB/s\n", njobs,
+	  njobs-nfail, nfail, secs, total/1e6/(secs > 0.0 ? secs : 1e-9) );
+
+  for( i = 0; i < njobs; i++ ) free( job[i].output );
+  free( job );
+  free( cmd );
+  free( inArg );
+  exit(nfail ? EXIT_FAILURE : EXIT_SUCCESS);
+} /* main */
+
+/**
+   qsort() comparison putting the largest input first.
+*/
+int cmpSize( const void *a, const void *b )
+{
+  const JOB *ja = a, *jb = b;
+
+  return (ja->size < jb->size) - (ja->size > jb->size);
+} /* cmpSize */
+
+/**
+   qsort() comparison of JOB pointers by output name.
+*/
+int cmpOutput( const void *a, const void *b )
+{
+  const JOB *ja = *(const JOB * const *) a, *jb = *(const JOB * const *) b;
+
+  return strcmp( ja->output, jb->output );
+} /* cmpOutput */
+
+/**
+   Start the command on one input, with its standard output going to the
+   job's output file.
+   @param[in,out] job Job to start; its start time is set.
+   @param[in,out] cmd Command and arguments, NULL terminated.
+   @param[in] ncmd Number of entries in @a cmd.
+   @param[in] inArg Indices in @a cmd of the input file name.
+   @param[in] nin Number of indices in @a inArg.
+   @return Worker process ID.  Exits if the process cannot be created.
+*/
+pid_t startJob( JOB *job, char **cmd, int ncmd, const int *inArg,
+		int nin )
+{
+  pid_t pid;
+  int fd, i;
+
+  for( i = 0; i < nin; i++ ) cmd[inArg[i]] = (char *) job->input;
+  cmd[ncmd] = NULL;
+  fflush( stdout );
+  job->start = now();
+  if( (pid = fork()) < 0 )
+    {
+      perror( "fork" );
+      exit(EXIT_FAILURE);
+    }
+  if( pid == 0 )
+    { /* Worker */
+      if( (fd = open( job->output, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) < 0 )
+	{
+	  perror( job->output );
+	  _exit(EXIT_FAILURE);
+	}
+      dup2( fd, STDOUT_FILENO );
+      close( fd );
+      execvp( cmd[0], cmd );
+      perror( cmd[0] );
+      _exit(127);
+    }
+  return pid;
+} /* startJob */
+
+/**
+   Monotonic wall clock.
+   @return Time in seconds.
+*/
+double now( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec+1e-9*ts.tv_nsec;
+} /* now */
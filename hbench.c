@@ -0,0 +1,531 @@
+/** @file hbench.c
+    @brief
+    Benchmark the Harbor record parsers and the hgps and hsensor programs.
+
+    @details
+    The hbench program generates synthetic Harbor GPS and sensor CSV files
+    in the formats hgps and hsensor parse, with configurable size, comment
+    density, malformed-record ratio and low-satellite ratio.  It first
+    times the record parsers alone, once with the original sscanf()
+    formats and once with the hcsv field scanner, and compares the parsed
+    values bit for bit so any difference between the two parsers is
+    reported as an error.  It then runs hgps and hsensor on the generated
+    files in raw and averaging mode and reports MB/s and records/s (input
+    lines per second) for each, the best of several runs.
+    @verbatim
+    Compile: gcc -Wall -O2 -o hbench hbench.c hcsv.c
+    Use: hbench [-n nrecs] [-c comments] [-m malformed] [-l lowsats]
+                [-r repeats] [-j nthreads] [-s seed] [-d dir]
+                [hgps_path hsensor_path] > results.txt
+         hbench -g gps|sensor [-n nrecs] [-c comments] [-m malformed]
+                [-l lowsats] [-s seed] > data.csv
+    @endverbatim
+    @arg @c -n @c nrecs is the number of lines in each generated file,
+    default 1000000
+    @arg @c -c @c comments is the fraction of lines that are status
+    comments, default 0.01
+    @arg @c -m @c malformed is the fraction of lines that are truncated
+    records, default 0.001
+    @arg @c -l @c lowsats is the fraction of GPS records with fewer than 4
+    satellites, default 0.05
+    @arg @c -r @c repeats is the number of timed runs of each program,
+    default 3
+    @arg @c -j @c nthreads also times hsensor with that many threads
+    @arg @c -s @c seed seeds the generator, default 1
+    @arg @c -d @c dir keeps the generated files in an existing directory
+    instead of a temporary one
+    @arg @c -g writes one generated file to stdout and exits
+    @arg @c hgps_path and @c hsensor_path are the programs to time, default
+    ./hgps and ./hsensor; a program that cannot be run is skipped
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added the file generator and hgps/hsensor timing.
+    @endverbatim
+*/
+/**
+   Code modification date
+*/
+#define CODE_MOD_DATE "Mod_Date:2026-Oct-14"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "hcsv.h"
+
+/**
+   Length of each synthetic record buffer.
+*/
+#define RECLEN 256
+
+/**
+   Number of values in one parsed record, enough for either format.
+*/
+#define NVALS 18
+
+/**
+   Number of records used to time the parsers alone.
+*/
+#define NPARSE 100000
+
+/**
+   Kind of generated file.
+*/
+enum { GEN_GPS, GEN_SENSOR };
+
+/**
+   Settings for the file generator.
+*/
+typedef struct
+{
+  long nrecs;       ///< Lines per file
+  double comments;  ///< Fraction of comment lines
+  double malformed; ///< Fraction of truncated records
+  double lowSats;   ///< Fraction of GPS records with fewer than 4 satellites
+} GENOPTS;
+
+/**
+   Parser under test: convert one record into an array of 32-bit values.
+*/
+typedef int (*PARSEFN)( const char *str, const char *end, float *v );
+
+static int genGPS( char *buf, long i, int lowSats );
+static int genSensor( char *buf, long i );
+static long writeData( const char *path, int kind, const GENOPTS *opt );
+static double uniform( void );
+static void benchParsers( void );
+static void timeTool( const char *label, const char *input, long nlines,
+		      int nrepeats, const char *path, ... );
+static int scanfGPS( const char *str, const char *end, float *v );
+static int hcsvGPS( const char *str, const char *end, float *v );
+static int scanfSensor( const char *str, const char *end, float *v );
+static int hcsvSensor( const char *str, const char *end, float *v );
+static double runParser( PARSEFN fn, char *recs, int nrecs, float *vals );
+static double now( void );
+
+int main( int argc, char **argv )
+{
+  int nrepeats, nthreads, gen, c;
+  const char *dir, *hgps, *hsensor;
+  char tmpDir[] = "/tmp/hbenchXXXXXX", gpsName[4096], sensorName[4096];
+  char jopt[16];
+  long ngps, nsensor;
+  GENOPTS opt;
+
+  opt.nrecs = 1000000;
+  opt.comments = 0.01;
+  opt.malformed = 0.001;
+  opt.lowSats = 0.05;
+  nrepeats = 3;
+  nthreads = 1;
+  gen = -1;
+  dir = NULL;
+  srand( 1 );
+  while( (c = getopt( argc, argv, "n:c:m:l:r:j:s:d:g:" )) != -1 )
+    switch( c )
+      {
+      case 'n':
+	opt.nrecs = atol( optarg );
+	break;
+      case 'c':
+	opt.comments = atof( optarg );
+	break;
+      case 'm':
+	opt.malformed = atof( optarg );
+	break;
+      case 'l':
+	opt.lowSats = atof( optarg );
+	break;
+      case 'r':
+	nrepeats = atoi( optarg );
+	break;
+      case 'j':
+	nthreads = atoi( optarg );
+	break;
+      case 's':
+	srand( atoi( optarg ) );
+	break;
+      case 'd':
+	dir = optarg;
+	break;
+      case 'g':
+	if( strcmp( optarg, "gps" ) == 0 ) gen = GEN_GPS;
+	else if( strcmp( optarg, "sensor" ) == 0 ) gen = GEN_SENSOR;
+	else nrepeats = 0;
+	break;
+      default:
+	nrepeats = 0;
+	break;
+      }
+  if( nrepeats < 1 || opt.nrecs < 1 || nthreads < 1 ||
+      (argc-optind != 0 && argc-optind != 2) )
+    {
+      fprintf( stderr, "Use: %s [-n nrecs] [-c comments] [-m malformed] "
+	       "[-l lowsats] [-r repeats] [-j nthreads] [-s seed] [-d dir] "
+	       "[hgps_path hsensor_path] > results.txt\n"
+	       "     %s -g gps|sensor [-n nrecs] [-c comments] [-m malformed] "
+	       "[-l lowsats] [-s seed] > data.csv\n", argv[0], argv[0] );
+      fprintf( stderr, "[%s]\n", CODE_MOD_DATE );
+      exit(EXIT_FAILURE);
+    }
+  if( gen >= 0 )
+    { /* Generator only */
+      writeData( NULL, gen, &opt );
+      exit(EXIT_SUCCESS);
+    }
+  hgps = argc-optind == 2 ? argv[optind] : "./hgps";
+  hsensor = argc-optind == 2 ? argv[optind+1] : "./hsensor";
+
+  if( dir == NULL && (dir = mkdtemp( tmpDir )) == NULL )
+    {
+      perror( tmpDir );
+      exit(EXIT_FAILURE);
+    }
+  snprintf( gpsName, sizeof(gpsName), "%s/gps.csv", dir );
+  snprintf( sensorName, sizeof(sensorName), "%s/sensor.csv", dir );
+  ngps = writeData( gpsName, GEN_GPS, &opt );
+  nsensor = writeData( sensorName, GEN_SENSOR, &opt );
+
+  printf( "# %s", argv[0] );
+  for( c = 1; c < argc; c++ ) printf( " %s", argv[c] );
+  printf( "\n" );
+  benchParsers();
+  printf( "# program             seconds     MB/s    records/s\n" );
+  timeTool( "hgps-raw", gpsName, ngps, nrepeats,
+	    hgps, gpsName, "0", "0", NULL );
+  timeTool( "hgps-avg10", gpsName, ngps, nrepeats,
+	    hgps, gpsName, "10", "4", NULL );
+  timeTool( "hsensor-raw", sensorName, nsensor, nrepeats,
+	    hsensor, sensorName, "0", NULL );
+  timeTool( "hsensor-avg10", sensorName, nsensor, nrepeats,
+	    hsensor, sensorName, "10", NULL );
+  if( nthreads > 1 )
+    {
+      snprintf( jopt, sizeof(jopt), "-j%d", nthreads );
+      timeTool( "hsensor-raw-j", sensorName, nsensor, nrepeats,
+		hsensor, jopt, sensorName, "0", NULL );
+      timeTool( "hsensor-avg10-j", sensorName, nsensor, nrepeats,
+		hsensor, jopt, sensorName, "10", NULL );
+    }
+
+  if( dir == tmpDir )
+    {
+      unlink( gpsName );
+      unlink( sensorName );
+      rmdir( tmpDir );
+    }
+  exit(EXIT_SUCCESS);
+} /* main */
+
+/**
+   Uniform random number.
+   @return Value in [0,1].
+*/
+static double uniform( void )
+{
+  return rand()/(double) RAND_MAX;
+} /* uniform */
+
+/**
+   Build one GPS record as written by the Harbor payload, one per second
+   starting at 23:00:00 so the averages cross midnight.
+   @param[out] buf Record, at least RECLEN bytes.
+   @param[in] i Record number.
+   @param[in] lowSats Nonzero for fewer than 4 satellites in view.
+   @return Length of the record, including the newline.
+*/
+static int genGPS( char *buf, long i, int lowSats )
+{
+  long secs = 23*3600L+i;
+
+  return snprintf( buf, RECLEN,
+		   "%.1f,%02ld/11/14,%02ld:%02ld:%02ld,%.7f,%.7f,%.1f,%d\n",
+		   1.0*i, 14+(secs/86400)%15, (secs/3600)%24, (secs/60)%60,
+		   secs%60, 41.0+uniform(), -112.0+uniform(),
+		   1400.0+30000.0*uniform(),
+		   lowSats ? rand()%4 : 4+rand()%9 );
+} /* genGPS */
+
+/**
+   Build one sensor record as written by the Harbor payload, ten per
+   second.
+   @param[out] buf Record, at least RECLEN bytes.
+   @param[in] i Record number.
+   @return Length of the record, including the newline.
+*/
+static int genSensor( char *buf, long i )
+{
+  char *r = buf;
+  int j;
+
+  r += sprintf( r, "%.1f,%.2f", 0.1*i, 20.0*uniform() );
+  for( j = 2; j < NVALS; j++ )
+    if( j%3 ) r += sprintf( r, ",%d", rand()%8192-4096 );
+    else r += sprintf( r, ",%.3f", 1000.0*uniform()-500.0 );
+  r += sprintf( r, "\n" );
+  return r-buf;
+} /* genSensor */
+
+/**
+   Write one generated file.  Each line is a status comment, a truncated
+   record or a complete record, in the proportions given.
+   @param[in] path File to create, or NULL for standard output.
+   @param[in] kind GEN_GPS or GEN_SENSOR.
+   @param[in] opt Generator settings.
+   @return Number of lines written.  Exits on error.
+*/
+static long writeData( const char *path, int kind, const GENOPTS *opt )
+{
+  FILE *fp;
+  char buf[RECLEN], *cut;
+  long i, nrec;
+  double u;
+  int len;
+
+  if( path == NULL ) fp = stdout;
+  else if( (fp = fopen( path, "w" )) == NULL )
+    {
+      perror( path );
+      exit(EXIT_FAILURE);
+    }
+  for( i = nrec = 0; i < opt->nrecs; i++ )
+    {
+      u = uniform();
+      if( u < opt->comments )
+	{
+	  fprintf( fp, "Status: %s lock %ld ok\n",
+		   kind == GEN_GPS ? "GPS" : "sensor", i );
+	  continue;
+	}
+      if( kind == GEN_GPS )
+	len = genGPS( buf, nrec++, uniform() < opt->lowSats );
+      else
+	len = genSensor( buf, nrec++ );
+      if( u < opt->comments+opt->malformed &&
+	  (cut = strchr( buf+len/2, ',' )) != NULL )
+	{ /* Truncated record */
+	  strcpy( cut, "\n" );
+	  len = cut+1-buf;
+	}
+      fwrite( buf, 1, len, fp );
+    }
+  if( path && fclose( fp ) )
+    {
+      perror( path );
+      exit(EXIT_FAILURE);
+    }
+  return opt->nrecs;
+} /* writeData */
+
+/**
+   Time the parsers alone on NPARSE records of each type held in memory.
+*/
+static void benchParsers( void )
+{
+  char *gps, *sensor;
+  float *v1, *v2;
+  double t1, t2;
+  int i;
+
+  gps = malloc( (size_t) NPARSE*RECLEN );
+  sensor = malloc( (size_t) NPARSE*RECLEN );
+  v1 = malloc( (size_t) NPARSE*NVALS*sizeof(float) );
+  v2 = malloc( (size_t) NPARSE*NVALS*sizeof(float) );
+  if( !gps || !sensor || !v1 || !v2 )
+    {
+      perror( "benchParsers" );
+      exit(EXIT_FAILURE);
+    }
+  for( i = 0; i < NPARSE; i++ )
+    {
+      genGPS( gps+(size_t) i*RECLEN, i, 0 );
+      genSensor( sensor+(size_t) i*RECLEN, i );
+    }
+
+  printf( "# parser        records/s\n" );
+  t1 = runParser( scanfGPS, gps, NPARSE, v1 );
+  t2 = runParser( hcsvGPS, gps, NPARSE, v2 );
+  printf( "gps-sscanf    %12.0f\n", NPARSE/t1 );
+  printf( "gps-hcsv      %12.0f %5.1fx\n", NPARSE/t2, t1/t2 );
+  if( memcmp( v1, v2, (size_t) NPARSE*NVALS*sizeof(float) ) )
+    fprintf( stderr, "GPS parsers disagree\n" );
+  t1 = runParser( scanfSensor, sensor, NPARSE, v1 );
+  t2 = runParser( hcsvSensor, sensor, NPARSE, v2 );
+  printf( "sensor-sscanf %12.0f\n", NPARSE/t1 );
+  printf( "sensor-hcsv   %12.0f %5.1fx\n", NPARSE/t2, t1/t2 );
+  if( memcmp( v1, v2, (size_t) NPARSE*NVALS*sizeof(float) ) )
+    fprintf( stderr, "Sensor parsers disagree\n" );
+
+  free( gps );
+  free( sensor );
+  free( v1 );
+  free( v2 );
+} /* benchParsers */
+
+/**
+   Run a program several times with its output discarded and report the
+   best time.  A program that cannot be run, or fails, is reported and
+   skipped.
+   @param[in] label Name for the results line.
+   @param[in] input Input file named in the arguments, for its size.
+   @param[in] nlines Lines in the input file.
+   @param[in] nrepeats Number of runs.
+   @param[in] path Program to run, followed by its arguments and NULL.
+*/
+static void timeTool( const char *label, const char *input, long nlines,
+		      int nrepeats, const char *path, ... )
+{
+  char *argv[16];
+  va_list ap;
+  struct stat st;
+  double t, best;
+  pid_t pid;
+  int i, fd, status;
+
+  va_start( ap, path );
+  argv[0] = (char *) path;
+  for( i = 1; i < 15 && (argv[i] = va_arg( ap, char * )) != NULL; i++ )
+    ;
+  argv[i] = NULL;
+  va_end( ap );
+  if( access( argv[0], X_OK ) )
+    {
+      printf( "# %s: %s not found, skipped\n", label, argv[0] );
+      return;
+    }
+  if( stat( input, &st ) )
+    {
+      perror( input );
+      return;
+    }
+  for( best = -1.0, i = 0; i < nrepeats; i++ )
+    {
+      t = now();
+      if( (pid = fork()) < 0 )
+	{
+	  perror( "fork" );
+	  exit(EXIT_FAILURE);
+	}
+      if( pid == 0 )
+	{ /* Child: output to /dev/null */
+	  if( (fd = open( "/dev/null", O_WRONLY )) >= 0 )
+	    dup2( fd, STDOUT_FILENO );
+	  execv( argv[0], argv );
+	  perror( argv[0] );
+	  _exit(127);
+	}
+      if( waitpid( pid, &status, 0 ) < 0 || !WIFEXITED(status) ||
+	  WEXITSTATUS(status) != EXIT_SUCCESS )
+	{
+	  printf( "# %s: %s failed, skipped\n", label, argv[0] );
+	  return;
+	}
+      t = now()-t;
+      if( best < 0.0 || t < best ) best = t;
+    }
+  printf( "%-18s %9.3f %8.1f %12.0f\n", label, best, st.st_size/1e6/best,
+	  nlines/best );
+} /* timeTool */
+
+/**
+   Parse every record with one parser.
+   @param[in] fn Parser to time.
+   @param[in] recs Records, RECLEN bytes apart.
+   @param[in] nrecs Number of records.
+   @param[out] vals Parsed values, NVALS per record.
+   @return Elapsed time in seconds.
+*/
+static double runParser( PARSEFN fn, char *recs, int nrecs, float *vals )
+{
+  double t;
+  char *r;
+  int i;
+
+  memset( vals, 0, (size_t) nrecs*NVALS*sizeof(float) );
+  t = now();
+  for( i = 0; i < nrecs; i++ )
+    {
+      r = recs+(size_t) i*RECLEN;
+      fn( r, r+strlen( r ), vals+(size_t) i*NVALS );
+    }
+  return now()-t;
+} /* runParser */
+
+/**
+   GPS record with the original hgps sscanf() format.  Integer fields are
+   kept in the float-sized slots of @a v.
+*/
+static int scanfGPS( const char *str, const char *end, float *v )
+{
+  int *iv = (int *) v;
+
+  return sscanf( str, "%f,%d/%d/%d,%d:%d:%d,%f,%f,%f,%d", &v[0], &iv[1],
+		 &iv[2], &iv[3], &iv[4], &iv[5], &iv[6], &v[7], &v[8],
+		 &v[9], &iv[10] );
+} /* scanfGPS */
+
+/**
+   GPS record with the hcsv scanner, in the same order as scanfGPS().
+*/
+static int hcsvGPS( const char *str, const char *end, float *v )
+{
+  static const char sep[] = "\0,//,::,,,,";
+  static const char isInt[11] = { 0, 1, 1, 1, 1, 1, 1, 0, 0, 0, 1 };
+  const char *p = str;
+  int n;
+
+  for( n = 0; n < 11; n++ )
+    {
+      if( n > 0 && !hcsvSep( &p, end, sep[n] ) ) break;
+      if( isInt[n] ? !hcsvInt( &p, end, (int *) &v[n] ) :
+	  !hcsvFloat( &p, end, &v[n] ) ) break;
+    }
+  return n;
+} /* hcsvGPS */
+
+/**
+   Sensor record with the original hsensor sscanf() format.
+*/
+static int scanfSensor( const char *str, const char *end, float *v )
+{
+  return sscanf( str, "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f",
+		 &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7],
+		 &v[8], &v[9], &v[10], &v[11], &v[12], &v[13], &v[14],
+		 &v[15], &v[16], &v[17] );
+} /* scanfSensor */
+
+/**
+   Sensor record with the hcsv scanner.
+*/
+static int hcsvSensor( const char *str, const char *end, float *v )
+{
+  const char *p = str;
+  int n;
+
+  for( n = 0; n < NVALS; n++ )
+    {
+      if( n > 0 && !hcsvSep( &p, end, ',' ) ) break;
+      if( !hcsvFloat( &p, end, &v[n] ) ) break;
+    }
+  return n;
+} /* hcsvSensor */
+
+/**
+   Monotonic wall clock.
+   @return Time in seconds.
+*/
+static double now( void )
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec+1e-9*ts.tv_nsec;
+} /* now */
@@ -0,0 +1,214 @@
+/** @file hcal.c
+    @brief
+    Engineering unit calibration of Harbor sensor records.
+
+    @details
+    See hcal.h for the calibration file format.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Read lines of any length with getline().
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "hcal.h"
+
+/**
+   Number of parameters of a thermistor curve.
+*/
+#define HCAL_NTHERM 5
+
+/**
+   Kelvin at 0 degC.
+*/
+#define HCAL_KELVIN 273.15
+
+static int parseLine( HCAL *cal, char *buf );
+static float *thermTable( const double *par );
+
+/**
+   Read and compile a calibration file.
+   @param[in] path Calibration file.
+   @param[out] line Line number of the bad line if errno is EINVAL, else 0.
+   @return Calibration, or NULL with errno set: EINVAL for a bad line,
+   such as an unknown field or curve, a field given twice or a bad
+   parameter.
+*/
+HCAL *hcalOpen( const char *path, int *line )
+{
+  char *buf;
+  size_t size;
+  HCAL *cal;
+  FILE *fp;
+  int i, n;
+
+  *line = 0;
+  if( (cal = calloc( 1, sizeof(HCAL) )) == NULL ) return NULL;
+  if( (fp = fopen( path, "r" )) == NULL )
+    {
+      free( cal );
+      return NULL;
+    }
+  buf = NULL;
+  size = 0;
+  for( cal->deg = 1; getline( &buf, &size, fp ) >= 0; )
+    {
+      (*line)++;
+      if( parseLine( cal, buf ) )
+	{
+	  free( buf );
+	  fclose( fp );
+	  hcalClose( cal );
+	  errno = EINVAL;
+	  return NULL;
+	}
+    }
+  free( buf );
+  fclose( fp );
+  *line = 0;
+  /* Vectors holding polynomial lanes */
+  for( i = 0; i < SENSOR_NLANES/4; i++ )
+    for( n = 0; n < 4; n++ )
+      if( cal->mask[i][n] )
+	{
+	  cal->vec[cal->nvec++] = i;
+	  break;
+	}
+  return cal;
+} /* hcalOpen */
+
+/**
+   Compile one line of a calibration file into a calibration.
+   @param[in,out] cal Calibration.
+   @param[in,out] buf Line, changed by strtok().
+   @return 0 if the line is good or empty, -1 if not.
+*/
+static int parseLine( HCAL *cal, char *buf )
+{
+  double par[HCAL_MAXDEG+1];
+  char *name, *units, *curve, *tok, *end;
+  int f, npar, d;
+
+  if( (tok = strchr( buf, '#' )) != NULL ) *tok = '\0';
+  if( (name = strtok( buf, " \t\r\n" )) == NULL ) return 0; /* Empty */
+  units = strtok( NULL, " \t\r\n" );
+  curve = strtok( NULL, " \t\r\n" );
+  if( units == NULL || curve == NULL || strlen( units ) >= 16 ) return -1;
+  for( f = 1; f < SENSOR_NFIELDS; f++ ) /* Not tsecs */
+    if( strcmp( sensorNames[f], name ) == 0 ) break;
+  if( f == SENSOR_NFIELDS || cal->units[f][0] ) return -1;
+  for( npar = 0; (tok = strtok( NULL, " \t\r\n" )) != NULL; npar++ )
+    {
+      if( npar > HCAL_MAXDEG ) return -1;
+      par[npar] = strtod( tok, &end );
+      if( *end || !isfinite( par[npar] ) ) return -1;
+    }
+  if( strcmp( curve, "linear" ) == 0 && npar == 2 )
+    { /* gain offset */
+      cal->coef[1][f/4][f%4] = par[0];
+      cal->coef[0][f/4][f%4] = par[1];
+    }
+  else if( strcmp( curve, "poly" ) == 0 && npar > 0 )
+    {
+      for( d = 0; d < npar; d++ ) cal->coef[d][f/4][f%4] = par[d];
+      if( npar-1 > cal->deg ) cal->deg = npar-1;
+    }
+  else if( strcmp( curve, "thermistor" ) == 0 && npar == HCAL_NTHERM )
+    {
+      if( par[0] <= 0.0 || par[1] <= -HCAL_KELVIN || par[2] <= 0.0 ||
+	  par[3] <= 0.0 || par[4] < 2.0 || par[4] > HCAL_MAXLUT ||
+	  par[4] != floor( par[4] ) ||
+	  (cal->lut[cal->nlut].table = thermTable( par )) == NULL )
+	return -1;
+      cal->lut[cal->nlut].field = f;
+      cal->lut[cal->nlut++].size = par[4]+1;
+    }
+  else
+    return -1;
+  if( strcmp( curve, "thermistor" ) != 0 ) cal->mask[f/4][f%4] = -1;
+  strcpy( cal->units[f], units );
+  return 0;
+} /* parseLine */
+
+/**
+   Make the lookup table of a thermistor curve.
+   @param[in] par r0, t0, beta, rfixed and fullscale.
+   @return Table of fullscale+1 values, or NULL if memory runs out.
+*/
+static float *thermTable( const double *par )
+{
+  double x, r, full;
+  float *table;
+  int n, size;
+
+  full = par[4];
+  size = full+1;
+  if( (table = malloc( size*sizeof(float) )) == NULL ) return NULL;
+  for( n = 0; n < size; n++ )
+    {
+      /* Half a count in from the ends, where the resistance is 0 or
+	 infinite */
+      x = n == 0 ? 0.5 : n == size-1 ? full-0.5 : n;
+      r = par[3]*x/(full-x);
+      table[n] = 1.0/(1.0/(par[1]+HCAL_KELVIN)+log( r/par[0] )/par[2])-
+	HCAL_KELVIN;
+    }
+  return table;
+} /* thermTable */
+
+/**
+   Convert the calibrated fields of a record to engineering units.
+   @param[in] cal Calibration.
+   @param[in,out] raw Record.
+*/
+void hcalApply( const HCAL *cal, SENSORDATA *raw )
+{
+  SENSORVEC x, y;
+  const HCALLUT *l;
+  float v, t;
+  int i, n, d, k;
+
+  for( n = 0; n < cal->nvec; n++ )
+    { /* Horner's rule on the whole vector, keeping the other lanes */
+      i = cal->vec[n];
+      x = raw->vec[i];
+      y = cal->coef[cal->deg][i];
+      for( d = cal->deg-1; d >= 0; d-- ) y = y*x+cal->coef[d][i];
+      raw->vec[i] = (SENSORVEC) (((HCALMASK) y & cal->mask[i]) |
+				 ((HCALMASK) x & ~cal->mask[i]));
+    }
+  for( n = 0; n < cal->nlut; n++ )
+    {
+      l = &cal->lut[n];
+      v = raw->v[l->field];
+      if( isnan( v ) ) continue;
+      if( v <= 0.0f ) raw->v[l->field] = l->table[0];
+      else if( v >= l->size-1 ) raw->v[l->field] = l->table[l->size-1];
+      else
+	{ /* Interpolate between whole counts */
+	  k = v;
+	  t = v-k;
+	  raw->v[l->field] = l->table[k]+t*(l->table[k+1]-l->table[k]);
+	}
+    }
+} /* hcalApply */
+
+/**
+   Free a calibration.
+   @param[in] cal Calibration, or NULL.
+*/
+void hcalClose( HCAL *cal )
+{
+  int n;
+
+  if( cal == NULL ) return;
+  for( n = 0; n < cal->nlut; n++ ) free( cal->lut[n].table );
+  free( cal );
+} /* hcalClose */
@@ -0,0 +1,88 @@
+/** @file hcal.h
+    @brief
+    Engineering unit calibration of Harbor sensor records.
+
+    @details
+    A calibration file gives the conversion of some sensor fields from
+    ADC counts to engineering units, one field per line:
+    @verbatim
+    # name  units  curve       parameters
+    a1x     g      linear      gain offset
+    humid   %RH    poly        c0 c1 c2 ...
+    tmpx    degC   thermistor  r0 t0 beta rfixed fullscale
+    @endverbatim
+    A linear curve is gain*x+offset, a polynomial c0+c1*x+c2*x^2..., up to
+    degree HCAL_MAXDEG.  A thermistor curve is for a thermistor from the
+    ADC input to ground with a fixed resistor @a rfixed to the reference,
+    read as @a fullscale counts at the reference: the resistance is
+    rfixed*x/(fullscale-x), and the temperature in degC follows the beta
+    equation with resistance @a r0 at @a t0 degC.  Text after '#' is a
+    comment.  tsecs cannot be calibrated, and the other fields not named
+    are left in counts.
+
+    hcalOpen() compiles the file once: the linear and polynomial curves
+    into per-lane coefficient vectors, evaluated by Horner's rule on whole
+    SENSORVEC vectors of the record, and each thermistor curve into a
+    lookup table of its value at every whole count, interpolated
+    linearly, with counts outside 0 to fullscale clamped.  Converting a
+    record is then a few vector multiply-adds and one table lookup per
+    thermistor.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#ifndef HCAL_H
+#define HCAL_H
+#include "hrec.h"
+
+/**
+   Highest polynomial degree.
+*/
+#define HCAL_MAXDEG 7
+
+/**
+   Largest thermistor fullscale count.
+*/
+#define HCAL_MAXLUT 65535
+
+/**
+   Four lane masks, all ones for a calibrated lane.
+*/
+typedef int HCALMASK __attribute__((vector_size(16)));
+
+/**
+   Lookup table of one field.
+*/
+typedef struct
+{
+  int field;    ///< Field converted
+  int size;     ///< Entries, fullscale+1
+  float *table; ///< Value at each whole count
+} HCALLUT;
+
+/**
+   Compiled calibration.  Use hcalOpen() to create one.
+*/
+typedef struct
+{
+  int deg;                 ///< Highest polynomial degree used
+  int nvec;                ///< Number of vectors with polynomial lanes
+  int vec[SENSOR_NLANES/4]; ///< Vectors with polynomial lanes
+  SENSORVEC coef[HCAL_MAXDEG+1][SENSOR_NLANES/4]; ///< Coefficient of
+                           ///< each power, by lane
+  HCALMASK mask[SENSOR_NLANES/4]; ///< Polynomial lanes
+  int nlut;                ///< Number of lookup tables
+  HCALLUT lut[SENSOR_NFIELDS]; ///< Lookup tables
+  char units[SENSOR_NFIELDS][16]; ///< Units of each calibrated field,
+                           ///< empty if not calibrated
+} HCAL;
+
+HCAL *hcalOpen( const char *path, int *line );
+void hcalApply( const HCAL *cal, SENSORDATA *raw );
+void hcalClose( HCAL *cal );
+
+#endif /* HCAL_H */
@@ -0,0 +1,199 @@
+/** @file hckpt.c
+    @brief
+    Checkpoints for resuming a Harbor reduction where the last run ended.
+
+    @details
+    The checkpoint is written to a temporary file and renamed into place,
+    as the hidx index is, so a run that dies while saving leaves the old
+    checkpoint, which still matches the old outputs.  CRCs come from zlib
+    (-lz).
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added hckptHashData().
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "hckpt.h"
+
+/**
+   Fingerprint the reduced part of a mapped input.
+   @param[in] rd Mapped reader.
+   @param[in] offset End of the reduced part.
+   @param[out] head CRC-32 of the first HCKPT_PROBE bytes, or all of them.
+   @param[out] tail CRC-32 of the HCKPT_PROBE bytes before @a offset.
+*/
+static void fingerprint( const HREADER *rd, size_t offset, uint32_t *head,
+			 uint32_t *tail )
+{
+  const Bytef *p = (const Bytef *) rd->map;
+  size_t n;
+
+  n = offset < HCKPT_PROBE ? offset : HCKPT_PROBE;
+  *head = crc32( crc32( 0L, Z_NULL, 0 ), p, n );
+  *tail = crc32( crc32( 0L, Z_NULL, 0 ), p+offset-n, n );
+} /* fingerprint */
+
+/**
+   Add one of the options that the output of a run depends on to a hash,
+   so that a checkpoint is only resumed by a run that would write the
+   same output.  The terminating NUL is hashed too, so "ab", "c" and "a",
+   "bc" hash differently.
+   @param[in] hash Hash of the options so far, 0 for none.
+   @param[in] str Option, in any fixed text form.
+   @return Hash.
+*/
+uint32_t hckptHash( uint32_t hash, const char *str )
+{
+  return crc32( hash, (const Bytef *) str, strlen( str )+1 );
+} /* hckptHash */
+
+/**
+   Add data an option names, such as the contents of a file, to a hash of
+   the options, so that a checkpoint is not resumed after the data have
+   changed under the same name.
+   @param[in] hash Hash of the options so far, 0 for none.
+   @param[in] data Bytes to hash.
+   @param[in] len Number of bytes.
+   @return Hash.
+*/
+uint32_t hckptHashData( uint32_t hash, const void *data, size_t len )
+{
+  return crc32( hash, (const Bytef *) data, len );
+} /* hckptHashData */
+
+/**
+   Find the end of the last complete line of a mapped input.  A run that
+   saves a checkpoint stops there, leaving a line the writer has not
+   finished for the next run.
+   @param[in] rd Mapped reader.
+   @return Offset just past the last newline, or 0 if there is none.
+*/
+size_t hckptWhole( const HREADER *rd )
+{
+  size_t n;
+
+  if( rd->map == NULL ) return 0;
+  for( n = rd->mapSize; n > 0 && rd->map[n-1] != '\n'; n-- )
+    ;
+  return n;
+} /* hckptWhole */
+
+/**
+   Load a checkpoint and check it against the input and options.
+   @param[in] path Checkpoint file name.
+   @param[in] rd Mapped reader of the input.
+   @param[in] config hckptHash() of the options of this run.
+   @param[in] size Bytes of program state expected.
+   @param[out] offset Input bytes already reduced.
+   @return Allocated program state, or NULL with errno set: ENOENT if
+   there is no checkpoint, ESTALE if it is for other input, options or
+   state, or from an input that has since been rewritten.
+*/
+void *hckptLoad( const char *path, const HREADER *rd, uint32_t config,
+		 size_t size, size_t *offset )
+{
+  HCKPTHEADER hdr;
+  struct stat st;
+  uint32_t head, tail;
+  void *state;
+  int fd, err;
+
+  if( (fd = open( path, O_RDONLY )) < 0 ) return NULL;
+  state = NULL;
+  err = ESTALE;
+  if( rd->map && fstat( fd, &st ) == 0 &&
+      read( fd, &hdr, sizeof(hdr) ) == sizeof(hdr) &&
+      memcmp( hdr.magic, HCKPT_MAGIC, sizeof(HCKPT_MAGIC) ) == 0 &&
+      hdr.version == HCKPT_VERSION && hdr.byteOrder == HCKPT_BYTEORDER &&
+      hdr.config == config && hdr.stateSize == size &&
+      (uint64_t) st.st_size == sizeof(hdr)+size &&
+      hdr.offset <= rd->mapSize )
+    {
+      fingerprint( rd, hdr.offset, &head, &tail );
+      if( head == hdr.headCrc && tail == hdr.tailCrc )
+	{
+	  if( (state = malloc( size )) == NULL ) err = ENOMEM;
+	  else if( read( fd, state, size ) != (ssize_t) size )
+	    {
+	      free( state );
+	      state = NULL;
+	    }
+	  else
+	    *offset = hdr.offset;
+	}
+    }
+  close( fd );
+  if( state == NULL ) errno = err;
+  return state;
+} /* hckptLoad */
+
+/**
+   Save a checkpoint, replacing any old one.
+   @param[in] path Checkpoint file name.
+   @param[in] rd Mapped reader of the input.
+   @param[in] offset Input bytes reduced, a line boundary.
+   @param[in] config hckptHash() of the options of this run.
+   @param[in] state Program state.
+   @param[in] size Bytes of program state.
+   @return 0 on success, or -1 with errno set.
+*/
+int hckptSave( const char *path, const HREADER *rd, size_t offset,
+	       uint32_t config, const void *state, size_t size )
+{
+  HCKPTHEADER hdr;
+  char *tmp;
+  int fd, ok, err;
+
+  if( rd->map == NULL || offset > rd->mapSize )
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  if( (tmp = malloc( strlen( path )+8 )) == NULL ) return -1;
+  sprintf( tmp, "%s.XXXXXX", path );
+  if( (fd = mkstemp( tmp )) < 0 )
+    {
+      err = errno;
+      free( tmp );
+      errno = err;
+      return -1;
+    }
+  memset( &hdr, 0, sizeof(hdr) );
+  memcpy( hdr.magic, HCKPT_MAGIC, sizeof(HCKPT_MAGIC) );
+  hdr.version = HCKPT_VERSION;
+  hdr.byteOrder = HCKPT_BYTEORDER;
+  hdr.offset = offset;
+  fingerprint( rd, offset, &hdr.headCrc, &hdr.tailCrc );
+  hdr.config = config;
+  hdr.stateSize = size;
+  ok = write( fd, &hdr, sizeof(hdr) ) == sizeof(hdr) &&
+    write( fd, state, size ) == (ssize_t) size;
+  err = ok ? 0 : errno ? errno : EIO;
+  fchmod( fd, 0644 );
+  if( close( fd ) && ok )
+    {
+      ok = 0;
+      err = errno;
+    }
+  if( ok && rename( tmp, path ) == 0 )
+    {
+      free( tmp );
+      return 0;
+    }
+  if( ok ) err = errno;
+  unlink( tmp );
+  free( tmp );
+  errno = err;
+  return -1;
+} /* hckptSave */
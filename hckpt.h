@@ -0,0 +1,73 @@
+/** @file hckpt.h
+    @brief
+    Checkpoints for resuming a Harbor reduction where the last run ended.
+
+    @details
+    A checkpoint records how far into a mapped input file a run got and
+    the state the program needs to carry on from there, such as the sums
+    of the open averaging periods and the size of each output before the
+    last, partial average was written.  A later run on the same file,
+    grown by appending, loads it, truncates the outputs back to the saved
+    sizes and reduces only the data after the saved offset, giving the
+    output a single run over the whole file would give.
+
+    The input is recognised by CRC-32 fingerprints of the first and of the
+    last HCKPT_PROBE bytes before the offset, so checking costs the same
+    however large the file is, and a file that was rewritten rather than
+    appended to is reduced from the start.  The options the output
+    depends on are hashed with hckptHash(), and the data they name, such
+    as a calibration, with hckptHashData(); they must match too.  The
+    layout, in the byte order of the machine that wrote it, is:
+    @verbatim
+    HCKPTHEADER                48 bytes at offset 0
+    state                      stateSize bytes, private to the program
+    @endverbatim
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added hckptHashData().
+    @endverbatim
+*/
+#ifndef HCKPT_H
+#define HCKPT_H
+#include <stddef.h>
+#include <stdint.h>
+#include "hread.h"
+
+#define HCKPT_MAGIC "HARBCKP"     ///< File magic, NUL padded to 8 bytes
+#define HCKPT_VERSION 1           ///< Format version
+#define HCKPT_BYTEORDER 0x01020304 ///< Byte order mark
+
+/**
+   Bytes of input at each end of the reduced part that are fingerprinted.
+*/
+#define HCKPT_PROBE (64<<10)
+
+/**
+   Checkpoint file header.
+*/
+typedef struct
+{
+  char magic[8];       ///< HCKPT_MAGIC
+  uint32_t version;    ///< HCKPT_VERSION
+  uint32_t byteOrder;  ///< HCKPT_BYTEORDER as written
+  uint64_t offset;     ///< Input bytes reduced, a line boundary
+  uint32_t headCrc;    ///< CRC-32 of the input from the start
+  uint32_t tailCrc;    ///< CRC-32 of the input just before offset
+  uint32_t config;     ///< hckptHash() of the program's options
+  uint32_t stateSize;  ///< Bytes of program state that follow
+  uint64_t spare;      ///< Zero
+} HCKPTHEADER;
+
+uint32_t hckptHash( uint32_t hash, const char *str );
+uint32_t hckptHashData( uint32_t hash, const void *data, size_t len );
+size_t hckptWhole( const HREADER *rd );
+void *hckptLoad( const char *path, const HREADER *rd, uint32_t config,
+		 size_t size, size_t *offset );
+int hckptSave( const char *path, const HREADER *rd, size_t offset,
+	       uint32_t config, const void *state, size_t size );
+
+#endif /* HCKPT_H */
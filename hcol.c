@@ -0,0 +1,288 @@
+/** @file hcol.c
+    @brief
+    Binary columnar output for hgps and hsensor.
+
+    @details
+    Each column is collected in its own buffer.  For a file, full buffers
+    are appended to an unlinked temporary file per column, so memory use
+    stays bounded however many rows are written; hcolClose() then writes
+    the header and copies every column into place.  A memory buffer, used
+    by the parallel modes, just grows until it is merged into a file.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "hcol.h"
+
+/**
+   Size of each column buffer.
+*/
+#define HCOL_BUFSIZE (256<<10)
+
+/**
+   Bytes per value, the same for every column type.
+*/
+#define HCOL_VALSIZE 4
+
+/**
+   Round a file offset up to the column alignment.
+*/
+#define HCOL_ALIGN(x) (((x)+63) & ~(uint64_t) 63)
+
+/**
+   Write a block at a file offset.
+   @return 0 on success, -1 on failure with errno set.
+*/
+static int writeAt( int fd, const char *p, size_t len, off_t off )
+{
+  ssize_t n;
+
+  for( ; len > 0; p += n, len -= n, off += n )
+    if( (n = pwrite( fd, p, len, off )) < 0 )
+      {
+	if( errno != EINTR ) return -1;
+	n = 0;
+      }
+  return 0;
+} /* writeAt */
+
+/**
+   Append bytes to one column, spilling to its temporary file or growing
+   the buffer as needed.
+   @param[in,out] cb Column buffer.
+   @param[in] p Values to append.
+   @param[in] len Number of bytes.
+*/
+static void colWrite( HCOLBUF *cb, const char *p, size_t len )
+{
+  if( cb->size-cb->len < len && cb->fd >= 0 )
+    { /* Spill to the temporary file */
+      if( writeAt( cb->fd, cb->buf, cb->len, lseek( cb->fd, 0, SEEK_END ) ) )
+	{
+	  perror( "hcol" );
+	  exit(EXIT_FAILURE);
+	}
+      cb->len = 0;
+      if( len >= cb->size )
+	{
+	  if( writeAt( cb->fd, p, len, lseek( cb->fd, 0, SEEK_END ) ) )
+	    {
+	      perror( "hcol" );
+	      exit(EXIT_FAILURE);
+	    }
+	  return;
+	}
+    }
+  if( cb->size-cb->len < len )
+    {
+      while( cb->size-cb->len < len ) cb->size *= 2;
+      if( (cb->buf = realloc( cb->buf, cb->size )) == NULL )
+	{
+	  perror( "hcol" );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  memcpy( cb->buf+cb->len, p, len );
+  cb->len += len;
+} /* colWrite */
+
+/**
+   Create columnar output.
+   @param[in] path Output file name, or NULL to keep the columns in memory
+   for a later hcolMerge().
+   @param[in] def Column descriptions; must stay valid until hcolClose().
+   @param[in] ncols Number of columns.
+   @return Columnar output, or NULL with errno set on failure.
+*/
+HCOL *hcolOpen( const char *path, const HCOLDEF *def, int ncols )
+{
+  HCOL *hc;
+  char *tmp;
+  int i, err;
+
+  if( (hc = calloc( 1, sizeof(HCOL) )) == NULL ||
+      (hc->col = calloc( ncols, sizeof(HCOLBUF) )) == NULL )
+    {
+      perror( "hcolOpen" );
+      exit(EXIT_FAILURE);
+    }
+  hc->def = def;
+  hc->ncols = ncols;
+  hc->fd = -1;
+  for( i = 0; i < ncols; i++ )
+    {
+      hc->col[i].fd = -1;
+      hc->col[i].size = HCOL_BUFSIZE;
+      if( (hc->col[i].buf = malloc( HCOL_BUFSIZE )) == NULL )
+	{
+	  perror( "hcolOpen" );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  if( path == NULL ) return hc;
+
+  if( (hc->fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) < 0 ||
+      (tmp = malloc( strlen( path )+8 )) == NULL )
+    {
+      err = errno;
+      hcolClose( hc );
+      errno = err;
+      return NULL;
+    }
+  for( i = 0; i < ncols; i++ )
+    { /* Temporary files next to the output, removed when closed */
+      sprintf( tmp, "%s.XXXXXX", path );
+      if( (hc->col[i].fd = mkstemp( tmp )) < 0 )
+	{
+	  err = errno;
+	  free( tmp );
+	  hcolClose( hc );
+	  errno = err;
+	  return NULL;
+	}
+      unlink( tmp );
+    }
+  free( tmp );
+  return hc;
+} /* hcolOpen */
+
+/**
+   Append one row taken from a record structure.
+   @param[in,out] hc Columnar output.
+   @param[in] rec Record with the fields described by HCOL::def.
+*/
+void hcolAppend( HCOL *hc, const void *rec )
+{
+  HCOLBUF *cb;
+  int i;
+
+  for( i = 0; i < hc->ncols; i++ )
+    {
+      cb = &hc->col[i];
+      if( cb->size-cb->len >= HCOL_VALSIZE )
+	{
+	  memcpy( cb->buf+cb->len, (const char *) rec+hc->def[i].offset,
+		  HCOL_VALSIZE );
+	  cb->len += HCOL_VALSIZE;
+	}
+      else
+	colWrite( cb, (const char *) rec+hc->def[i].offset, HCOL_VALSIZE );
+    }
+  hc->nrows++;
+} /* hcolAppend */
+
+/**
+   Append all rows of a memory buffer to another output, then empty the
+   memory buffer.
+   @param[in,out] dst Output to append to.
+   @param[in,out] src Memory buffer with the same columns.
+*/
+void hcolMerge( HCOL *dst, HCOL *src )
+{
+  int i;
+
+  for( i = 0; i < dst->ncols; i++ )
+    colWrite( &dst->col[i], src->col[i].buf, src->col[i].len );
+  dst->nrows += src->nrows;
+  hcolReset( src );
+} /* hcolMerge */
+
+/**
+   Discard the rows of a memory buffer.
+   @param[in,out] hc Memory buffer.
+*/
+void hcolReset( HCOL *hc )
+{
+  int i;
+
+  for( i = 0; i < hc->ncols; i++ ) hc->col[i].len = 0;
+  hc->nrows = 0;
+} /* hcolReset */
+
+/**
+   Write the header and columns, and release the output.
+   @param[in] hc Columnar output from hcolOpen().
+   @return 0 on success, -1 with errno set if the file could not be
+   written.
+*/
+int hcolClose( HCOL *hc )
+{
+  HCOLHEADER hdr;
+  HCOLFIELD fld;
+  HCOLBUF *cb;
+  uint64_t off, colBytes;
+  ssize_t n;
+  off_t pos;
+  int i, status, err;
+
+  status = 0;
+  if( hc->fd >= 0 )
+    {
+      memset( &hdr, 0, sizeof(hdr) );
+      strncpy( hdr.magic, HCOL_MAGIC, sizeof(hdr.magic) );
+      hdr.version = HCOL_VERSION;
+      hdr.byteOrder = HCOL_BYTEORDER;
+      hdr.ncols = hc->ncols;
+      hdr.headerSize = sizeof(HCOLHEADER)+hc->ncols*sizeof(HCOLFIELD);
+      hdr.nrows = hc->nrows;
+      status = writeAt( hc->fd, (char *) &hdr, sizeof(hdr), 0 );
+      colBytes = hc->nrows*HCOL_VALSIZE;
+      off = HCOL_ALIGN(hdr.headerSize);
+      for( i = 0; i < hc->ncols && status == 0; i++ )
+	{
+	  memset( &fld, 0, sizeof(fld) );
+	  strncpy( fld.name, hc->def[i].name, sizeof(fld.name)-1 );
+	  strncpy( fld.units, hc->def[i].units, sizeof(fld.units)-1 );
+	  fld.type = hc->def[i].type;
+	  fld.size = HCOL_VALSIZE;
+	  fld.offset = off;
+	  status = writeAt( hc->fd, (char *) &fld, sizeof(fld),
+			    sizeof(hdr)+i*sizeof(fld) );
+
+	  /* Spill what is left, then copy the column into place */
+	  cb = &hc->col[i];
+	  if( status == 0 )
+	    status = writeAt( cb->fd, cb->buf, cb->len,
+			      lseek( cb->fd, 0, SEEK_END ) );
+	  for( pos = 0; status == 0; pos += n )
+	    {
+	      if( (n = pread( cb->fd, cb->buf, cb->size, pos )) == 0 ) break;
+	      if( n < 0 )
+		{
+		  if( errno != EINTR ) status = -1;
+		  n = 0;
+		  continue;
+		}
+	      status = writeAt( hc->fd, cb->buf, n, off+pos );
+	    }
+	  off += HCOL_ALIGN(colBytes);
+	}
+      if( status == 0 && ftruncate( hc->fd, off ) ) status = -1;
+    }
+
+  err = errno;
+  if( hc->fd >= 0 && close( hc->fd ) && status == 0 )
+    {
+      status = -1;
+      err = errno;
+    }
+  for( i = 0; i < hc->ncols; i++ )
+    {
+      if( hc->col[i].fd >= 0 ) close( hc->col[i].fd );
+      free( hc->col[i].buf );
+    }
+  free( hc->col );
+  free( hc );
+  errno = err;
+  return status;
+} /* hcolClose */
@@ -0,0 +1,109 @@
+/** @file hcol.h
+    @brief
+    Binary columnar output for hgps and hsensor.
+
+    @details
+    A columnar file holds one contiguous array per record field, so
+    downstream tools can map it and use the columns with no parsing.  All
+    values are in the byte order of the machine that wrote the file; the
+    header records that order so a reader can check it.  The layout is:
+    @verbatim
+    HCOLHEADER                 32 bytes at offset 0
+    HCOLFIELD[ncols]           48 bytes each, right after the header
+    column data                nrows values per column, each column
+                               starting at HCOLFIELD::offset (64-byte
+                               aligned)
+    @endverbatim
+    For example, with numpy on a machine of the same byte order:
+    @verbatim
+    h = numpy.fromfile( f, [('magic','S8'),('version','=u4'),('order','=u4'),
+        ('ncols','=u4'),('hsize','=u4'),('nrows','=u8')], 1 )[0]
+    d = numpy.fromfile( f, [('name','S16'),('units','S16'),('type','=u4'),
+        ('size','=u4'),('offset','=u8')], h['ncols'], offset=32 )
+    tsecs = numpy.memmap( f, '=f4', 'r', int( d['offset'][0] ), h['nrows'] )
+    @endverbatim
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#ifndef HCOL_H
+#define HCOL_H
+#include <stddef.h>
+#include <stdint.h>
+
+#define HCOL_MAGIC "HARBCOL"    ///< File magic, NUL padded to 8 bytes
+#define HCOL_VERSION 1          ///< Format version
+#define HCOL_BYTEORDER 0x01020304 ///< Byte order mark
+#define HCOL_INT32 1            ///< Column of int32_t
+#define HCOL_FLOAT32 2          ///< Column of IEEE float
+
+/**
+   File header.
+*/
+typedef struct
+{
+  char magic[8];       ///< HCOL_MAGIC
+  uint32_t version;    ///< HCOL_VERSION
+  uint32_t byteOrder;  ///< HCOL_BYTEORDER as written
+  uint32_t ncols;      ///< Number of columns
+  uint32_t headerSize; ///< Bytes of header plus column descriptors
+  uint64_t nrows;      ///< Number of values in every column
+} HCOLHEADER;
+
+/**
+   Column descriptor in the file.
+*/
+typedef struct
+{
+  char name[16];   ///< Field name, NUL padded
+  char units[16];  ///< Units, NUL padded
+  uint32_t type;   ///< HCOL_INT32 or HCOL_FLOAT32
+  uint32_t size;   ///< Bytes per value
+  uint64_t offset; ///< File offset of the column array
+} HCOLFIELD;
+
+/**
+   Description of one column, taken from a record structure.
+*/
+typedef struct
+{
+  const char *name;  ///< Field name
+  const char *units; ///< Units
+  int type;          ///< HCOL_INT32 or HCOL_FLOAT32
+  size_t offset;     ///< offsetof() the field in the record
+} HCOLDEF;
+
+/**
+   Column buffer: values waiting to be written to one column.
+*/
+typedef struct
+{
+  char *buf;   ///< Buffered values
+  size_t len;  ///< Bytes in the buffer
+  size_t size; ///< Allocated size of the buffer
+  int fd;      ///< Unlinked temporary file holding the column, or -1
+} HCOLBUF;
+
+/**
+   Columnar output.  Use hcolOpen() to create one.
+*/
+typedef struct
+{
+  int fd;               ///< Output file, -1 for a memory buffer
+  const HCOLDEF *def;   ///< Column descriptions
+  int ncols;            ///< Number of columns
+  uint64_t nrows;       ///< Rows written so far
+  HCOLBUF *col;         ///< One buffer per column
+} HCOL;
+
+HCOL *hcolOpen( const char *path, const HCOLDEF *def, int ncols );
+void hcolAppend( HCOL *hc, const void *rec );
+void hcolMerge( HCOL *dst, HCOL *src );
+void hcolReset( HCOL *hc );
+int hcolClose( HCOL *hc );
+
+#endif /* HCOL_H */
@@ -0,0 +1,189 @@
+/** @file hcsv.c
+    @brief
+    Fast, locale-independent field scanner for Harbor CSV records.
+
+    @details
+    Plain decimal fields ("-12.345", "1400", " 7") are converted without
+    any library calls.  A float mantissa of up to 19 digits is collected in
+    an integer and divided once by an exact power of ten in double
+    precision.  Rounding that double to float gives the correctly rounded
+    result, the same value strtof() and sscanf() produce, unless the double
+    falls exactly on a float rounding midpoint; that rare case, and every
+    form the fast path does not handle, is passed to sscanf() on a copy of
+    the field so the results always match the original sscanf() parse.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Moved hcsvSep() inline into hcsv.h.
+    @endverbatim
+*/
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+#include "hcsv.h"
+
+/**
+   Longest field copied for the sscanf() fallback.
+*/
+#define HCSV_MAXFIELD 256
+
+/* The fast path relies on the division being done in plain double. */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD >= 0 && FLT_EVAL_METHOD <= 1
+#define HCSV_FAST 1
+#else
+#define HCSV_FAST 0
+#endif
+
+/**
+   Exact powers of ten representable as double.
+*/
+static const double pow10tab[23] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+/**
+   Same set of characters as isspace() in the C locale.
+*/
+static int isSpace( int c )
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+    c == '\r';
+} /* isSpace */
+
+/**
+   Convert one field with sscanf(), for input the fast path rejects.
+   @param[in,out] pp Start of field; advanced past the converted text.
+   @param[in] end End of the record.
+   @param[in] fmt Conversion, "%f%n" or "%d%n".
+   @param[out] val Converted value.
+   @return 1 if converted, 0 if not.
+*/
+static int slowScan( const char **pp, const char *end, const char *fmt,
+		     void *val )
+{
+  char buf[HCSV_MAXFIELD];
+  size_t len;
+  int used;
+
+  len = end-*pp;
+  if( len >= sizeof(buf) ) len = sizeof(buf)-1;
+  memcpy( buf, *pp, len );
+  buf[len] = '\0';
+  used = 0;
+  if( sscanf( buf, fmt, val, &used ) != 1 ) return 0;
+  *pp += used;
+  return 1;
+} /* slowScan */
+
+/**
+   Convert a float field, equivalent to sscanf() "%f".
+   @param[in,out] pp Start of field; advanced past the number on success.
+   @param[in] end End of the record.
+   @param[out] val Converted value, unchanged on failure.
+   @return 1 if a number was converted, 0 if not.
+*/
+int hcsvFloat( const char **pp, const char *end, float *val )
+{
+  const char *p, *start;
+  unsigned long long m, bits;
+  int neg, ndig, nfrac;
+  double d;
+  float f;
+
+  p = *pp;
+  while( p < end && isSpace( *p ) ) p++;
+  start = p;
+  neg = 0;
+  if( p < end && (*p == '-' || *p == '+') )
+    {
+      neg = (*p == '-');
+      p++;
+    }
+  m = 0;
+  ndig = nfrac = 0;
+  while( p < end && *p >= '0' && *p <= '9' )
+    {
+      m = m*10+(*p++ - '0');
+      ndig++;
+    }
+  if( p < end && *p == '.' )
+    {
+      p++;
+      while( p < end && *p >= '0' && *p <= '9' )
+	{
+	  m = m*10+(*p++ - '0');
+	  ndig++;
+	  nfrac++;
+	}
+    }
+  if( p < end )
+    switch( *p )
+      { /* Exponent, hex, inf or nan: leave it to sscanf() */
+      case 'e': case 'E': case 'x': case 'X':
+      case 'i': case 'I': case 'n': case 'N':
+	*pp = start;
+	return slowScan( pp, end, "%f%n", val );
+      }
+  if( ndig == 0 ) return 0; /* Not a number */
+  if( !HCSV_FAST || ndig > 19 || m > (1ULL<<53) )
+    {
+      *pp = start;
+      return slowScan( pp, end, "%f%n", val );
+    }
+  d = (double) m/pow10tab[nfrac];
+  memcpy( &bits, &d, sizeof(bits) );
+  if( (bits & 0x1fffffffULL) == 0x10000000ULL )
+    { /* Exactly on a float midpoint, double rounding could differ */
+      *pp = start;
+      return slowScan( pp, end, "%f%n", val );
+    }
+  f = (float) d;
+  *val = neg ? -f : f;
+  *pp = p;
+  return 1;
+} /* hcsvFloat */
+
+/**
+   Convert an integer field, equivalent to sscanf() "%d".
+   @param[in,out] pp Start of field; advanced past the number on success.
+   @param[in] end End of the record.
+   @param[out] val Converted value, unchanged on failure.
+   @return 1 if a number was converted, 0 if not.
+*/
+int hcsvInt( const char **pp, const char *end, int *val )
+{
+  const char *p, *start;
+  long long v;
+  int neg, ndig;
+
+  p = *pp;
+  while( p < end && isSpace( *p ) ) p++;
+  start = p;
+  neg = 0;
+  if( p < end && (*p == '-' || *p == '+') )
+    {
+      neg = (*p == '-');
+      p++;
+    }
+  v = 0;
+  ndig = 0;
+  while( p < end && *p >= '0' && *p <= '9' )
+    {
+      v = v*10+(*p++ - '0');
+      ndig++;
+    }
+  if( ndig == 0 ) return 0; /* Not a number */
+  if( ndig > 18 )
+    { /* Possible overflow, let sscanf() saturate it */
+      *pp = start;
+      return slowScan( pp, end, "%d%n", val );
+    }
+  *val = (int) (neg ? -v : v);
+  *pp = p;
+  return 1;
+} /* hcsvInt */
@@ -0,0 +1,43 @@
+/** @file hcsv.h
+    @brief
+    Fast, locale-independent field scanner for Harbor CSV records.
+
+    @details
+    These routines replace the per-record sscanf() call in hgps and hsensor.
+    Each routine works on a span of characters [*pp, end) that need not be
+    NUL terminated, converts one field in place, and advances *pp past the
+    characters it consumed.  The conversions accept exactly what sscanf()
+    accepts for "%f" and "%d" and produce bit-identical values: plain decimal
+    numbers take a specialized fast path, anything unusual (exponents, hex,
+    inf/nan, very long mantissas) is handed to sscanf() itself.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Made hcsvSep() inline.
+    @endverbatim
+*/
+#ifndef HCSV_H
+#define HCSV_H
+
+int hcsvFloat( const char **pp, const char *end, float *val );
+int hcsvInt( const char **pp, const char *end, int *val );
+
+/**
+   Match a literal separator character, as in a sscanf() format.  Inline,
+   since the generated record parsers call it between every two fields.
+   @param[in,out] pp Current position; advanced past the separator.
+   @param[in] end End of the record.
+   @param[in] sep Character to match.
+   @return 1 if matched, 0 if not.
+*/
+static inline int hcsvSep( const char **pp, const char *end, char sep )
+{
+  if( *pp >= end || **pp != sep ) return 0;
+  (*pp)++;
+  return 1;
+} /* hcsvSep */
+
+#endif /* HCSV_H */
@@ -0,0 +1,174 @@
+/** @file hfilt.c
+    @brief
+    Streaming outlier filter for Harbor records.
+
+    @details
+    Each ring has a sorted copy, updated by taking out the oldest value
+    and putting in the newest with one insertion pass.  The median is
+    then the middle of the sorted copy, and the MAD is found by walking
+    out from the middle, about n/2 steps.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "hfilt.h"
+
+/**
+   Scale from the MAD to the standard deviation of normal data.
+*/
+#define HFILT_MADSCALE 1.4826f
+
+/**
+   Make a filter from a specification "k[,n]".
+   @param[in] spec Threshold k in robust standard deviations and
+   optionally the ring length n (default HFILT_WINDOW).
+   @param[in] nchan Number of channels checked in each record.
+   @return Filter, or NULL with errno set to EINVAL for a bad
+   specification or ENOMEM.
+*/
+HFILT *hfiltOpen( const char *spec, int nchan )
+{
+  HFILT *f;
+  char *end;
+  double k;
+  long n;
+
+  k = strtod( spec, &end );
+  n = HFILT_WINDOW;
+  if( *end == ',' ) n = strtol( end+1, &end, 10 );
+  if( end == spec || *end || !(k > 0.0) || n < 3 || n > HFILT_MAXWINDOW ||
+      nchan < 1 )
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+  if( (f = calloc( 1, sizeof(HFILT) )) == NULL ) return NULL;
+  if( (f->ring = malloc( nchan*n*sizeof(float) )) == NULL ||
+      (f->sorted = malloc( nchan*n*sizeof(float) )) == NULL )
+    {
+      free( f->ring );
+      free( f );
+      return NULL;
+    }
+  f->nchan = nchan;
+  f->n = n;
+  f->k = k;
+  return f;
+} /* hfiltOpen */
+
+/**
+   Median absolute deviation of a sorted window.  The deviations grow
+   outwards from the median on both sides, so the middle ones are found by
+   merging the two sides from the middle out.
+   @param[in] s Sorted values.
+   @param[in] n Number of values, at least 2.
+   @param[in] med Median of @a s.
+   @return The MAD.
+*/
+static float sortedMad( const float *s, int n, float med )
+{
+  int i, j, k;
+  float d, first;
+
+  i = n/2-1;
+  j = n/2;
+  first = d = 0.0f;
+  for( k = 0; k <= n/2; k++ )
+    { /* The k-th smallest deviation */
+      if( j >= n || (i >= 0 && med-s[i] < s[j]-med) ) d = med-s[i--];
+      else d = s[j++]-med;
+      if( k == (n-1)/2 ) first = d;
+    }
+  return n%2 ? first : 0.5f*(first+d);
+} /* sortedMad */
+
+/**
+   Put a value into a sorted window in place of an old one.
+   @param[in,out] s Sorted values.
+   @param[in] n Number of values.
+   @param[in] old Value to take out, which must be in @a s.
+   @param[in] val Value to put in.
+*/
+static void sortedReplace( float *s, int n, float old, float val )
+{
+  int i;
+
+  for( i = 0; i < n-1 && s[i] != old; i++ )
+    ;
+  for( ; i < n-1 && s[i+1] < val; i++ ) s[i] = s[i+1];
+  for( ; i > 0 && s[i-1] > val; i-- ) s[i] = s[i-1];
+  s[i] = val;
+} /* sortedReplace */
+
+/**
+   Check one record and add its values to the rings.
+   @param[in,out] f Filter.
+   @param[in] val Values of the channels, f->nchan of them.
+   @return Index of the first channel that is an outlier, or -1 if the
+   record is accepted.
+*/
+int hfiltCheck( HFILT *f, const float *val )
+{
+  float *ring, *sorted, med, mad, dev, lim, low, v;
+  int bad, c, i, m, half, lo;
+
+  bad = -1;
+  m = f->n/2;
+  half = (f->n+1)/2;
+  lo = m-half/2;
+  for( c = 0; c < f->nchan; c++ )
+    {
+      ring = f->ring+c*f->n;
+      sorted = f->sorted+c*f->n;
+      v = val[c];
+      if( isnan( v ) ) /* Keep the windows ordered */
+	v = f->count ? ring[(f->head+f->n-1)%f->n] : 0.0f;
+      if( f->count < f->n )
+	{ /* Filling up: insert only */
+	  for( i = f->count; i > 0 && sorted[i-1] > v; i-- )
+	    sorted[i] = sorted[i-1];
+	  sorted[i] = v;
+	  ring[f->head] = v;
+	  continue;
+	}
+      if( bad < 0 && !isnan( val[c] ) )
+	{
+	  med = f->n%2 ? sorted[m] : 0.5f*(sorted[m-1]+sorted[m]);
+	  dev = fabsf( v-med );
+	  lim = f->k*HFILT_MADSCALE;
+	  /* Fewer than half the values lie strictly inside
+	     (sorted[lo], sorted[lo+half]), so the MAD is at least as far
+	     as the nearer end: most values pass without the MAD */
+	  low = fminf( med-sorted[lo], sorted[lo+half]-med );
+	  if( !(dev <= lim*low) )
+	    {
+	      mad = sortedMad( sorted, f->n, med );
+	      if( mad > 0.0f && dev > lim*mad ) bad = c;
+	    }
+	}
+      sortedReplace( sorted, f->n, ring[f->head], v );
+      ring[f->head] = v;
+    }
+  if( ++f->head == f->n ) f->head = 0;
+  if( f->count < f->n ) f->count++;
+  return bad;
+} /* hfiltCheck */
+
+/**
+   Release a filter.
+   @param[in] f Filter from hfiltOpen().
+*/
+void hfiltClose( HFILT *f )
+{
+  free( f->ring );
+  free( f->sorted );
+  free( f );
+} /* hfiltClose */
@@ -0,0 +1,57 @@
+/** @file hfilt.h
+    @brief
+    Streaming outlier filter for Harbor records.
+
+    @details
+    Each channel keeps the last n values in a fixed-size ring.  A new
+    value is an outlier if it is further from the median of its ring than
+    k times the robust standard deviation, 1.4826 times the median
+    absolute deviation (MAD) of the ring.  A record is rejected if any of
+    its channels is an outlier.  Every value goes into the ring, rejected
+    or not, so a genuine step in the data is followed once it lasts for
+    half the window, while isolated spikes never move the median.  Until
+    a ring is full, and while its MAD is zero, its channel rejects
+    nothing.  A value that is not a number is never an outlier; the
+    channel's previous value takes its place in the ring.  The work per
+    record is a fixed amount per channel, of order n, however long the
+    input is.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#ifndef HFILT_H
+#define HFILT_H
+
+/**
+   Default ring length.
+*/
+#define HFILT_WINDOW 15
+
+/**
+   Longest ring allowed.
+*/
+#define HFILT_MAXWINDOW 255
+
+/**
+   Filter state.  Use hfiltOpen() to create one.
+*/
+typedef struct
+{
+  int nchan;     ///< Number of channels
+  int n;         ///< Ring length
+  float k;       ///< Threshold in robust standard deviations
+  int count;     ///< Values in each ring so far, up to n
+  int head;      ///< Next slot to fill in every ring
+  float *ring;   ///< Rings, n values for each channel
+  float *sorted; ///< Ring values in order, n for each channel
+} HFILT;
+
+HFILT *hfiltOpen( const char *spec, int nchan );
+int hfiltCheck( HFILT *f, const float *val );
+void hfiltClose( HFILT *f );
+
+#endif /* HFILT_H */
@@ -9,206 +9,1451 @@
     number of satellites in view, and averaged over a given number of
     seconds.
     @verbatim
-    Compile: gcc -Wall -o hgps hgps.c
-    Use: hgps input.csv avg_secs min_sats > output.txt
+    Compile: gcc -Wall -O2 -o hgps hgps.c hrec.c hcsv.c hread.c hout.c hcol.c
+             hidx.c hfilt.c hstat.c hcal.c hckpt.c hkin.c hsort.c hpyr.c
+             harbor.c -pthread -lz -lm
+    Use: hgps [-f] [-j nthreads] [--from tsecs] [--to tsecs] [--reject k[,n]]
+              [--slide] [--kinematics] [--sort[=MiB]]
+              [--pyramid file[,secs]] [--stats] [--checkpoint file]
+              [-o output_%s.txt] [-c output_%s.hcol] input.csv
+              avg_secs[,avg_secs...] min_sats > output.txt
     @endverbatim
-    @arg @c input.csv is the Harbor GPS CSV data file to process
+    @arg @c --from @c tsecs and @c --to @c tsecs keep only the records
+    with tsecs in that range.  For a regular file a sidecar index,
+    input.csv.hidx (see hidx.h), is built on first use so only the part
+    of the file holding the range is read; comments are copied from that
+    part only.
+    @arg @c --reject @c k[,n] drops position jumps before averaging: a
+    record with enough satellites is written as a comment instead if its
+    latitude, longitude or altitude is more than k robust standard
+    deviations from the median of the last n such records, default n 15
+    (see hfilt.h).
+    @arg @c --slide makes each average a sliding window: every accepted
+    record is written as the average of itself and the accepted records
+    of the avg_secs before it, instead of one average per avg_secs
+    period.  The window sums are updated by adding the new record and
+    subtracting the expired ones, so the cost per record does not grow
+    with avg_secs.
+    @arg @c --kinematics adds three columns to each record or average
+    written: the ascent rate and ground speed in m/s and the track in
+    degrees east of north, from the step to it from the one written
+    before (see hkin.h).  With averaging they are those of the averaged
+    track.  The first record, and one that does not come after the one
+    before in time, has NaN for them.  The -c columns are vrate, speed
+    and track.
+    @arg @c --sort[=MiB] reads all the records first and reduces them in
+    order of tsecs, keeping only the first record read of each tsecs, for
+    a file with the repeated and out of order stretches a restarted
+    ground station leaves.  At most @a MiB, default 256, of records are
+    held; the sorted runs beyond that go to temporary files in $TMPDIR
+    and are merged (see hsort.h).  The comments, and the records below
+    min_sats, are written as they are read, so they come before the
+    data, and --reject checks the records in the order they are read.
+    The whole file is read even with --from or --to.  It cannot be used
+    with -f.
+    @arg @c --pyramid @c file[,secs] also writes @a file, a pyramid of
+    the sums and counts of tsecs, lat, lon, alt and nsats over periods
+    of secs, default 1, and of 4, 16, 64 and so on times that, each level
+    summed from the one below (see hpyr.h), so that hzoom can serve the
+    averages for any zoom without another run.  The periods are aligned
+    to multiples of their length in tsecs rather than starting at a
+    record.  Records must be in tsecs order, as with --sort; any from
+    before the period being summed are left out, with a warning.
+    @arg @c --stats writes a report to stderr at the end: how many lines
+    were comments, too short, cut off at the end of the input, outside
+    --from and --to, below min_sats, rejected, or dropped or reordered by
+    --sort, how many were 256 bytes or longer, the bytes and records per
+    second, and an estimate of the time spent reading, parsing, filtering,
+    averaging and formatting (see hstat.h).  It is cheap enough to leave on.
+    With -j the times are summed over the threads, and averaging includes
+    formatting.
+    @arg @c --checkpoint @c file saves the state of the run in @a file at
+    the end (see hckpt.h).  If @a file holds a checkpoint from a run with
+    the same options on the same input, since grown by appending, only
+    the data after it are reduced: each -o output is cut back to before
+    the average of the period that was still open, and appended to, so
+    it ends up as a run over the whole input would write it.  Otherwise
+    the input is reduced from the start.  A last line without a newline
+    is left for the next run.  It needs -o and an uncompressed regular
+    input file, and cannot be used with -c, -f, --slide, --reject,
+    --sort or --pyramid.
+    @arg @c -f follows a file that is still being written, like "tail -f":
+    new records are processed as they are appended, with the averages
+    carried across, and the text output is flushed whenever the input is
+    caught up.  SIGINT or SIGTERM writes the open averages and exits.
+    Columnar files are finished only at exit.
+    @arg @c -j @c nthreads splits a large input file into chunks processed
+    by that many threads; the output is identical to a single-thread run,
+    including averages across midnight UT.  Ignored with -f, --reject,
+    --slide, --kinematics, --sort and --pyramid, which need the records in
+    order.
+    @arg @c -c @c output.hcol writes the records to a binary columnar file
+    (see hcol.h) instead of text columns; comments still go to the text
+    output
+    @arg @c -o @c output.txt writes the text output to a file instead of
+    stdout.  With several avg_secs values the -o and -c names must contain
+    "%s", which is replaced by each avg_secs value.  Each output file, or
+    stdout with a single avg_secs, is written by a thread of its own
+    while the next records are formatted.
+    @arg @c input.csv is the Harbor GPS CSV data file to process,
+    or - for standard input.  A gzip or zstd compressed file is
+    decompressed as it is read (see hread.h); -f and the sidecar index
+    need an uncompressed file.
     @arg @c avg_secs is the number of seconds for averaging; zero for no
-    averaging
+    averaging.  A comma-separated list computes several averages in one
+    pass, each written to its own -o file.
     @arg @c min_sats is the minimum number of satellites for a valid record
 
     Any record that does not begin with a digit 0-9 is written as a comment
     starting with '#'.  Records with less than min_sats are also written as
     comments.  While 4 satellites are needed for a 4-D fix, positions may be
     obtained with fewer satellites once the GPS obtains lock.  Records with 0
-    satellites may be assumed to be invalid.
+    satellites may be assumed to be invalid.  Lines may be of any length;
+    fields after the last one hgps knows are ignored.
 
     @author Don Rice
     @date 2014-Nov-15 Added doxygen markup.
     @verbatim
     History:
     2014-Nov-14 Initial version
+    2026-Oct-14 Replaced sscanf() with the hcsv field scanner.
+    2026-Oct-14 Read input through the memory-mapped hread reader.
+    2026-Oct-14 Write output through the buffered hout formatter.
+    2026-Oct-14 Added -c for binary columnar output.
+    2026-Oct-14 Accept a list of avg_secs values, averaged in one pass.
+    2026-Oct-14 Added -f to follow a file that is still being written.
+    2026-Oct-14 Sum averages in double precision.
+    2026-Oct-14 Added --from and --to with a sidecar time index.
+    2026-Oct-14 Read gzip and zstd compressed input.
+    2026-Oct-14 Use the field table formatters and columns of hrec.
+    2026-Oct-14 Added --reject for a streaming outlier filter.
+    2026-Oct-14 Added --slide for sliding window averages.
+    2026-Oct-14 Added --stats for line counts and stage times.
+    2026-Oct-14 Added -j for multi-threaded chunked processing.
+    2026-Oct-14 Write output on a writer thread; read pipes ahead.
+    2026-Oct-14 Read lines of any length.
+    2026-Oct-14 Added --checkpoint to resume where the last run ended.
+    2026-Oct-14 Added --kinematics for ascent rate, speed and track.
+    2026-Oct-14 Copy runs of comment lines together.
+    2026-Oct-14 Average with the libharbor functions.
+    2026-Oct-14 Added --sort to reorder and deduplicate records by tsecs.
+    2026-Oct-14 Added --pyramid for multi-resolution averages.
+    2026-Oct-14 Read the input through harborRead().
     @endverbatim
 */
 /**
    Code modification date
 */
-#define CODE_MOD_DATE "Mod_Date:2014-Nov-15"
+#define CODE_MOD_DATE "Mod_Date:2026-Oct-14"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <math.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include "hread.h"
+#include "hout.h"
+#include "hcol.h"
+#include "hidx.h"
+#include "hrec.h"
+#include "hfilt.h"
+#include "hstat.h"
+#include "hckpt.h"
+#include "hkin.h"
+#include "hsort.h"
+#include "hpyr.h"
+#include "harbor.h"
 
 /**
-   GPS record data structure.  All times are UT.
+   One record of a sliding window.
 */
 typedef struct
 {
-  int mday;      ///< Day of month, 1-31
-  int month;     ///< Month, 1-12
-  int year;      ///< Year, >2000
-  int hour;      ///< Hour, 0-23
-  int minute;    ///< Minute, 0-59
-  int second;    ///< Second, 0-59
-  int todaySecs; ///< Seconds since midnight, 0-86399
-  int nsats;     ///< Number of GPS satellites in view
-  float tsecs;   ///< Seconds since start of dataset
-  float lat;     ///< Latitude, deg north
-  float lon;     ///< Longitude, deg east
-  float alt;     ///< Altitude, m above MSL
-} GPSDATA;
-
-void showAverage( int navg, GPSDATA *raw, GPSDATA *avg );
-int updateAverage( int navg, GPSDATA *raw, GPSDATA *avg );
+  GPSDATA rec; ///< Accepted record
+  int day;     ///< Days since the first record, counted at hour rollovers
+} GPSSLOT;
+
+/**
+   One averaging window.  Several windows, each with its own avg_secs and
+   output, are computed in a single pass over the input.
+*/
+typedef struct
+{
+  const char *label; ///< avg_secs as given on the command line
+  float avgSecs;     ///< Averaging period, zero for no averaging
+  float t0;          ///< Start time of the current period
+  int navg;          ///< Records in the current period
+  GPSSUM avg;        ///< Sums for the current period
+  HOUT *out;         ///< Text output
+  HCOL *col;         ///< Columnar output, or NULL for text
+  int slide;         ///< Nonzero for a sliding window
+  GPSSLOT *ring;     ///< Records in the sliding window
+  int tail;          ///< Oldest record in ring
+  int maxring;       ///< Allocated size of ring
+  int nexp;          ///< Records expired since the sums were recomputed
+  int day;           ///< Day of the latest record, as GPSSLOT::day
+  int hour;          ///< Hour of the latest record
+  long long secs;    ///< Sum of seconds since midnight of day 0
+  HKIN *kin;         ///< Last position written, or NULL without
+                     ///< --kinematics
+} WINDOW;
+
+/**
+   State of one window saved in a checkpoint.
+*/
+typedef struct
+{
+  long long outSize; ///< Size of the output without the open period
+  float t0;          ///< Start time of the open period
+  int navg;          ///< Records in the open period
+  GPSSUM avg;        ///< Sums for the open period
+  HKIN kin;          ///< Last position written, with --kinematics
+} SAVEDWIN;
+
+/**
+   State of a run saved in a checkpoint.
+*/
+typedef struct
+{
+  GPSDATA raw;       ///< Last record parsed, which dates the last average
+  SAVEDWIN win[];    ///< State of each window
+} SAVED;
+
+/**
+   Where the records and comments that harborRead() passes on go: the
+   context of its callbacks.
+*/
+typedef struct
+{
+  const char *prog;  ///< Program name, for errors
+  WINDOW *win;       ///< Windows
+  int nwin;          ///< Number of windows
+  HSORT *sort;       ///< Records held for --sort, or NULL
+  HPYR *pyr;         ///< --pyramid output, or NULL
+} SINK;
+
+/**
+   Record with its kinematics, for the -c columns of --kinematics.
+*/
+typedef struct
+{
+  GPSDATA rec;       ///< Record or average
+  HKINVAL kin;       ///< Kinematics of the step to it
+} GPSKIN;
+
+/**
+   Size of the input chunk given to each worker thread in parallel mode.
+*/
+#ifndef CHUNK_BYTES
+#define CHUNK_BYTES (8<<20)
+#endif
+
+/**
+   One line of a chunk in parallel mode: either a comment to be copied to
+   the output or an accepted record.
+*/
+typedef struct
+{
+  const char *str; ///< Start of the line
+  size_t len;      ///< Length of the line
+  int rec;         ///< Index of the accepted record, or minus the number
+                   ///< of lines of a run of comments
+} LINE;
+
+/**
+   Results of one chunk for one window in parallel mode.  Records before
+   the first averaging period that starts in the chunk belong to a period
+   carried in from earlier chunks; their sums and the position of that
+   period's average in the output are left for the in-order merge.
+*/
+typedef struct
+{
+  HOUT *out;         ///< Formatted output, kept in memory
+  HCOL *col;         ///< Columnar output in memory, or NULL
+  size_t split;      ///< Output offset for the carried-in average
+  int started;       ///< Nonzero if a period starts in the chunk
+  int nhead;         ///< Records belonging to the carried-in period
+  int navg;          ///< Records in the period open at the end
+  GPSSUM avg;        ///< Sums for the period open at the end
+} PART;
+
+/**
+   Work and results for one newline-aligned chunk of the input in parallel
+   mode.  The date of the record an average is written with, when the
+   average passes midnight, is that of the line parsed last, as in the
+   serial loop; so each chunk also keeps its last parse and how many
+   fields of it any line set.
+*/
+typedef struct
+{
+  const char *start, *end; ///< Part of the mapped input
+  WINDOW *win;             ///< Windows to compute
+  int nwin;                ///< Number of windows
+  float from, to;          ///< Range of record times to keep
+  int minSats;             ///< Minimum satellites for a valid record
+  int direct;              ///< Nonzero to format records while parsing
+  LINE *line;              ///< Lines in the chunk
+  int nline, maxline;      ///< Lines used and allocated
+  GPSDATA *rec;            ///< Accepted records, full year
+  int nrec, maxrec;        ///< Records used and allocated
+  char *first;             ///< Nonzero if a record starts a new period,
+                           ///< nwin flags per record
+  int maxfirst;            ///< Allocated size of first
+  GPSDATA last;            ///< Values of the last parse in the chunk
+  int nlast;               ///< Most fields any parse in the chunk set
+  PART *part;              ///< Results for each window
+  HSTAT *stats;            ///< Statistics of the chunks of this thread,
+                           ///< or NULL
+} CHUNK;
+
+/**
+   Columns written with -c: gpsColumns, and the kinematics with
+   --kinematics.
+*/
+static HCOLDEF columns[GPS_NCOLS+3];
+
+/**
+   Number of columns written with -c.
+*/
+static int ncolumns;
+
+/**
+   Statistics for --stats, or NULL.
+*/
+static HSTAT *stats;
+
+/**
+   Set by SIGINT or SIGTERM to end follow mode.
+*/
+static volatile sig_atomic_t stopFollow;
+
+void stopHandler( int sig );
+void takeRecord( void *ctx, const void *rec );
+void takeComment( void *ctx, const char *str, size_t len, size_t nlines,
+		  int why );
+void addRecord( WINDOW *w, GPSDATA *raw );
+void showRecord( HOUT *out, HCOL *col, HKIN *kin, GPSDATA *raw );
+void slideRecord( WINDOW *w, GPSDATA *raw );
+void slideSum( WINDOW *w, GPSSLOT *s, int sign );
+void showAverage( HOUT *out, HCOL *col, HKIN *kin, int navg, GPSDATA *raw,
+		  GPSSUM *avg );
+void showKinematics( HOUT *out, HKINVAL *val );
+void runParallel( HREADER *in, WINDOW *win, int nwin, int nthreads,
+		  float from, float to, int minSats, GPSDATA *raw );
+void *parseChunk( void *arg );
+void *formatChunk( void *arg );
+void runThreads( void *(*fn)( void * ), CHUNK *chunk, int nchunk );
+void *growArray( void *ptr, int *max, size_t size );
+SAVED *loadCheckpoint( const char *path, HREADER *in, uint32_t config,
+		       WINDOW *win, int nwin, const char *outName,
+		       size_t *offset );
+void saveState( SAVED *saved, WINDOW *win, int nwin, GPSDATA *raw );
 
 int main( int argc, char **argv )
 {
-  int minSats, navg;
-  float avgSecs, t0;
-  char str[256];
-  FILE *in;
-  GPSDATA raw, avg;
+  int minSats, nthreads, nwin, follow, ranged, slide, kinematics, c, bad, i;
+  float from, to;
+  double mib, pyrBase;
+  const char *outName, *colName, *reject, *ckptName, *pyrName;
+  char *list, *tok, *name, range[64];
+  size_t start, end, offset, size, whole, tail;
+  uint32_t config;
+  SAVED *saved;
+  HSORT *sort;
+  HPYR *pyr;
+  const void *rec;
+  HREADER *in;
+  WINDOW *win, *w;
+  GPSDATA raw;
+  HARBOROPTS opt;
+  HARBORCALLS calls;
+  HARBOR *h;
+  SINK sink;
+  struct sigaction sa;
 
-  if( argc != 4 )
+  static const struct option longOpts[] =
     {
-      fprintf( stderr, "Use: %s input.csv avg_secs min_sats > output.txt\n",
+      { "from", required_argument, NULL, 'F' },
+      { "to", required_argument, NULL, 'T' },
+      { "reject", required_argument, NULL, 'R' },
+      { "slide", no_argument, NULL, 'S' },
+      { "kinematics", no_argument, NULL, 'V' },
+      { "sort", optional_argument, NULL, 'O' },
+      { "pyramid", required_argument, NULL, 'P' },
+      { "stats", no_argument, NULL, 'Z' },
+      { "checkpoint", required_argument, NULL, 'K' },
+      { NULL, 0, NULL, 0 }
+    };
+
+  outName = colName = reject = ckptName = pyrName = NULL;
+  pyrBase = 1.0;
+  nthreads = 1;
+  follow = ranged = slide = kinematics = bad = 0;
+  from = -HUGE_VALF;
+  to = HUGE_VALF;
+  sort = NULL;
+  while( (c = getopt_long( argc, argv, "fj:c:o:", longOpts, NULL )) != -1 )
+    switch( c )
+      {
+      case 'F':
+	from = atof( optarg );
+	ranged = 1;
+	break;
+      case 'T':
+	to = atof( optarg );
+	ranged = 1;
+	break;
+      case 'R':
+	reject = optarg;
+	break;
+      case 'S':
+	slide = 1;
+	break;
+      case 'V':
+	kinematics = 1;
+	break;
+      case 'P':
+	pyrName = optarg;
+	if( (tok = strrchr( optarg, ',' )) )
+	  { /* Base period after the last comma */
+	    *tok = '\0';
+	    if( !((pyrBase = atof( tok+1 )) > 0.0) )
+	      {
+		fprintf( stderr, "%s: bad --pyramid period %s\n", argv[0],
+			 tok+1 );
+		exit(EXIT_FAILURE);
+	      }
+	  }
+	break;
+      case 'O':
+	mib = optarg ? atof( optarg ) : HSORT_LIMIT/1048576.0;
+	if( mib <= 0.0 || (sort = hsortOpen( sizeof(GPSDATA),
+					     offsetof(GPSDATA, tsecs),
+					     mib*1048576.0 )) == NULL )
+	  {
+	    fprintf( stderr, "%s: bad --sort %s\n", argv[0], optarg );
+	    exit(EXIT_FAILURE);
+	  }
+	break;
+      case 'K':
+	ckptName = optarg;
+	break;
+      case 'Z':
+	if( (stats = hstatOpen()) == NULL )
+	  {
+	    perror( argv[0] );
+	    exit(EXIT_FAILURE);
+	  }
+	break;
+      case 'f':
+	follow = 1;
+	break;
+      case 'j':
+	nthreads = atoi( optarg );
+	break;
+      case 'c':
+	colName = optarg;
+	break;
+      case 'o':
+	outName = optarg;
+	break;
+      default:
+	bad = 1;
+	break;
+      }
+  if( argc-optind != 3 || bad || nthreads < 1 )
+    {
+      fprintf( stderr, "Use: %s [-f] [-j nthreads] [--from tsecs] [--to tsecs] "
+	       "[--reject k[,n]] [--slide] [--kinematics] [--sort[=MiB]] "
+	       "[--pyramid file[,secs]] [--stats] [--checkpoint file] "
+	       "[-o output_%%s.txt] [-c output_%%s.hcol] "
+	       "input.csv avg_secs[,avg_secs...] min_sats > output.txt\n",
 	       argv[0] );
       fprintf( stderr, "[%s]\n", CODE_MOD_DATE );
       exit(EXIT_FAILURE);
     }
+  if( (list = strdup( argv[optind+1] )) == NULL ||
+      (win = calloc( strlen( list )/2+1, sizeof(WINDOW) )) == NULL )
+    {
+      perror( argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  for( nwin = 0, tok = strtok( list, "," ); tok; tok = strtok( NULL, "," ) )
+    win[nwin++].label = tok;
+  if( nwin > 1 && (!outName || !strstr( outName, "%s" ) ||
+		   (colName && !strstr( colName, "%s" ))) )
+    {
+      fprintf( stderr, "%s: several avg_secs need -o (and -c) names "
+	       "containing %%s\n", argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  if( ckptName && (!outName || colName || follow || slide || reject ||
+		   sort || pyrName) )
+    {
+      fprintf( stderr, "%s: --checkpoint needs -o, and cannot be used with "
+	       "-c, -f, --slide, --reject, --sort or --pyramid\n", argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  if( sort && follow )
+    {
+      fprintf( stderr, "%s: --sort cannot be used with -f\n", argv[0] );
+      exit(EXIT_FAILURE);
+    }
   /* Open input file, CSV format */
-  if( (in = fopen( argv[1], "r" )) == NULL )
+  if( (in = hreadOpen( argv[optind] )) == NULL )
+    {
+      perror( argv[optind] );
+      exit(EXIT_FAILURE);
+    }
+  saved = NULL;
+  config = 0;
+  end = tail = 0;
+  size = sizeof(SAVED)+nwin*sizeof(SAVEDWIN);
+  if( ckptName )
+    { /* The options the output depends on, for matching a checkpoint */
+      if( in->map == NULL )
+	{
+	  fprintf( stderr, "%s: --checkpoint needs an uncompressed regular "
+		   "file\n", argv[optind] );
+	  exit(EXIT_FAILURE);
+	}
+      snprintf( range, sizeof(range), "%a %a", from, to );
+      config = hckptHash( 0, "hgps" );
+      config = hckptHash( config, argv[optind+1] );
+      config = hckptHash( config, argv[optind+2] );
+      config = hckptHash( config, range );
+      config = hckptHash( config, kinematics ? "kinematics" : "" );
+      config = hckptHash( config, outName );
+      saved = loadCheckpoint( ckptName, in, config, win, nwin, outName,
+			      &offset );
+    }
+  if( follow )
+    {
+      if( hreadFollow( in, argv[optind] ) )
+	{
+	  perror( argv[optind] );
+	  exit(EXIT_FAILURE);
+	}
+      /* Finish the open periods and exit normally on a signal */
+      memset( &sa, 0, sizeof(sa) );
+      sa.sa_handler = stopHandler;
+      sigaction( SIGINT, &sa, NULL );
+      sigaction( SIGTERM, &sa, NULL );
+    }
+  else if( ((ranged && !sort) || ckptName) && in->map )
+    { /* Read only the part of the file that holds the time range, and
+	 with a checkpoint the whole lines not yet reduced */
+      start = 0;
+      end = in->mapSize;
+      if( ranged && hidxRange( argv[optind], in, from, to, &start, &end ) )
+	{
+	  perror( argv[optind] );
+	  exit(EXIT_FAILURE);
+	}
+      if( saved && start < offset ) start = offset;
+      if( start > end ) start = end;
+      tail = end;
+      if( ckptName && end > (whole = hckptWhole( in )) )
+	end = start > whole ? start : whole;
+      if( hreadRange( in, start, end ) )
+	{
+	  perror( argv[optind] );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  minSats = atoi( argv[optind+2] );
+  /* The records and comments of each line, for the windows to average */
+  harborOptions( &opt, HARBOR_GPS );
+  opt.from = from;
+  opt.to = to;
+  opt.minSats = minSats;
+  opt.reject = reject;
+  opt.stats = stats;
+  calls = (HARBORCALLS) { &sink, takeRecord, NULL, takeComment };
+  if( (h = harborOpen( &opt, &calls )) == NULL )
     {
-      perror( argv[1] );
+      fprintf( stderr, "%s: bad --reject %s\n", argv[0], reject );
       exit(EXIT_FAILURE);
     }
-  avgSecs = atof( argv[2] );
-  minSats = atoi( argv[3] );
-  printf( "# %s %s %s %s\n", argv[0], argv[1], argv[2], argv[3] );
-
-  /* Read through input file; process lines that start with a digit. */
-  t0 = -1.0;
-  navg = 0;
-  while( fgets( str, 256, in ) )
-    {
-      if( !isdigit( *str ) ) /* Not a data record */
-	{
-	  printf( "# %s", str );
-	  continue;
-	}
-      if( sscanf( str, "%f,%d/%d/%d,%d:%d:%d,%f,%f,%f,%d", &raw.tsecs,
-		  &raw.mday, &raw.month, &raw.year, &raw.hour, &raw.minute,
-		  &raw.second, &raw.lat, &raw.lon, &raw.alt,
-		  &raw.nsats ) != 11 )
-	{ /* Insufficient data, treat at somment */
-	  printf( "# %s", str );
-	  continue;
-	}
-      if( raw.nsats < minSats )
-	{ /* No GPS lock, ignore data */
-	  printf( "# %s", str );
-	  continue;
-	}
-      raw.year += 2000; /* Convert to full year */
-      /* Write out as fixed length columns */
-      if( avgSecs <= 0.0 ) /* No averaging */
-	printf( "%6.1f %2d %2d %4d %2d %2d %2d %11.7f %12.7f %8.1f %2d\n",
-		raw.tsecs, raw.mday, raw.month, raw.year, raw.hour, raw.minute,
-		raw.second, raw.lat, raw.lon, raw.alt, raw.nsats );
+  if( saved ) h->gps = saved->raw;
+  memcpy( columns, gpsColumns, sizeof(gpsColumns) );
+  ncolumns = GPS_NCOLS;
+  if( kinematics )
+    { /* The kinematics follow the record in a GPSKIN */
+      columns[ncolumns++] = (HCOLDEF) { "vrate", "m/s", HCOL_FLOAT32,
+					offsetof(GPSKIN, kin.vrate) };
+      columns[ncolumns++] = (HCOLDEF) { "speed", "m/s", HCOL_FLOAT32,
+					offsetof(GPSKIN, kin.speed) };
+      columns[ncolumns++] = (HCOLDEF) { "track", "deg", HCOL_FLOAT32,
+					offsetof(GPSKIN, kin.track) };
+    }
+  pyr = NULL;
+  if( pyrName &&
+      (pyr = hpyrOpen( pyrName, pyrBase, gpsColumns, GPS_NCOLS )) == NULL )
+    {
+      perror( pyrName );
+      exit(EXIT_FAILURE);
+    }
+  for( i = 0; i < nwin; i++ )
+    { /* Open the outputs for each window */
+      w = &win[i];
+      w->avgSecs = atof( w->label );
+      w->t0 = saved ? saved->win[i].t0 : -1.0;
+      w->navg = saved ? saved->win[i].navg : 0;
+      if( saved ) w->avg = saved->win[i].avg;
+      w->slide = slide && w->avgSecs > 0.0;
+      if( kinematics && (w->kin = calloc( 1, sizeof(HKIN) )) == NULL )
+	{
+	  perror( argv[0] );
+	  exit(EXIT_FAILURE);
+	}
+      if( saved && w->kin ) *w->kin = saved->win[i].kin;
+      if( outName )
+	{
+	  name = houtName( outName, w->label );
+	  if( (w->out = saved ? houtResume( name, saved->win[i].outSize ) :
+	       houtCreate( name )) == NULL )
+	    {
+	      perror( name );
+	      exit(EXIT_FAILURE);
+	    }
+	  free( name );
+	}
       else
-	{ /* Average measurements for given number of seconds */
-	  if( raw.tsecs-t0 > avgSecs || t0 < 0.0 )
-	    { /* Compute and display average for last period */
-	      showAverage( navg, &raw, &avg );
-	      navg = updateAverage( 0, &raw, &avg );
-	      t0 = raw.tsecs;
+	w->out = houtOpen( STDOUT_FILENO );
+      /* Windows sharing standard output keep writing it in turn */
+      if( (outName || nwin == 1) && houtAsync( w->out ) )
+	{
+	  perror( "houtAsync" );
+	  exit(EXIT_FAILURE);
+	}
+      if( colName )
+	{
+	  name = houtName( colName, w->label );
+	  if( (w->col = hcolOpen( name, columns, ncolumns )) == NULL )
+	    {
+	      perror( name );
+	      exit(EXIT_FAILURE);
+	    }
+	  free( name );
+	}
+      if( !saved )
+	houtPrintf( w->out, "# %s %s %s %s\n", argv[0], argv[optind],
+		    w->label, argv[optind+2] );
+    }
+  if( ckptName )
+    { /* Filled in by saveState() */
+      free( saved );
+      if( (saved = calloc( 1, size )) == NULL )
+	{
+	  perror( argv[0] );
+	  exit(EXIT_FAILURE);
+	}
+    }
+
+  sink = (SINK) { argv[0], win, nwin, sort, pyr };
+  if( nthreads > 1 && in->map && !follow && !reject && !slide &&
+      !kinematics && !sort && !pyr )
+    { /* Split the mapped file between worker threads */
+      runParallel( in, win, nwin, nthreads, from, to, minSats, &h->gps );
+      if( ckptName && in->size < tail )
+	{ /* Checkpoint at the last whole line, then do the rest */
+	  offset = in->size;
+	  saveState( saved, win, nwin, &h->gps );
+	  hreadRange( in, offset, tail );
+	  runParallel( in, win, nwin, nthreads, from, to, minSats, &h->gps );
+	}
+    }
+  else
+    {
+      for( ;; )
+	{
+	  harborRead( h, in );
+	  if( ckptName && in->size < tail )
+	    { /* Checkpoint at the last whole line, then read the rest */
+	      offset = in->size;
+	      saveState( saved, win, nwin, &h->gps );
+	      hreadRange( in, offset, tail );
+	      continue;
+	    }
+	  if( !follow || stopFollow ) break;
+	  /* Show what we have, then wait for the file to grow */
+	  for( i = 0; i < nwin; i++ ) houtFlush( win[i].out );
+	  if( hreadWait( in ) && errno != EINTR )
+	    {
+	      perror( argv[optind] );
+	      exit(EXIT_FAILURE);
 	    }
-	  else /* Accumulate data for next average */
-	    navg = updateAverage( navg, &raw, &avg );
 	}
     }
-  showAverage( navg, &raw, &avg );
-  fclose( in );
+  /* The last line parsed dates the last averages */
+  raw = h->gps;
+  harborClose( h );
+  if( sort )
+    { /* The records in order of tsecs, without repeats */
+      if( hsortFinish( sort ) )
+	{
+	  perror( argv[0] );
+	  exit(EXIT_FAILURE);
+	}
+      while( (rec = hsortNext( sort )) )
+	{
+	  raw = *(const GPSDATA *) rec;
+	  for( i = 0; i < nwin; i++ ) addRecord( &win[i], &raw );
+	  if( pyr ) hpyrAdd( pyr, raw.tsecs, &raw );
+	}
+      if( sort->err )
+	{
+	  errno = sort->err;
+	  perror( argv[0] );
+	  exit(EXIT_FAILURE);
+	}
+      hstatAdd( stats, HSTAT_RECORDS, -sort->ndup );
+      hstatAdd( stats, HSTAT_DUPLICATES, sort->ndup );
+      hstatAdd( stats, HSTAT_UNORDERED, sort->nout );
+      hstatLap( stats, HSTAT_AVERAGE );
+      hsortClose( sort );
+    }
+  if( ckptName && in->size == end )
+    { /* No partial line: checkpoint at the end */
+      offset = end;
+      saveState( saved, win, nwin, &raw );
+    }
+  for( i = 0; i < nwin; i++ )
+    {
+      w = &win[i];
+      if( !w->slide )
+	showAverage( w->out, w->col, w->kin, w->navg, &raw, &w->avg );
+      free( w->ring );
+      free( w->kin );
+      if( w->col && hcolClose( w->col ) )
+	{
+	  perror( colName );
+	  exit(EXIT_FAILURE);
+	}
+      houtClose( w->out );
+    }
+  if( saved )
+    {
+      if( hckptSave( ckptName, in, offset, config, saved, size ) )
+	{
+	  perror( ckptName );
+	  exit(EXIT_FAILURE);
+	}
+      free( saved );
+    }
+  if( pyr )
+    {
+      if( pyr->nskip )
+	fprintf( stderr, "%s: %lld records out of order left out of %s\n",
+		 argv[0], pyr->nskip, pyrName );
+      if( hpyrClose( pyr ) )
+	{
+	  perror( pyrName );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  if( stats )
+    {
+      hstatLap( stats, HSTAT_FORMAT );
+      hstatReport( stats, stderr, argv[0], argv[optind] );
+      hstatClose( stats );
+    }
+  hreadClose( in );
+  free( win );
+  free( list );
   exit(EXIT_SUCCESS);
 } /* main */
 
+/**
+   Signal handler that ends follow mode.
+   @param[in] sig Signal number.
+*/
+void stopHandler( int sig )
+{
+  stopFollow = 1;
+} /* stopHandler */
+
+/**
+   Take an accepted record from harborRead(): hold it for --sort, or add
+   it to each window and the pyramid.
+   @param[in] ctx SINK.
+   @param[in] rec GPSDATA record, with the full year.
+*/
+void takeRecord( void *ctx, const void *rec )
+{
+  SINK *s = ctx;
+  GPSDATA raw;
+  int i;
+
+  if( s->sort )
+    { /* Reduced in order at the end */
+      if( hsortAdd( s->sort, rec ) )
+	{
+	  perror( s->prog );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  else
+    {
+      raw = *(const GPSDATA *) rec;
+      for( i = 0; i < s->nwin; i++ ) addRecord( &s->win[i], &raw );
+      if( s->pyr ) hpyrAdd( s->pyr, raw.tsecs, &raw );
+    }
+  hstatLap( stats, HSTAT_AVERAGE );
+} /* takeRecord */
+
+/**
+   Take a line, or a run of comment lines, from harborRead() and write it
+   to each window as comments.
+   @param[in] ctx SINK.
+   @param[in] str Lines.
+   @param[in] len Length of the lines.
+   @param[in] nlines Number of lines.
+   @param[in] why HSTAT_* reason, not used.
+*/
+void takeComment( void *ctx, const char *str, size_t len, size_t nlines,
+		  int why )
+{
+  SINK *s = ctx;
+  int i;
+
+  for( i = 0; i < s->nwin; i++ )
+    houtComments( s->win[i].out, str, len, nlines );
+  hstatLap( stats, HSTAT_FORMAT );
+} /* takeComment */
+
+/**
+   Add one accepted record to a window.  Without averaging the record is
+   written out directly; otherwise it is accumulated, and the average of
+   the last period is written when a new period starts.
+   @param[in,out] w Window.
+   @param[in] raw Record.
+*/
+void addRecord( WINDOW *w, GPSDATA *raw )
+{
+  /* Write out as fixed length columns */
+  if( w->avgSecs <= 0.0 ) /* No averaging */
+    {
+      hstatLap( stats, HSTAT_AVERAGE );
+      showRecord( w->out, w->col, w->kin, raw );
+      hstatLap( stats, HSTAT_FORMAT );
+    }
+  else if( w->slide )
+    slideRecord( w, raw );
+  else
+    { /* Average measurements for given number of seconds */
+      if( raw->tsecs-w->t0 > w->avgSecs || w->t0 < 0.0 )
+	{ /* Compute and display average for last period */
+	  hstatLap( stats, HSTAT_AVERAGE );
+	  showAverage( w->out, w->col, w->kin, w->navg, raw, &w->avg );
+	  hstatLap( stats, HSTAT_FORMAT );
+	  w->navg = harborGpsAdd( 0, raw, &w->avg );
+	  w->t0 = raw->tsecs;
+	}
+      else /* Accumulate data for next average */
+	w->navg = harborGpsAdd( w->navg, raw, &w->avg );
+    }
+} /* addRecord */
+
+/**
+   Write one accepted record as fixed length columns.
+   @param[in] out Output buffer.
+   @param[in] col Columnar output, used instead of @a out if not NULL.
+   @param[in,out] kin Last position written, or NULL for no kinematics.
+   @param[in] raw Record to write.
+*/
+void showRecord( HOUT *out, HCOL *col, HKIN *kin, GPSDATA *raw )
+{
+  GPSKIN rk;
+
+  if( kin ) hkinStep( kin, raw->tsecs, raw->lat, raw->lon, raw->alt,
+		      &rk.kin );
+  if( col )
+    {
+      if( kin )
+	{
+	  rk.rec = *raw;
+	  hcolAppend( col, &rk );
+	}
+      else
+	hcolAppend( col, raw );
+      return;
+    }
+
+  showGPS( out, raw );
+  if( kin ) showKinematics( out, &rk.kin );
+  houtChar( out, '\n' );
+} /* showRecord */
+
+/**
+   Write the kinematics columns of a record or average.
+   @param[in] out Output buffer.
+   @param[in] val Kinematics.
+*/
+void showKinematics( HOUT *out, HKINVAL *val )
+{
+  houtChar( out, ' ' );
+  houtFixed( out, val->vrate, 7, 2 );
+  houtChar( out, ' ' );
+  houtFixed( out, val->speed, 7, 2 );
+  houtChar( out, ' ' );
+  houtFixed( out, val->track, 5, 1 );
+} /* showKinematics */
+
+/**
+   Add one accepted record to a sliding window and write the average of
+   the window.  The records more than avgSecs older than the new one are
+   subtracted from the sums and the new one is added, so the work per
+   record is constant on average however many records the window holds.
+   Once as many records have been subtracted as the window holds, the
+   sums are recomputed from the records, so rounding errors do not build
+   up.  The time of day is averaged from the midnight before the oldest
+   record, as harborGpsAdd() does from the first record of a period.
+   @param[in,out] w Window.
+   @param[in] raw Record.
+*/
+void slideRecord( WINDOW *w, GPSDATA *raw )
+{
+  GPSSLOT *s;
+  int i, r;
+
+  if( raw->hour < w->hour ) w->day++; /* rollover */
+  w->hour = raw->hour;
+  while( w->navg > 0 && raw->tsecs-w->ring[w->tail].rec.tsecs > w->avgSecs )
+    { /* Expire the oldest record */
+      slideSum( w, &w->ring[w->tail], -1 );
+      if( ++w->tail == w->maxring ) w->tail = 0;
+      w->nexp++;
+    }
+  if( w->navg == w->maxring )
+    { /* Grow the ring, keeping the records in order from tail */
+      r = w->maxring;
+      w->maxring = r ? 2*r : 1024;
+      if( (w->ring = realloc( w->ring, w->maxring*sizeof(GPSSLOT) )) == NULL )
+	{
+	  perror( "slideRecord" );
+	  exit(EXIT_FAILURE);
+	}
+      memcpy( w->ring+r, w->ring, w->tail*sizeof(GPSSLOT) );
+    }
+  s = &w->ring[(w->tail+w->navg)%w->maxring];
+  s->rec = *raw;
+  s->day = w->day;
+  slideSum( w, s, 1 );
+  if( w->nexp >= w->navg )
+    { /* Recompute the sums from the records */
+      memset( &w->avg, 0, sizeof(GPSSUM) );
+      w->secs = 0;
+      for( i = w->navg, w->navg = 0, r = w->tail; i > 0;
+	   i--, r = (r+1)%w->maxring )
+	slideSum( w, &w->ring[r], 1 );
+      w->nexp = 0;
+    }
+  /* Date, and time of day from its midnight, of the oldest record */
+  s = &w->ring[w->tail];
+  w->avg.mday = s->rec.mday;
+  w->avg.month = s->rec.month;
+  w->avg.year = s->rec.year;
+  w->avg.hour = s->rec.hour;
+  w->avg.todaySecs = w->secs-s->day*86400LL*w->navg;
+  hstatLap( stats, HSTAT_AVERAGE );
+  showAverage( w->out, w->col, w->kin, w->navg, raw, &w->avg );
+  hstatLap( stats, HSTAT_FORMAT );
+} /* slideRecord */
+
+/**
+   Add a record to the sums of a sliding window, or subtract it.
+   @param[in,out] w Window.
+   @param[in] s Record.
+   @param[in] sign 1 to add the record, -1 to subtract it.
+*/
+void slideSum( WINDOW *w, GPSSLOT *s, int sign )
+{
+  if( w->navg+sign == 0 )
+    { /* Empty window: start from zero */
+      memset( &w->avg, 0, sizeof(GPSSUM) );
+      w->secs = 0;
+      w->navg = 0;
+      return;
+    }
+  w->avg.tsecs += sign*s->rec.tsecs;
+  w->avg.lat += sign*s->rec.lat;
+  w->avg.lon += sign*s->rec.lon;
+  w->avg.alt += sign*s->rec.alt;
+  w->avg.nsats += sign*s->rec.nsats;
+  w->secs += sign*(s->day*86400LL+s->rec.hour*3600+s->rec.minute*60+
+		   s->rec.second);
+  w->navg += sign;
+} /* slideSum */
+
 /**
    If one or more data points are available, calculate and display
-   averages to stdout.
+   averages.
+   @param[in] out Output buffer.
+   @param[in] col Columnar output, used instead of @a out if not NULL.
+   @param[in,out] kin Last position written, or NULL for no kinematics.
    @param[in] navg Number of points in average.
    @param[in] raw Last data record, used for time information.
-   @param[in,out] avg Sums to be converted to averages for display.
+   @param[in] avg Sums for the period.
 */
-void showAverage( int navg, GPSDATA *raw, GPSDATA *avg )
+void showAverage( HOUT *out, HCOL *col, HKIN *kin, int navg, GPSDATA *raw,
+		  GPSSUM *avg )
 {
-  int hh, mm, ss, md, mon, yr;
+  GPSWIDE wide;
+  GPSKIN rk;
 
   if( navg < 1 ) return; /* Nothing to do */
 
-  avg->tsecs /= (float) navg;
-  avg->lat /= (float) navg;
-  avg->lon /= (float) navg;
-  avg->alt /= (float) navg;
-  avg->todaySecs /= navg;
-  avg->nsats /= navg;
-  hh = avg->todaySecs/3600;
-  mm = (avg->todaySecs-hh*3600)/60;
-  ss = avg->todaySecs%60;
-  if( hh >= 24 )
-    { /* Use date from latest record */
-      hh -= 24;
-      yr = raw->year;
-      mon = raw->month;
-      md = raw->mday; /* could have a weird day at end of month */
+  harborGpsMean( navg, raw, avg, &wide );
+  if( kin ) hkinStep( kin, wide.tsecs, wide.lat, wide.lon, wide.alt,
+		      &rk.kin );
+  if( col )
+    {
+      rk.rec.tsecs = wide.tsecs;
+      rk.rec.lat = wide.lat;
+      rk.rec.lon = wide.lon;
+      rk.rec.alt = wide.alt;
+      rk.rec.nsats = wide.nsats;
+      hcolAppend( col, &rk );
+      return;
     }
-  else
-    { /* Use date from first record in avg */
-      yr = avg->year;
-      mon = avg->month;
-      md = avg->mday;
-    }
-  printf( "%6.1f %2d %2d %4d %2d %2d %2d %11.7f %12.7f %8.1f %2d %3d\n",
-	  avg->tsecs, md, mon, yr, hh, mm, ss, avg->lat, avg->lon, avg->alt,
-	  avg->nsats, navg );
+  showGPSWide( out, &wide );
+  houtChar( out, ' ' );
+  houtInt( out, navg, 3 );
+  if( kin ) showKinematics( out, &rk.kin );
+  houtChar( out, '\n' );
 } /* showAverage */
 
 /**
-   Adds values from raw to avg.
-   @param[in] navg Number of points in current average.
-   @param[in] raw Raw data values.
-   @param[in,out] avg Sums to be converted to averages by showAverage().
-   @return navg+1.
-*/
-int updateAverage( int navg, GPSDATA *raw, GPSDATA *avg )
-{
-  if( navg < 1 )
-    { /* First data for new average */
-      avg->tsecs = raw->tsecs;
-      avg->mday = raw->mday;    /* Save time of first data point */
-      avg->month = raw->month;
-      avg->year = raw->year;
-      avg->hour = raw->hour;
-      avg->minute = raw->minute;
-      avg->second = raw->second;
-      avg->todaySecs = raw->hour*3600+raw->minute*60+raw->second;
-      avg->lat = raw->lat;
-      avg->lon = raw->lon;
-      avg->alt = raw->alt;
-      avg->nsats = raw->nsats;
-      navg = 0;
+   Process a mapped input file on several threads.  The file is handled in
+   rounds of one CHUNK_BYTES chunk per thread.  Each round the chunks are
+   parsed in parallel, the averaging periods of every window are found
+   with one cheap pass over the record times, the chunks are averaged and
+   formatted in parallel, and the results are merged in order.
+
+   A record's share of the time of day depends only on the first record
+   of its period, which is +24 h if it is at an earlier hour, and the
+   date written with an average past midnight is that of the record
+   after the period.  Both are known once the periods are marked, so
+   every period that starts in a chunk is averaged there; only the
+   records of a period carried in from an earlier chunk are added in
+   the merge, in order.  Write order and the order of every sum match
+   the serial loop in main(), so the output is identical.  The period
+   still open at the end is left in each WINDOW for main() to write,
+   with @a raw set to what the serial loop would have left in its record.
+   @param[in] in Reader with a mapped input file.
+   @param[in,out] win Windows, with their outputs open.
+   @param[in] nwin Number of windows.
+   @param[in] nthreads Number of worker threads.
+   @param[in] from Earliest record time to keep.
+   @param[in] to Latest record time to keep.
+   @param[in] minSats Minimum satellites for a valid record.
+   @param[in,out] raw Record of the serial loop, updated with the last
+   parse.
+*/
+void runParallel( HREADER *in, WINDOW *win, int nwin, int nthreads,
+		  float from, float to, int minSats, GPSDATA *raw )
+{
+  CHUNK *chunk, *c;
+  PART *pt;
+  WINDOW *w;
+  const char *p, *end, *nl;
+  int nchunk, i, j, r;
+
+  if( (chunk = calloc( nthreads, sizeof(CHUNK) )) == NULL )
+    {
+      perror( "runParallel" );
+      exit(EXIT_FAILURE);
     }
-  else
-    { /* Additional data for average */
-      int hh;
-
-      avg->tsecs += raw->tsecs;
-      if( raw->hour < avg->hour ) hh = raw->hour+24; /* rollover */
-      else hh = raw->hour;
-      avg->todaySecs += hh*3600+raw->minute*60+raw->second;
-      avg->lat += raw->lat;
-      avg->lon += raw->lon;
-      avg->alt += raw->alt;
-      avg->nsats += raw->nsats;
-    }
-  return navg+1;
-} /* updateAverage */
+  for( i = 0; i < nthreads; i++ )
+    {
+      c = &chunk[i];
+      c->win = win;
+      c->nwin = nwin;
+      c->from = from;
+      c->to = to;
+      c->minSats = minSats;
+      c->direct = (nwin == 1 && win[0].avgSecs <= 0.0);
+      if( stats && (c->stats = hstatOpen()) == NULL )
+	{
+	  perror( "runParallel" );
+	  exit(EXIT_FAILURE);
+	}
+      if( (c->part = calloc( nwin, sizeof(PART) )) == NULL )
+	{
+	  perror( "runParallel" );
+	  exit(EXIT_FAILURE);
+	}
+      for( j = 0; j < nwin; j++ )
+	{
+	  c->part[j].out = houtOpen( -1 );
+	  if( win[j].col )
+	    c->part[j].col = hcolOpen( NULL, columns, ncolumns );
+	}
+    }
+  p = in->map+in->pos;
+  end = in->map+in->size;
+  while( p < end )
+    {
+      /* Cut the next round of newline-aligned chunks */
+      for( nchunk = 0; nchunk < nthreads && p < end; nchunk++ )
+	{
+	  c = &chunk[nchunk];
+	  c->start = p;
+	  if( end-p <= CHUNK_BYTES ) p = end;
+	  else
+	    {
+	      p += CHUNK_BYTES;
+	      nl = memchr( p-1, '\n', end-(p-1) );
+	      p = nl ? nl+1 : end;
+	    }
+	  c->end = p;
+	}
+      runThreads( parseChunk, chunk, nchunk );
+      if( !chunk[0].direct )
+	{
+	  /* Find where each averaging period starts, as addRecord() would */
+	  for( i = 0; i < nchunk; i++ )
+	    {
+	      c = &chunk[i];
+	      if( c->nrec*nwin > c->maxfirst )
+		{
+		  c->maxfirst = c->nrec*nwin;
+		  if( (c->first = realloc( c->first, c->maxfirst )) == NULL )
+		    {
+		      perror( "runParallel" );
+		      exit(EXIT_FAILURE);
+		    }
+		}
+	      for( j = 0; j < nwin; j++ )
+		{
+		  w = &win[j];
+		  if( w->avgSecs <= 0.0 ) continue;
+		  for( r = 0; r < c->nrec; r++ )
+		    if( (c->first[r*nwin+j] = (c->rec[r].tsecs-w->t0 >
+					       w->avgSecs || w->t0 < 0.0)) )
+		      w->t0 = c->rec[r].tsecs;
+		}
+	    }
+	  runThreads( formatChunk, chunk, nchunk );
+	}
+      for( i = 0; i < nchunk; i++ )
+	{
+	  c = &chunk[i];
+	  for( j = 0; j < nwin; j++ )
+	    {
+	      w = &win[j];
+	      pt = &c->part[j];
+	      if( w->avgSecs > 0.0 )
+		{ /* Finish the period carried in from the previous chunk */
+		  for( r = 0; r < pt->nhead; r++ )
+		    w->navg = harborGpsAdd( w->navg, &c->rec[r], &w->avg );
+		  if( pt->started )
+		    {
+		      houtStr( w->out, pt->out->buf, pt->split );
+		      showAverage( w->out, w->col, NULL, w->navg,
+				   &c->rec[pt->nhead], &w->avg );
+		      houtStr( w->out, pt->out->buf+pt->split,
+			       pt->out->len-pt->split );
+		      w->navg = pt->navg;
+		      w->avg = pt->avg;
+		    }
+		  else
+		    houtStr( w->out, pt->out->buf, pt->out->len );
+		}
+	      else
+		houtStr( w->out, pt->out->buf, pt->out->len );
+	      if( w->col ) hcolMerge( w->col, pt->col );
+	    }
+	  /* The fields the chunk's parses set, in parseGPS() order */
+	  if( c->nlast > 1 ) raw->mday = c->last.mday;
+	  if( c->nlast > 2 ) raw->month = c->last.month;
+	  if( c->nlast > 3 ) raw->year = c->last.year;
+	}
+    }
+
+  for( i = 0; i < nthreads; i++ )
+    {
+      c = &chunk[i];
+      for( j = 0; j < nwin; j++ )
+	{
+	  houtClose( c->part[j].out );
+	  if( c->part[j].col ) hcolClose( c->part[j].col );
+	}
+      if( c->stats )
+	{
+	  hstatMerge( stats, c->stats );
+	  hstatClose( c->stats );
+	}
+      free( c->part );
+      free( c->line );
+      free( c->rec );
+      free( c->first );
+    }
+  free( chunk );
+} /* runParallel */
+
+/**
+   Worker thread: parse the lines of one chunk, as the serial loop in
+   main() does.  With a single window and no averaging the records are
+   formatted directly; otherwise lines and records are saved for
+   formatChunk().
+   @param[in,out] arg CHUNK to process.
+   @return NULL.
+*/
+void *parseChunk( void *arg )
+{
+  CHUNK *c = arg;
+  const char *p;
+  GPSDATA *raw;
+  LINE *l;
+  size_t len, run, nrun;
+  int n;
+
+  c->nline = c->nrec = c->nlast = 0;
+  raw = &c->last;
+  if( c->direct )
+    {
+      c->part[0].out->len = 0;
+      if( c->part[0].col ) hcolReset( c->part[0].col );
+    }
+  if( c->stats ) c->stats->sampled = 0;
+  for( p = c->start; p < c->end; p += len )
+    {
+      len = hreadLineLen( p, c->end-p );
+      hstatLine( c->stats, len );
+      nrun = 1;
+      if( isdigit( *p ) )
+	{
+	  if( (n = parseGPS( p, p+len, raw )) > c->nlast ) c->nlast = n;
+	  if( n != GPS_NFIELDS )
+	    hstatCount( c->stats, p[len-1] == '\n' ? HSTAT_MALFORMED :
+			HSTAT_TRUNCATED );
+	  else if( raw->tsecs < c->from || raw->tsecs > c->to )
+	    { /* Outside --from/--to */
+	      hstatCount( c->stats, HSTAT_RANGE );
+	      continue;
+	    }
+	  else if( raw->nsats < c->minSats )
+	    hstatCount( c->stats, HSTAT_MINSATS );
+	  else
+	    { /* Accepted record */
+	      hstatLap( c->stats, HSTAT_PARSE );
+	      hstatCount( c->stats, HSTAT_RECORDS );
+	      raw->year += 2000; /* Convert to full year */
+	      if( c->direct )
+		{
+		  showRecord( c->part[0].out, c->part[0].col, NULL, raw );
+		  hstatLap( c->stats, HSTAT_FORMAT );
+		  continue;
+		}
+	      if( c->nrec == c->maxrec )
+		c->rec = growArray( c->rec, &c->maxrec, sizeof(GPSDATA) );
+	      c->rec[c->nrec] = *raw;
+	      if( c->nline == c->maxline )
+		c->line = growArray( c->line, &c->maxline, sizeof(LINE) );
+	      l = &c->line[c->nline++];
+	      l->str = p;
+	      l->len = len;
+	      l->rec = c->nrec++;
+	      hstatLap( c->stats, HSTAT_AVERAGE );
+	      continue;
+	    }
+	}
+      else
+	{ /* With the comment lines that follow it */
+	  hstatCount( c->stats, HSTAT_COMMENTS );
+	  if( (run = hreadCommentRun( p, c->end-p, 1, HSTAT_LONGLINE,
+				      &nrun )) > len )
+	    {
+	      hstatComments( c->stats, nrun-1, run-len );
+	      len = run;
+	    }
+	  else
+	    nrun = 1;
+	}
+      /* Comment, short record or too few satellites */
+      if( c->direct )
+	houtComments( c->part[0].out, p, len, nrun );
+      else
+	{
+	  if( c->nline == c->maxline )
+	    c->line = growArray( c->line, &c->maxline, sizeof(LINE) );
+	  l = &c->line[c->nline++];
+	  l->str = p;
+	  l->len = len;
+	  l->rec = -(int) nrun;
+	}
+      hstatLap( c->stats, HSTAT_FORMAT );
+    }
+  return NULL;
+} /* parseChunk */
+
+/**
+   Worker thread: format the parsed lines of one chunk for every window,
+   averaging where requested.  The averaging periods must already be
+   marked in CHUNK::first.
+   @param[in,out] arg CHUNK to process.
+   @return NULL.
+*/
+void *formatChunk( void *arg )
+{
+  CHUNK *c = arg;
+  PART *pt;
+  LINE *l;
+  int i, j, r;
+
+  for( j = 0; j < c->nwin; j++ )
+    {
+      pt = &c->part[j];
+      pt->out->len = 0;
+      if( pt->col ) hcolReset( pt->col );
+      pt->started = pt->nhead = pt->navg = 0;
+      pt->split = 0;
+      for( i = 0; i < c->nline; i++ )
+	{
+	  /* Time one line in HSTAT_SAMPLE, as hstatLine() would */
+	  if( c->stats && (c->stats->sampled = (i & (HSTAT_SAMPLE-1)) == 0) )
+	    c->stats->last = hstatTicks();
+	  l = &c->line[i];
+	  if( (r = l->rec) < 0 )
+	    houtComments( pt->out, l->str, l->len, -r );
+	  else if( c->win[j].avgSecs <= 0.0 ) /* No averaging */
+	    showRecord( pt->out, pt->col, NULL, &c->rec[r] );
+	  else if( c->first[r*c->nwin+j] )
+	    { /* Start of a new period */
+	      if( pt->started ) showAverage( pt->out, pt->col, NULL, pt->navg,
+					     &c->rec[r], &pt->avg );
+	      else
+		{ /* Merge puts the carried-in average here */
+		  pt->split = pt->out->len;
+		  pt->started = 1;
+		}
+	      pt->navg = harborGpsAdd( 0, &c->rec[r], &pt->avg );
+	    }
+	  else if( pt->started )
+	    pt->navg = harborGpsAdd( pt->navg, &c->rec[r], &pt->avg );
+	  else
+	    pt->nhead++;
+	  hstatLap( c->stats, HSTAT_AVERAGE );
+	}
+    }
+  if( c->stats ) c->stats->sampled = 0;
+  return NULL;
+} /* formatChunk */
+
+/**
+   Run one worker thread per chunk and wait for all of them.
+   @param[in] fn Thread function, given a pointer to its CHUNK.
+   @param[in,out] chunk Chunks to process.
+   @param[in] nchunk Number of chunks.
+*/
+void runThreads( void *(*fn)( void * ), CHUNK *chunk, int nchunk )
+{
+  pthread_t tid[nchunk];
+  int i;
+
+  for( i = 0; i < nchunk; i++ )
+    if( pthread_create( &tid[i], NULL, fn, &chunk[i] ) )
+      {
+	perror( "pthread_create" );
+	exit(EXIT_FAILURE);
+      }
+  for( i = 0; i < nchunk; i++ )
+    pthread_join( tid[i], NULL );
+} /* runThreads */
+
+/**
+   Double the size of a growable array.
+   @param[in] ptr Array, or NULL.
+   @param[in,out] max Allocated entries, updated.
+   @param[in] size Size of one entry.
+   @return Reallocated array.  Exits if memory runs out.
+*/
+void *growArray( void *ptr, int *max, size_t size )
+{
+  *max = *max ? 2**max : 1024;
+  if( (ptr = realloc( ptr, *max*size )) == NULL )
+    {
+      perror( "growArray" );
+      exit(EXIT_FAILURE);
+    }
+  return ptr;
+} /* growArray */
+
+/**
+   Load a checkpoint for resuming a run, if there is one that matches the
+   input and options and every -o output it was saved with is still
+   there, at least as long as it was then.
+   @param[in] path Checkpoint file name.
+   @param[in] in Mapped input.
+   @param[in] config hckptHash() of the options.
+   @param[in] win Windows, with their labels.
+   @param[in] nwin Number of windows.
+   @param[in] outName -o file name template.
+   @param[out] offset Input bytes already reduced.
+   @return Saved state, or NULL to start from the beginning.  Exits if the
+   checkpoint cannot be read.
+*/
+SAVED *loadCheckpoint( const char *path, HREADER *in, uint32_t config,
+		       WINDOW *win, int nwin, const char *outName,
+		       size_t *offset )
+{
+  SAVED *saved;
+  struct stat st;
+  char *name;
+  int i, ok;
+
+  if( (saved = hckptLoad( path, in, config,
+			  sizeof(SAVED)+nwin*sizeof(SAVEDWIN),
+			  offset )) == NULL )
+    {
+      if( errno != ENOENT && errno != ESTALE )
+	{
+	  perror( path );
+	  exit(EXIT_FAILURE);
+	}
+      return NULL;
+    }
+  for( i = 0, ok = 1; i < nwin && ok; i++ )
+    {
+      name = houtName( outName, win[i].label );
+      ok = stat( name, &st ) == 0 && st.st_size >= saved->win[i].outSize;
+      free( name );
+    }
+  if( !ok )
+    {
+      free( saved );
+      return NULL;
+    }
+  return saved;
+} /* loadCheckpoint */
+
+/**
+   Save the state of a run for a checkpoint, before the averages of the
+   open periods are written.
+   @param[out] saved State.
+   @param[in] win Windows.
+   @param[in] nwin Number of windows.
+   @param[in] raw Last record parsed.
+*/
+void saveState( SAVED *saved, WINDOW *win, int nwin, GPSDATA *raw )
+{
+  int i;
+
+  saved->raw = *raw;
+  for( i = 0; i < nwin; i++ )
+    {
+      saved->win[i].outSize = houtTell( win[i].out );
+      saved->win[i].t0 = win[i].t0;
+      saved->win[i].navg = win[i].navg;
+      saved->win[i].avg = win[i].avg;
+      if( win[i].kin ) saved->win[i].kin = *win[i].kin;
+    }
+} /* saveState */
@@ -0,0 +1,209 @@
+/** @file hidx.c
+    @brief
+    Sidecar time index for Harbor CSV files.
+
+    @details
+    The index is built with one pass over the mapped input that converts
+    only the first field of each record.  It is written to a temporary
+    file and renamed into place, so a reader never sees a partial index;
+    if it cannot be written (a read-only directory, say) it is simply used
+    from memory.  A stale or damaged index is rebuilt.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "hcsv.h"
+#include "hidx.h"
+
+/**
+   Read an index file and check it against the input.
+   @param[in] name Index file name.
+   @param[in] st Status of the input file.
+   @param[out] n Number of entries.
+   @return Allocated entries, or NULL if the index is missing or stale.
+*/
+static HIDXENTRY *loadIndex( const char *name, const struct stat *st,
+			     uint64_t *n )
+{
+  HIDXHEADER hdr;
+  HIDXENTRY *e;
+  struct stat ist;
+  ssize_t len;
+  int fd;
+
+  if( (fd = open( name, O_RDONLY )) < 0 ) return NULL;
+  e = NULL;
+  if( fstat( fd, &ist ) == 0 &&
+      read( fd, &hdr, sizeof(hdr) ) == sizeof(hdr) &&
+      memcmp( hdr.magic, HIDX_MAGIC, sizeof(HIDX_MAGIC) ) == 0 &&
+      hdr.version == HIDX_VERSION && hdr.byteOrder == HIDX_BYTEORDER &&
+      hdr.fileSize == (uint64_t) st->st_size &&
+      hdr.mtimeSec == st->st_mtim.tv_sec &&
+      hdr.mtimeNsec == st->st_mtim.tv_nsec && hdr.nentries > 0 &&
+      (uint64_t) ist.st_size ==
+      sizeof(hdr)+hdr.nentries*sizeof(HIDXENTRY) &&
+      (e = malloc( hdr.nentries*sizeof(HIDXENTRY) )) != NULL )
+    {
+      len = hdr.nentries*sizeof(HIDXENTRY);
+      if( read( fd, e, len ) != len )
+	{
+	  free( e );
+	  e = NULL;
+	}
+      *n = hdr.nentries;
+    }
+  close( fd );
+  return e;
+} /* loadIndex */
+
+/**
+   Build the index of a mapped file.  Blocks start at the same line
+   boundaries hreadLine() finds.
+   @param[in] map Mapped file.
+   @param[in] size Size of the file.
+   @param[out] n Number of entries.
+   @return Allocated entries, or NULL if memory runs out.
+*/
+static HIDXENTRY *buildIndex( const char *map, size_t size, uint64_t *n )
+{
+  HIDXENTRY *e, *cur;
+  const char *p;
+  size_t pos, len, next;
+  uint64_t max;
+  float t;
+
+  max = size/HIDX_STRIDE+2;
+  if( (e = malloc( max*sizeof(HIDXENTRY) )) == NULL ) return NULL;
+  cur = NULL;
+  *n = 0;
+  for( pos = next = 0; pos < size; pos += len )
+    {
+      if( pos >= next )
+	{ /* Start a new block */
+	  cur = &e[(*n)++];
+	  cur->offset = pos;
+	  cur->tmin = HUGE_VALF;
+	  cur->tmax = -HUGE_VALF;
+	  next = pos+HIDX_STRIDE;
+	}
+      len = hreadLineLen( map+pos, size-pos );
+      p = map+pos;
+      if( isdigit( *p ) && hcsvFloat( &p, map+pos+len, &t ) )
+	{
+	  if( t < cur->tmin ) cur->tmin = t;
+	  if( t > cur->tmax ) cur->tmax = t;
+	}
+    }
+  return e;
+} /* buildIndex */
+
+/**
+   Write an index file, replacing any old one.  Failures are ignored; the
+   index is then rebuilt next time.
+   @param[in] name Index file name.
+   @param[in] st Status of the input file.
+   @param[in] e Entries.
+   @param[in] n Number of entries.
+*/
+static void saveIndex( const char *name, const struct stat *st,
+		       const HIDXENTRY *e, uint64_t n )
+{
+  HIDXHEADER hdr;
+  char *tmp;
+  size_t len;
+  int fd, ok;
+
+  if( (tmp = malloc( strlen( name )+8 )) == NULL ) return;
+  sprintf( tmp, "%s.XXXXXX", name );
+  if( (fd = mkstemp( tmp )) < 0 )
+    {
+      free( tmp );
+      return;
+    }
+  memset( &hdr, 0, sizeof(hdr) );
+  memcpy( hdr.magic, HIDX_MAGIC, sizeof(HIDX_MAGIC) );
+  hdr.version = HIDX_VERSION;
+  hdr.byteOrder = HIDX_BYTEORDER;
+  hdr.fileSize = st->st_size;
+  hdr.mtimeSec = st->st_mtim.tv_sec;
+  hdr.mtimeNsec = st->st_mtim.tv_nsec;
+  hdr.nentries = n;
+  len = n*sizeof(HIDXENTRY);
+  ok = write( fd, &hdr, sizeof(hdr) ) == sizeof(hdr) &&
+    write( fd, e, len ) == (ssize_t) len;
+  fchmod( fd, 0644 );
+  if( close( fd ) == 0 && ok && rename( tmp, name ) == 0 )
+    {
+      free( tmp );
+      return;
+    }
+  unlink( tmp );
+  free( tmp );
+} /* saveIndex */
+
+/**
+   Find the part of a mapped input file that holds the records with
+   @a from <= tsecs <= @a to, using and if needed building its sidecar
+   index.  The range may also hold records outside the times asked for,
+   which the caller must still skip.
+   @param[in] path Input file name.
+   @param[in] rd Reader from hreadOpen() on the same file.
+   @param[in] from Earliest time wanted.
+   @param[in] to Latest time wanted.
+   @param[out] start Offset of the first line to read.
+   @param[out] end Offset just past the last line to read.
+   @return 0 on success, or -1 with errno set if the reader is not mapped
+   or memory runs out.
+*/
+int hidxRange( const char *path, HREADER *rd, float from, float to,
+	       size_t *start, size_t *end )
+{
+  HIDXENTRY *e;
+  struct stat st;
+  char *name;
+  uint64_t n, first, last;
+
+  if( rd->map == NULL )
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  if( fstat( rd->fd, &st ) ) return -1;
+  if( (name = malloc( strlen( path )+sizeof(HIDX_SUFFIX) )) == NULL )
+    return -1;
+  strcat( strcpy( name, path ), HIDX_SUFFIX );
+  if( (e = loadIndex( name, &st, &n )) == NULL )
+    {
+      if( (e = buildIndex( rd->map, rd->mapSize, &n )) == NULL )
+	{
+	  free( name );
+	  return -1;
+	}
+      saveIndex( name, &st, e, n );
+    }
+  free( name );
+
+  /* From the first block that reaches from to the last that reaches to */
+  for( first = 0; first < n && !(e[first].tmax >= from); first++ )
+    ;
+  for( last = n; last > first && !(e[last-1].tmin <= to); last-- )
+    ;
+  *start = first < n ? e[first].offset : rd->mapSize;
+  *end = last < n ? e[last].offset : rd->mapSize;
+  if( last <= first ) *end = *start;
+  free( e );
+  return 0;
+} /* hidxRange */
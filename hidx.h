@@ -0,0 +1,69 @@
+/** @file hidx.h
+    @brief
+    Sidecar time index for Harbor CSV files.
+
+    @details
+    A sparse index maps record times to byte offsets so that a time range
+    can be read without parsing the whole file.  The index for input.csv
+    is kept next to it as input.csv.hidx, built on first use and reused
+    while the size and modification time of the input are unchanged.  The
+    layout, in the byte order of the machine that wrote it, is:
+    @verbatim
+    HIDXHEADER                 48 bytes at offset 0
+    HIDXENTRY[nentries]        16 bytes each, in file order
+    @endverbatim
+    Each entry covers the lines from its offset up to the next entry's
+    offset (the last one to the end of the file), and holds the smallest
+    and largest tsecs of the records in them, so the index stays correct
+    even if the times are not in order.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#ifndef HIDX_H
+#define HIDX_H
+#include <stddef.h>
+#include <stdint.h>
+#include "hread.h"
+
+#define HIDX_MAGIC "HARBIDX"    ///< File magic, NUL padded to 8 bytes
+#define HIDX_VERSION 1          ///< Format version
+#define HIDX_BYTEORDER 0x01020304 ///< Byte order mark
+#define HIDX_SUFFIX ".hidx"     ///< Appended to the input file name
+
+/**
+   Approximate bytes of input covered by one index entry.
+*/
+#define HIDX_STRIDE (64<<10)
+
+/**
+   Index file header.
+*/
+typedef struct
+{
+  char magic[8];       ///< HIDX_MAGIC
+  uint32_t version;    ///< HIDX_VERSION
+  uint32_t byteOrder;  ///< HIDX_BYTEORDER as written
+  uint64_t fileSize;   ///< Size of the indexed file
+  int64_t mtimeSec;    ///< Modification time of the indexed file
+  int64_t mtimeNsec;   ///< Nanoseconds part of the modification time
+  uint64_t nentries;   ///< Number of entries
+} HIDXHEADER;
+
+/**
+   Index entry for one block of whole lines.
+*/
+typedef struct
+{
+  uint64_t offset;     ///< File offset of the first line in the block
+  float tmin, tmax;    ///< Range of record times in the block
+} HIDXENTRY;
+
+int hidxRange( const char *path, HREADER *rd, float from, float to,
+	       size_t *start, size_t *end );
+
+#endif /* HIDX_H */
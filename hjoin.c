@@ -0,0 +1,238 @@
+/** @file hjoin.c
+    @brief
+    Join Harbor GPS and sensor data on time.
+
+    @details
+    The hjoin program reads a Harbor GPS file and a sensor file in CSV
+    format at the same time, both in tsecs order, and writes each sensor
+    record with the GPS position at its tsecs.  The position is linearly
+    interpolated between the GPS records before and after the sensor
+    record, or taken from the nearest one.  Sensor records before the
+    first or after the last GPS record get the position of that record.
+    Both files are streamed once, so the join takes time proportional to
+    the sum of their sizes.
+    @verbatim
+    Compile: gcc -Wall -O2 -o hjoin hjoin.c hrec.c hcsv.c hread.c hout.c hcol.c
+             -pthread -lz
+    Use: hjoin [-n] [-c output.hcol] gps.csv sensor.csv min_sats
+               > output.txt
+    @endverbatim
+    @arg @c -n uses the nearest GPS record instead of interpolating
+    @arg @c -c @c output.hcol writes the joined records to a binary
+    columnar file (see hcol.h) instead of text columns; comments still go
+    to stdout
+    @arg @c gps.csv is the Harbor GPS CSV data file, or - for standard
+    input
+    @arg @c sensor.csv is the Harbor sensor CSV data file.  Either file
+    may be gzip or zstd compressed (see hread.h).
+    @arg @c min_sats is the minimum number of satellites for a GPS record
+    to be used
+
+    The output columns are those of hsensor followed by latitude,
+    longitude, altitude and the number of satellites of the nearest GPS
+    record.  Lines of the sensor file that are not records are written as
+    comments starting with '#'; the GPS file's comments are dropped.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Read gzip and zstd compressed input.
+    2026-Oct-14 Take the sensor columns from the hrec field table.
+    @endverbatim
+*/
+/**
+   Code modification date
+*/
+#define CODE_MOD_DATE "Mod_Date:2026-Oct-14"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stddef.h>
+#include <ctype.h>
+#include "hread.h"
+#include "hout.h"
+#include "hcol.h"
+#include "hrec.h"
+
+/**
+   Sensor record with the GPS position at its time.
+*/
+typedef struct
+{
+  SENSORDATA s;        ///< Sensor record
+  float lat, lon, alt; ///< GPS position, deg north, deg east, m above MSL
+  int nsats;           ///< Satellites in view at the nearest GPS record
+} JOINDATA;
+
+/**
+   Columns written with -c.
+*/
+#define HREC_OFFSET( name ) offsetof(JOINDATA, s.name)
+static const HCOLDEF joinColumns[] =
+  {
+    HREC_COLUMNS( HREC_SENSOR_FIELDS )
+    { "lat", "deg", HCOL_FLOAT32, offsetof(JOINDATA, lat) },
+    { "lon", "deg", HCOL_FLOAT32, offsetof(JOINDATA, lon) },
+    { "alt", "m", HCOL_FLOAT32, offsetof(JOINDATA, alt) },
+    { "nsats", "count", HCOL_INT32, offsetof(JOINDATA, nsats) }
+  };
+#undef HREC_OFFSET
+
+/**
+   Number of columns written with -c.
+*/
+#define JOIN_NCOLS ((int) (sizeof(joinColumns)/sizeof(joinColumns[0])))
+
+int nextGPS( HREADER *in, int minSats, GPSDATA *raw );
+
+int main( int argc, char **argv )
+{
+  int minSats, nearest, have0, have1, c, bad;
+  const char *str, *colName;
+  size_t len;
+  double f, lat, lon, alt;
+  HREADER *gpsIn, *sensorIn;
+  HOUT *out;
+  HCOL *col;
+  GPSDATA g0, g1, *g;
+  JOINDATA rec;
+
+  nearest = bad = 0;
+  colName = NULL;
+  while( (c = getopt( argc, argv, "nc:" )) != -1 )
+    switch( c )
+      {
+      case 'n':
+	nearest = 1;
+	break;
+      case 'c':
+	colName = optarg;
+	break;
+      default:
+	bad = 1;
+	break;
+      }
+  if( argc-optind != 3 || bad )
+    {
+      fprintf( stderr, "Use: %s [-n] [-c output.hcol] gps.csv sensor.csv "
+	       "min_sats > output.txt\n", argv[0] );
+      fprintf( stderr, "[%s]\n", CODE_MOD_DATE );
+      exit(EXIT_FAILURE);
+    }
+  /* Open input files, CSV format */
+  if( (gpsIn = hreadOpen( argv[optind] )) == NULL )
+    {
+      perror( argv[optind] );
+      exit(EXIT_FAILURE);
+    }
+  if( (sensorIn = hreadOpen( argv[optind+1] )) == NULL )
+    {
+      perror( argv[optind+1] );
+      exit(EXIT_FAILURE);
+    }
+  col = NULL;
+  if( colName &&
+      (col = hcolOpen( colName, joinColumns, JOIN_NCOLS )) == NULL )
+    {
+      perror( colName );
+      exit(EXIT_FAILURE);
+    }
+  minSats = atoi( argv[optind+2] );
+  out = houtOpen( STDOUT_FILENO );
+  houtPrintf( out, "# %s %s %s %s\n", argv[0], argv[optind], argv[optind+1],
+	      argv[optind+2] );
+  have0 = 0;
+  if( !(have1 = nextGPS( gpsIn, minSats, &g1 )) )
+    {
+      fprintf( stderr, "%s: no GPS records with %d or more satellites\n",
+	       argv[optind], minSats );
+      exit(EXIT_FAILURE);
+    }
+
+  /* Read through sensor file; process lines that start with a digit. */
+  while( hreadLine( sensorIn, &str, &len ) )
+    {
+      if( !isdigit( *str ) ||
+	  parseSensor( str, str+len, &rec.s ) != SENSOR_NFIELDS )
+	{ /* Not a data record */
+	  houtComment( out, str, len );
+	  continue;
+	}
+      /* Advance so g0 <= tsecs < g1 */
+      while( have1 && g1.tsecs <= rec.s.tsecs )
+	{
+	  g0 = g1;
+	  have0 = 1;
+	  have1 = nextGPS( gpsIn, minSats, &g1 );
+	}
+      if( !have0 ) g = &g1; /* Before the first GPS record */
+      else if( !have1 ) g = &g0; /* After the last one */
+      else g = (rec.s.tsecs-g0.tsecs <= g1.tsecs-rec.s.tsecs) ? &g0 : &g1;
+      if( nearest || !have0 || !have1 )
+	{
+	  lat = g->lat;
+	  lon = g->lon;
+	  alt = g->alt;
+	}
+      else
+	{ /* Linear interpolation */
+	  f = (rec.s.tsecs-g0.tsecs)/(double) (g1.tsecs-g0.tsecs);
+	  lat = g0.lat+f*(g1.lat-g0.lat);
+	  lon = g0.lon+f*(g1.lon-g0.lon);
+	  alt = g0.alt+f*(g1.alt-g0.alt);
+	}
+      rec.nsats = g->nsats;
+      if( col )
+	{
+	  rec.lat = lat;
+	  rec.lon = lon;
+	  rec.alt = alt;
+	  hcolAppend( col, &rec );
+	  continue;
+	}
+      showSensor( out, &rec.s );
+      houtChar( out, ' ' );
+      houtFixed( out, lat, 11, 7 );
+      houtChar( out, ' ' );
+      houtFixed( out, lon, 12, 7 );
+      houtChar( out, ' ' );
+      houtFixed( out, alt, 8, 1 );
+      houtChar( out, ' ' );
+      houtInt( out, rec.nsats, 2 );
+      houtChar( out, '\n' );
+    }
+  if( col && hcolClose( col ) )
+    {
+      perror( colName );
+      exit(EXIT_FAILURE);
+    }
+  houtClose( out );
+  hreadClose( gpsIn );
+  hreadClose( sensorIn );
+  exit(EXIT_SUCCESS);
+} /* main */
+
+/**
+   Read the next usable GPS record, skipping comments, incomplete records
+   and records with too few satellites.
+   @param[in,out] in GPS file reader.
+   @param[in] minSats Minimum number of satellites.
+   @param[out] raw Record.
+   @return 1 if a record was read, 0 at end of file.
+*/
+int nextGPS( HREADER *in, int minSats, GPSDATA *raw )
+{
+  const char *str;
+  size_t len;
+
+  while( hreadLine( in, &str, &len ) )
+    if( isdigit( *str ) && parseGPS( str, str+len, raw ) == GPS_NFIELDS &&
+	raw->nsats >= minSats )
+      {
+	raw->year += 2000; /* Convert to full year */
+	return 1;
+      }
+  return 0;
+} /* nextGPS */
@@ -0,0 +1,77 @@
+/** @file hkin.c
+    @brief
+    Ascent rate, ground speed and track from consecutive GPS positions.
+
+    @details
+    See hkin.h for the method.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#include <math.h>
+#include "hkin.h"
+
+/**
+   WGS-84 semi-major axis, metres.
+*/
+#define HKIN_A 6378137.0
+
+/**
+   WGS-84 first eccentricity squared.
+*/
+#define HKIN_E2 6.69437999014e-3
+
+/**
+   Radians per degree.
+*/
+#define HKIN_RAD (M_PI/180.0)
+
+/**
+   Difference one position with the last one, and make it the last one.
+   @param[in,out] k State, all zero before the first position.
+   @param[in] tsecs Time of the position, seconds.
+   @param[in] lat Latitude, degrees north.
+   @param[in] lon Longitude, degrees east.
+   @param[in] alt Altitude, metres.
+   @param[out] val Kinematics of the step to this position, NaN if none.
+*/
+void hkinStep( HKIN *k, double tsecs, double lat, double lon, double alt,
+	       HKINVAL *val )
+{
+  double dt, de, dn, mid, s, w;
+
+  val->vrate = val->speed = val->track = NAN;
+  mid = k->started ? 0.5*(lat+k->lat) : lat;
+  if( !k->started || fabs( mid-k->lat0 ) > HKIN_RESCALE )
+    { /* Radii of curvature at the middle of the step */
+      s = sin( mid*HKIN_RAD );
+      w = 1.0-HKIN_E2*s*s;
+      k->kn = HKIN_A*(1.0-HKIN_E2)/(w*sqrt( w ))*HKIN_RAD;
+      k->ke = HKIN_A/sqrt( w )*cos( mid*HKIN_RAD )*HKIN_RAD;
+      k->lat0 = mid;
+    }
+  if( k->started && (dt = tsecs-k->tsecs) > 0.0 )
+    {
+      dn = (lat-k->lat)*k->kn;
+      de = lon-k->lon;
+      if( de > 180.0 ) de -= 360.0; /* across the antimeridian */
+      else if( de < -180.0 ) de += 360.0;
+      de *= k->ke;
+      val->vrate = (alt-k->alt)/dt;
+      val->speed = sqrt( de*de+dn*dn )/dt;
+      if( de != 0.0 || dn != 0.0 )
+	{
+	  s = atan2( de, dn )/HKIN_RAD;
+	  val->track = s < 0.0 ? s+360.0 : s;
+	}
+    }
+  k->started = 1;
+  k->tsecs = tsecs;
+  k->lat = lat;
+  k->lon = lon;
+  k->alt = alt;
+} /* hkinStep */
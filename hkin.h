@@ -0,0 +1,63 @@
+/** @file hkin.h
+    @brief
+    Ascent rate, ground speed and track from consecutive GPS positions.
+
+    @details
+    Each position is differenced with the one before it in a local east,
+    north, up tangent plane: the changes of latitude and longitude are
+    scaled to metres by the WGS-84 meridian and prime vertical radii of
+    curvature at a reference latitude, so a step costs a few multiplies
+    instead of the trigonometry of a great circle distance.  The scales
+    are recomputed only when the middle of a step is HKIN_RESCALE degrees
+    of latitude from the reference, which keeps their error near one
+    part in 10^5 at mid latitudes, and the steps between fixes are short
+    enough that the curvature of the Earth across one of them does not
+    matter.
+
+    The values for a position are those of the step that ends there.
+    The first position, and one whose time is not after that of the
+    position before, such as the start of a new dataset, have none
+    (NaN); the track of a step without horizontal motion is NaN too.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#ifndef HKIN_H
+#define HKIN_H
+
+/**
+   Degrees of latitude the reference may be from the middle of a step
+   before the scales are recomputed.
+*/
+#define HKIN_RESCALE 0.001
+
+/**
+   State of the differencing: the last position and the scales.
+*/
+typedef struct
+{
+  int started;             ///< Nonzero once a position has been given
+  double tsecs;            ///< Time of the last position, seconds
+  double lat, lon, alt;    ///< Last position, degrees and metres
+  double lat0;             ///< Reference latitude of the scales
+  double kn, ke;           ///< Metres per degree north and east at lat0
+} HKIN;
+
+/**
+   Kinematics of one step.
+*/
+typedef struct
+{
+  float vrate;             ///< Ascent rate, m/s
+  float speed;             ///< Ground speed, m/s
+  float track;             ///< Direction of motion, degrees east of north
+} HKINVAL;
+
+void hkinStep( HKIN *k, double tsecs, double lat, double lon, double alt,
+	       HKINVAL *val );
+
+#endif /* HKIN_H */
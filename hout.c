@@ -0,0 +1,553 @@
+/** @file hout.c
+    @brief
+    Buffered fixed-width output formatter for hgps and hsensor.
+
+    @details
+    houtFixed() converts a double exactly: the binary value m*2^e is
+    scaled by 10^prec in 128-bit integer arithmetic and rounded half to
+    even, which is what glibc printf() does in the default rounding mode.
+    Values too large for that, infinities and NaNs go through vsnprintf().
+
+    After houtAsync() the buffer is one of HOUT_NBUFS blocks: a full
+    block is handed to the writer thread on a HRING and a written one
+    taken back from another, so formatting continues while the previous
+    block is written, and only waits when the writer is HOUT_NBUFS-1
+    blocks behind.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added houtAsync().
+    2026-Oct-14 Added houtTell() and houtResume().
+    2026-Oct-14 Added houtComments().
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include "hout.h"
+#include "hring.h"
+
+/**
+   One output block of a writer thread.
+*/
+struct HOUTBLOCK
+{
+  char *buf;   ///< Text
+  size_t len;  ///< Bytes of text
+  size_t size; ///< Allocated size
+};
+
+/**
+   Writer thread and its blocks.  Full blocks go to the thread on full
+   and come back written on free; the block being filled is HOUT::buf.
+*/
+struct HOUTPIPE
+{
+  pthread_t thread;                 ///< Writer thread
+  HRING full;                       ///< Blocks to write, then a NULL
+  HRING free;                       ///< Written blocks
+  struct HOUTBLOCK blk[HOUT_NBUFS]; ///< Blocks
+  struct HOUTBLOCK *cur;            ///< Block being filled
+  int fd;                           ///< Output file descriptor
+};
+
+/**
+   Powers of ten for the supported precisions.
+*/
+static const unsigned long long pow10tab[10] =
+  {
+    1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+    10000000ULL, 100000000ULL, 1000000000ULL
+  };
+
+/**
+   Write all of a block of bytes to a file descriptor.
+   @param[in] fd File descriptor.
+   @param[in] p Bytes to write.
+   @param[in] len Number of bytes.
+*/
+static void writeAll( int fd, const char *p, size_t len )
+{
+  ssize_t n;
+
+  for( ; len > 0; p += n, len -= n )
+    if( (n = write( fd, p, len )) < 0 )
+      {
+	if( errno == EINTR )
+	  n = 0;
+	else
+	  {
+	    perror( "write" );
+	    exit(EXIT_FAILURE);
+	  }
+      }
+} /* writeAll */
+
+/**
+   Writer thread: write full blocks in order until a NULL arrives.
+   @param[in,out] arg Writer.
+   @return NULL.
+*/
+static void *writer( void *arg )
+{
+  struct HOUTPIPE *pp = arg;
+  struct HOUTBLOCK *b;
+
+  while( (b = hringGet( &pp->full )) != NULL )
+    {
+      writeAll( pp->fd, b->buf, b->len );
+      hringPut( &pp->free, b );
+    }
+  return NULL;
+} /* writer */
+
+/**
+   Make room for at least @a n more bytes, writing out or growing the
+   buffer as needed.
+   @param[in,out] out Output buffer.
+   @param[in] n Bytes needed.
+*/
+static void houtReserve( HOUT *out, size_t n )
+{
+  if( out->size-out->len >= n ) return;
+  if( out->fd >= 0 )
+    {
+      houtFlush( out );
+      if( out->size >= n ) return;
+    }
+  while( out->size-out->len < n ) out->size *= 2;
+  if( (out->buf = realloc( out->buf, out->size )) == NULL )
+    {
+      perror( "houtReserve" );
+      exit(EXIT_FAILURE);
+    }
+} /* houtReserve */
+
+/**
+   Create an output buffer.
+   @param[in] fd File descriptor to write to, or -1 to keep the text in
+   memory (see HOUT::buf and HOUT::len).
+   @return Output buffer.  Exits if memory runs out.
+*/
+HOUT *houtOpen( int fd )
+{
+  HOUT *out;
+
+  if( (out = malloc( sizeof(HOUT) )) == NULL ||
+      (out->buf = malloc( HOUT_BUFSIZE )) == NULL )
+    {
+      perror( "houtOpen" );
+      exit(EXIT_FAILURE);
+    }
+  out->fd = fd;
+  out->len = 0;
+  out->size = HOUT_BUFSIZE;
+  out->owner = 0;
+  out->pipe = NULL;
+  out->pos = 0;
+  return out;
+} /* houtOpen */
+
+/**
+   Start a writer thread for an output buffer, so that later flushes
+   hand the text to the thread instead of waiting for write().  Text
+   reaches the file in the same order.  Only the writing moves: text is
+   still formatted by the caller, into the block being filled.
+   @param[in,out] out Output buffer on a file descriptor.
+   @return 0 on success, or -1 with errno set (EINVAL for a memory
+   buffer).
+*/
+int houtAsync( HOUT *out )
+{
+  struct HOUTPIPE *pp;
+  int i, err;
+
+  if( out->fd < 0 || out->pipe )
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  if( (pp = calloc( 1, sizeof(struct HOUTPIPE) )) == NULL ) return -1;
+  pp->fd = out->fd;
+  pp->cur = &pp->blk[0];
+  err = ENOMEM;
+  for( i = 1; i < HOUT_NBUFS; i++ )
+    {
+      if( (pp->blk[i].buf = malloc( HOUT_BUFSIZE )) == NULL ) goto fail;
+      pp->blk[i].size = HOUT_BUFSIZE;
+    }
+  /* Room for every block and the NULL */
+  if( hringInit( &pp->full, HOUT_NBUFS+1 ) ) goto fail;
+  if( hringInit( &pp->free, HOUT_NBUFS ) )
+    {
+      hringDestroy( &pp->full );
+      goto fail;
+    }
+  for( i = 1; i < HOUT_NBUFS; i++ ) hringPut( &pp->free, &pp->blk[i] );
+  if( (err = pthread_create( &pp->thread, NULL, writer, pp )) != 0 )
+    {
+      hringDestroy( &pp->full );
+      hringDestroy( &pp->free );
+      goto fail;
+    }
+  out->pipe = pp;
+  return 0;
+
+ fail:
+  for( i = 1; i < HOUT_NBUFS; i++ ) free( pp->blk[i].buf );
+  free( pp );
+  errno = err;
+  return -1;
+} /* houtAsync */
+
+/**
+   Create an output file and a buffer for it.  houtClose() closes the file.
+   @param[in] path File name; an existing file is truncated.
+   @return Output buffer, or NULL with errno set if the file cannot be
+   created.
+*/
+HOUT *houtCreate( const char *path )
+{
+  HOUT *out;
+  int fd;
+
+  if( (fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) < 0 )
+    return NULL;
+  out = houtOpen( fd );
+  out->owner = 1;
+  return out;
+} /* houtCreate */
+
+/**
+   Reopen an output file to append to it, first truncating it to the
+   size it had at an earlier houtTell().  houtClose() closes the file.
+   @param[in] path File name.
+   @param[in] size Size to truncate the file to.
+   @return Output buffer, or NULL with errno set: ESTALE if the file is
+   shorter than @a size, having been changed since.
+*/
+HOUT *houtResume( const char *path, long long size )
+{
+  struct stat st;
+  HOUT *out;
+  int fd, err;
+
+  if( (fd = open( path, O_WRONLY )) < 0 ) return NULL;
+  if( fstat( fd, &st ) ) err = errno;
+  else if( st.st_size < size ) err = ESTALE;
+  else if( ftruncate( fd, size ) || lseek( fd, size, SEEK_SET ) < 0 )
+    err = errno;
+  else
+    {
+      out = houtOpen( fd );
+      out->owner = 1;
+      out->pos = size;
+      return out;
+    }
+  close( fd );
+  errno = err;
+  return NULL;
+} /* houtResume */
+
+/**
+   Build an output file name from a template by replacing the first "%s"
+   with a label, for example "flight_%s.txt" and "60" give
+   "flight_60.txt".
+   @param[in] tmpl File name template.
+   @param[in] label Replacement for "%s".
+   @return Allocated file name, or a copy of @a tmpl if it has no "%s".
+*/
+char *houtName( const char *tmpl, const char *label )
+{
+  const char *pct;
+  char *name;
+  size_t n;
+
+  pct = strstr( tmpl, "%s" );
+  n = pct ? pct-tmpl : strlen( tmpl );
+  if( (name = malloc( strlen( tmpl )+strlen( label )+1 )) == NULL )
+    {
+      perror( "houtName" );
+      exit(EXIT_FAILURE);
+    }
+  memcpy( name, tmpl, n );
+  name[n] = '\0';
+  if( pct ) strcat( strcat( name, label ), pct+2 );
+  return name;
+} /* houtName */
+
+/**
+   Write out the buffered text.  Does nothing for a memory buffer.
+   @param[in,out] out Output buffer.
+*/
+void houtFlush( HOUT *out )
+{
+  struct HOUTPIPE *pp = out->pipe;
+
+  if( out->fd < 0 ) return;
+  out->pos += out->len;
+  if( pp == NULL )
+    writeAll( out->fd, out->buf, out->len );
+  else if( out->len > 0 )
+    { /* Hand the block to the writer and take an empty one */
+      pp->cur->buf = out->buf;
+      pp->cur->len = out->len;
+      pp->cur->size = out->size;
+      hringPut( &pp->full, pp->cur );
+      pp->cur = hringGet( &pp->free );
+      out->buf = pp->cur->buf;
+      out->size = pp->cur->size;
+    }
+  out->len = 0;
+} /* houtFlush */
+
+/**
+   Flush and release an output buffer.  The file descriptor is left open
+   unless the buffer came from houtCreate().
+   @param[in] out Output buffer from houtOpen() or houtCreate().
+*/
+void houtClose( HOUT *out )
+{
+  struct HOUTPIPE *pp = out->pipe;
+  int i;
+
+  houtFlush( out );
+  if( pp )
+    { /* Wait for the writer to finish */
+      hringPut( &pp->full, NULL );
+      pthread_join( pp->thread, NULL );
+      for( i = 0; i < HOUT_NBUFS; i++ )
+	if( &pp->blk[i] != pp->cur ) free( pp->blk[i].buf );
+      hringDestroy( &pp->full );
+      hringDestroy( &pp->free );
+      free( pp );
+    }
+  if( out->owner && close( out->fd ) )
+    {
+      perror( "close" );
+      exit(EXIT_FAILURE);
+    }
+  free( out->buf );
+  free( out );
+} /* houtClose */
+
+/**
+   Append bytes.
+   @param[in,out] out Output buffer.
+   @param[in] str Bytes to append.
+   @param[in] len Number of bytes.
+*/
+void houtStr( HOUT *out, const char *str, size_t len )
+{
+  size_t n;
+
+  if( out->pipe )
+    for( ; len > out->size-out->len; str += n, len -= n )
+      { /* Fill and hand off whole blocks, keeping the writes in order */
+	n = out->size-out->len;
+	memcpy( out->buf+out->len, str, n );
+	out->len += n;
+	houtFlush( out );
+      }
+  else if( out->fd >= 0 && len >= out->size )
+    { /* Too big to be worth copying */
+      houtFlush( out );
+      writeAll( out->fd, str, len );
+      out->pos += len;
+      return;
+    }
+  houtReserve( out, len );
+  memcpy( out->buf+out->len, str, len );
+  out->len += len;
+} /* houtStr */
+
+/**
+   Append an input line as a comment, same as printf( "# %s", str ).
+   @param[in,out] out Output buffer.
+   @param[in] str Line, including its newline if any.
+   @param[in] len Length of the line.
+*/
+void houtComment( HOUT *out, const char *str, size_t len )
+{
+  const char *nul;
+
+  if( (nul = memchr( str, '\0', len )) != NULL ) len = nul-str;
+  houtReserve( out, len+2 );
+  out->buf[out->len++] = '#';
+  out->buf[out->len++] = ' ';
+  memcpy( out->buf+out->len, str, len );
+  out->len += len;
+} /* houtComment */
+
+/**
+   Append a run of input lines as comments, the same as houtComment() on
+   each but without looking for NULs.
+   @param[in,out] out Output buffer.
+   @param[in] str Lines, each ending in a newline except perhaps the last.
+   @param[in] len Length of the lines.
+   @param[in] nlines Number of lines.  One line may hold a NUL, as for
+   houtComment(); the lines of a longer run, from hreadCommentRun(), may
+   not.
+*/
+void houtComments( HOUT *out, const char *str, size_t len, size_t nlines )
+{
+  const char *nl;
+  size_t n;
+
+  if( nlines <= 1 )
+    {
+      houtComment( out, str, len );
+      return;
+    }
+  for( ; len > 0; str += n, len -= n )
+    {
+      nl = memchr( str, '\n', len );
+      n = nl ? nl-str+1 : len;
+      houtReserve( out, n+2 );
+      out->buf[out->len] = '#';
+      out->buf[out->len+1] = ' ';
+      memcpy( out->buf+out->len+2, str, n );
+      out->len += n+2;
+    }
+} /* houtComments */
+
+/**
+   Append printf()-formatted text, for headers and other output that is not
+   on the per-record path.
+   @param[in,out] out Output buffer.
+   @param[in] fmt printf() format.
+*/
+void houtPrintf( HOUT *out, const char *fmt, ... )
+{
+  va_list ap;
+  int n;
+
+  houtReserve( out, 256 );
+  va_start( ap, fmt );
+  n = vsnprintf( out->buf+out->len, out->size-out->len, fmt, ap );
+  va_end( ap );
+  if( n < 0 ) return;
+  if( (size_t) n >= out->size-out->len )
+    {
+      houtReserve( out, n+1 );
+      va_start( ap, fmt );
+      vsnprintf( out->buf+out->len, out->size-out->len, fmt, ap );
+      va_end( ap );
+    }
+  out->len += n;
+} /* houtPrintf */
+
+/**
+   Append an integer, same as printf( "%*d", width, val ).
+   @param[in,out] out Output buffer.
+   @param[in] val Value.
+   @param[in] width Minimum field width.
+*/
+void houtInt( HOUT *out, int val, int width )
+{
+  char tmp[16], *p;
+  unsigned int u;
+  int len;
+
+  u = val < 0 ? -(unsigned int) val : (unsigned int) val;
+  p = tmp+sizeof(tmp);
+  do
+    *--p = '0'+u%10;
+  while( (u /= 10) );
+  if( val < 0 ) *--p = '-';
+  len = tmp+sizeof(tmp)-p;
+  houtReserve( out, (len > width ? len : width) );
+  for( ; width > len; width-- ) out->buf[out->len++] = ' ';
+  memcpy( out->buf+out->len, p, len );
+  out->len += len;
+} /* houtInt */
+
+/**
+   Scale a double to a correctly rounded integer number of 10^-prec units.
+   @param[in] val Value.
+   @param[in] prec Digits after the decimal point, 0-9.
+   @param[out] neg Nonzero if the sign bit is set.
+   @param[out] n Rounded |val|*10^prec.
+   @return 1 on success, 0 if the value is out of range or not finite.
+*/
+static int fixedDigits( double val, int prec, int *neg,
+			unsigned long long *n )
+{
+#ifdef __SIZEOF_INT128__
+  unsigned long long bits, m;
+  unsigned __int128 t, r, half;
+  int e;
+
+  memcpy( &bits, &val, sizeof(bits) );
+  *neg = bits>>63;
+  e = (bits>>52) & 0x7ff;
+  m = bits & ((1ULL<<52)-1);
+  if( e == 0x7ff ) return 0; /* Inf or NaN */
+  if( e == 0 ) e = 1; /* Subnormal */
+  else m |= 1ULL<<52;
+  e -= 1075; /* val = m*2^e */
+  t = (unsigned __int128) m*pow10tab[prec];
+  if( e >= 0 )
+    {
+      if( e > 40 ) return 0;
+      t <<= e;
+    }
+  else if( e <= -128 )
+    t = 0; /* Far below half a unit */
+  else
+    { /* Divide by 2^-e, round half to even */
+      half = (unsigned __int128) 1<<(-e-1);
+      r = t & ((half<<1)-1);
+      t >>= -e;
+      if( r > half || (r == half && (t & 1)) ) t++;
+    }
+  if( t>>64 ) return 0;
+  *n = (unsigned long long) t;
+  return 1;
+#else
+  return 0;
+#endif
+} /* fixedDigits */
+
+/**
+   Append a fixed-point number, same as printf( "%*.*f", width, prec, val ).
+   @param[in,out] out Output buffer.
+   @param[in] val Value.
+   @param[in] width Minimum field width.
+   @param[in] prec Digits after the decimal point.
+*/
+void houtFixed( HOUT *out, double val, int width, int prec )
+{
+  char tmp[32], *p;
+  unsigned long long n, ip, fp;
+  int neg, len, i;
+
+  if( prec < 0 || prec > 9 || !fixedDigits( val, prec, &neg, &n ) )
+    {
+      houtPrintf( out, "%*.*f", width, prec, val );
+      return;
+    }
+  ip = n/pow10tab[prec];
+  fp = n%pow10tab[prec];
+  p = tmp+sizeof(tmp);
+  for( i = 0; i < prec; i++, fp /= 10 ) *--p = '0'+fp%10;
+  if( prec > 0 ) *--p = '.';
+  do
+    *--p = '0'+ip%10;
+  while( (ip /= 10) );
+  if( neg ) *--p = '-';
+  len = tmp+sizeof(tmp)-p;
+  houtReserve( out, (len > width ? len : width) );
+  for( ; width > len; width-- ) out->buf[out->len++] = ' ';
+  memcpy( out->buf+out->len, p, len );
+  out->len += len;
+} /* houtFixed */
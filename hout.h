@@ -0,0 +1,100 @@
+/** @file hout.h
+    @brief
+    Buffered fixed-width output formatter for hgps and hsensor.
+
+    @details
+    Output is collected in a large user-space buffer and written with a
+    few big write() calls instead of one locked stdio call per record.
+    houtFixed() and houtInt() produce exactly the text printf() produces
+    for "%*.*f" and "%*d".  A buffer opened on fd -1 only grows in memory,
+    which the parallel modes use to format chunks before merging them.
+    houtCreate() and houtName() open per-window output files.
+    houtAsync() moves the write() calls to a writer thread, so formatting
+    goes on while the previous buffer is written.  The formatting itself
+    stays on the thread that calls houtFixed() and the rest, which has the
+    records, window state and comments of the tool in the order they are
+    written; the parallel modes already format on their workers.
+    houtResume() reopens an output to append to it after truncating it
+    back to an earlier size, as found with houtTell(), for resuming from a
+    checkpoint.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added houtAsync().
+    2026-Oct-14 Added houtTell() and houtResume().
+    2026-Oct-14 Added houtComments().
+    2026-Oct-14 Noted where formatting runs with houtAsync().
+    @endverbatim
+*/
+#ifndef HOUT_H
+#define HOUT_H
+#include <stddef.h>
+
+/**
+   Output buffer size; the buffer is written out when it fills.
+*/
+#define HOUT_BUFSIZE (1<<20)
+
+/**
+   Number of buffers of an output with a writer thread.
+*/
+#define HOUT_NBUFS 3
+
+/**
+   Writer thread of an output, private to hout.c.
+*/
+struct HOUTPIPE;
+
+/**
+   Output buffer.  Use houtOpen() to create one.
+*/
+typedef struct
+{
+  int fd;      ///< Output file descriptor, -1 for a memory buffer
+  char *buf;   ///< Buffered text
+  size_t len;  ///< Bytes in the buffer
+  size_t size; ///< Allocated size of the buffer
+  int owner;   ///< Nonzero if houtClose() closes fd
+  struct HOUTPIPE *pipe; ///< Writer thread, NULL to write directly
+  long long pos;         ///< File offset of buf, bytes flushed so far
+} HOUT;
+
+HOUT *houtOpen( int fd );
+HOUT *houtCreate( const char *path );
+HOUT *houtResume( const char *path, long long size );
+int houtAsync( HOUT *out );
+char *houtName( const char *tmpl, const char *label );
+void houtFlush( HOUT *out );
+void houtClose( HOUT *out );
+void houtStr( HOUT *out, const char *str, size_t len );
+void houtComment( HOUT *out, const char *str, size_t len );
+void houtComments( HOUT *out, const char *str, size_t len, size_t nlines );
+void houtPrintf( HOUT *out, const char *fmt, ... );
+void houtInt( HOUT *out, int val, int width );
+void houtFixed( HOUT *out, double val, int width, int prec );
+
+/**
+   Append one character.
+   @param[in,out] out Output buffer.
+   @param[in] c Character to append.
+*/
+static inline void houtChar( HOUT *out, char c )
+{
+  if( out->len == out->size ) houtStr( out, &c, 1 );
+  else out->buf[out->len++] = c;
+} /* houtChar */
+
+/**
+   Get the size the output will have once the buffered text is written.
+   @param[in] out Output buffer.
+   @return Size in bytes.
+*/
+static inline long long houtTell( const HOUT *out )
+{
+  return out->pos+out->len;
+} /* houtTell */
+
+#endif /* HOUT_H */
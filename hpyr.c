@@ -0,0 +1,429 @@
+/** @file hpyr.c
+    @brief
+    Pyramids of pre-aggregated averaging periods for zoomable plots.
+
+    @details
+    See hpyr.h.  When the period of a level ends it is written to the
+    level's buffer and added to the open period of the level above,
+    which ends in turn when a period of another index comes, so each
+    record costs one addition per field and each level the same again
+    for every HPYR_FACTOR periods below it.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "hpyr.h"
+
+/**
+   Size of each level buffer.
+*/
+#define HPYR_BUFSIZE (64<<10)
+
+/**
+   Round a file offset up to the level alignment.
+*/
+#define HPYR_ALIGN(x) (((x)+63) & ~(uint64_t) 63)
+
+static int writeAt( int fd, const char *p, size_t len, off_t off );
+static void endPeriod( HPYR *p, int k );
+
+/**
+   Write a block at a file offset.
+   @return 0 on success, -1 on failure with errno set.
+*/
+static int writeAt( int fd, const char *p, size_t len, off_t off )
+{
+  ssize_t n;
+
+  for( ; len > 0; p += n, len -= n, off += n )
+    if( (n = pwrite( fd, p, len, off )) < 0 )
+      {
+	if( errno != EINTR ) return -1;
+	n = 0;
+      }
+  return 0;
+} /* writeAt */
+
+/**
+   Create pyramid output.
+   @param[in] path Output file name.
+   @param[in] base Period of level 0, s.
+   @param[in] def Fields to sum, HCOL_INT32 or HCOL_FLOAT32; must stay
+   valid until hpyrClose().
+   @param[in] nfields Number of fields.
+   @return Pyramid output, or NULL with errno set on failure.
+*/
+HPYR *hpyrOpen( const char *path, double base, const HCOLDEF *def,
+		int nfields )
+{
+  HPYR *p;
+  char *tmp;
+  int k, err;
+
+  if( !(base > 0.0) || nfields < 1 )
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+  if( (p = calloc( 1, sizeof(HPYR) )) == NULL ||
+      (tmp = malloc( strlen( path )+8 )) == NULL )
+    {
+      perror( "hpyrOpen" );
+      exit(EXIT_FAILURE);
+    }
+  p->def = def;
+  p->nfields = nfields;
+  p->base = base;
+  p->psize = sizeof(HPYRPERIOD)+nfields*sizeof(double);
+  for( k = 0; k < HPYR_MAXLEVELS; k++ )
+    {
+      p->level[k].fd = -1;
+      if( (p->level[k].sum = calloc( nfields, sizeof(double) )) == NULL ||
+	  (p->level[k].buf = malloc( HPYR_BUFSIZE )) == NULL )
+	{
+	  perror( "hpyrOpen" );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  if( (p->fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0666 )) < 0 )
+    goto fail;
+  for( k = 0; k < HPYR_MAXLEVELS; k++ )
+    { /* Temporary files next to the output, removed when closed */
+      sprintf( tmp, "%s.XXXXXX", path );
+      if( (p->level[k].fd = mkstemp( tmp )) < 0 ) goto fail;
+      unlink( tmp );
+    }
+  free( tmp );
+  return p;
+
+ fail:
+  err = errno;
+  free( tmp );
+  hpyrClose( p );
+  errno = err;
+  return NULL;
+} /* hpyrOpen */
+
+/**
+   Add one record to the period of level 0 holding its time.
+   @param[in,out] p Pyramid output.
+   @param[in] tsecs Time of the record, s.
+   @param[in] rec Record with the fields described by HPYR::def.
+*/
+void hpyrAdd( HPYR *p, double tsecs, const void *rec )
+{
+  HPYRBUF *lb = &p->level[0];
+  const char *v;
+  int64_t index;
+  int i;
+
+  if( isnan( tsecs ) )
+    {
+      p->nskip++;
+      return;
+    }
+  index = (int64_t) floor( tsecs/p->base );
+  if( lb->open.count > 0 && index != lb->open.index )
+    {
+      if( index < lb->open.index )
+	{ /* Late: its period is written already */
+	  p->nskip++;
+	  return;
+	}
+      endPeriod( p, 0 );
+    }
+  if( lb->open.count == 0 )
+    {
+      lb->open.index = index;
+      memset( lb->sum, 0, p->nfields*sizeof(double) );
+    }
+  for( i = 0; i < p->nfields; i++ )
+    {
+      v = (const char *) rec+p->def[i].offset;
+      lb->sum[i] += p->def[i].type == HCOL_INT32 ?
+	(double) *(const int32_t *) v : (double) *(const float *) v;
+    }
+  lb->open.count++;
+} /* hpyrAdd */
+
+/**
+   Write the open period of a level, add it to the level above and leave
+   the level with no open period.
+   @param[in,out] p Pyramid output.
+   @param[in] k Level, with an open period.
+*/
+static void endPeriod( HPYR *p, int k )
+{
+  HPYRBUF *lb = &p->level[k], *up;
+  int64_t index;
+  int i;
+
+  if( HPYR_BUFSIZE-lb->len < p->psize )
+    { /* Spill to the temporary file */
+      if( writeAt( lb->fd, lb->buf, lb->len, lseek( lb->fd, 0, SEEK_END ) ) )
+	{
+	  perror( "hpyr" );
+	  exit(EXIT_FAILURE);
+	}
+      lb->len = 0;
+    }
+  memcpy( lb->buf+lb->len, &lb->open, sizeof(HPYRPERIOD) );
+  memcpy( lb->buf+lb->len+sizeof(HPYRPERIOD), lb->sum,
+	  p->nfields*sizeof(double) );
+  lb->len += p->psize;
+  lb->count++;
+  if( k+1 < HPYR_MAXLEVELS )
+    {
+      up = &p->level[k+1];
+      index = lb->open.index/HPYR_FACTOR;
+      if( lb->open.index%HPYR_FACTOR < 0 ) index--; /* Round down */
+      if( up->open.count > 0 && index != up->open.index ) endPeriod( p, k+1 );
+      if( up->open.count == 0 )
+	{
+	  up->open.index = index;
+	  memset( up->sum, 0, p->nfields*sizeof(double) );
+	}
+      for( i = 0; i < p->nfields; i++ ) up->sum[i] += lb->sum[i];
+      up->open.count += lb->open.count;
+    }
+  lb->open.count = 0;
+} /* endPeriod */
+
+/**
+   End the open periods, write the header and levels, and release the
+   output.  Levels above the first one with a single period are left out.
+   @param[in] p Pyramid output from hpyrOpen().
+   @return 0 on success, -1 with errno set if the file could not be
+   written.
+*/
+int hpyrClose( HPYR *p )
+{
+  HPYRHEADER hdr;
+  HPYRFIELD fld;
+  HPYRLEVEL lev;
+  HPYRBUF *lb;
+  uint64_t off;
+  ssize_t n;
+  off_t pos;
+  int i, k, nlevels, status, err;
+
+  status = 0;
+  if( p->fd >= 0 )
+    {
+      for( k = 0; k < HPYR_MAXLEVELS; k++ )
+	if( p->level[k].open.count > 0 ) endPeriod( p, k );
+      for( nlevels = 1; nlevels < HPYR_MAXLEVELS &&
+	     p->level[nlevels-1].count > 1; nlevels++ )
+	;
+      memset( &hdr, 0, sizeof(hdr) );
+      strncpy( hdr.magic, HPYR_MAGIC, sizeof(hdr.magic) );
+      hdr.version = HPYR_VERSION;
+      hdr.byteOrder = HPYR_BYTEORDER;
+      hdr.nfields = p->nfields;
+      hdr.nlevels = nlevels;
+      hdr.factor = HPYR_FACTOR;
+      hdr.headerSize = sizeof(HPYRHEADER)+p->nfields*sizeof(HPYRFIELD)+
+	nlevels*sizeof(HPYRLEVEL);
+      hdr.base = p->base;
+      status = writeAt( p->fd, (char *) &hdr, sizeof(hdr), 0 );
+      for( i = 0; i < p->nfields && status == 0; i++ )
+	{
+	  memset( &fld, 0, sizeof(fld) );
+	  strncpy( fld.name, p->def[i].name, sizeof(fld.name)-1 );
+	  strncpy( fld.units, p->def[i].units, sizeof(fld.units)-1 );
+	  status = writeAt( p->fd, (char *) &fld, sizeof(fld),
+			    sizeof(hdr)+i*sizeof(fld) );
+	}
+      off = HPYR_ALIGN(hdr.headerSize);
+      for( k = 0; k < nlevels && status == 0; k++ )
+	{
+	  lb = &p->level[k];
+	  memset( &lev, 0, sizeof(lev) );
+	  lev.secs = p->base*pow( HPYR_FACTOR, k );
+	  lev.count = lb->count;
+	  lev.offset = off;
+	  status = writeAt( p->fd, (char *) &lev, sizeof(lev),
+			    sizeof(hdr)+p->nfields*sizeof(fld)+
+			    k*sizeof(lev) );
+
+	  /* Spill what is left, then copy the level into place */
+	  if( status == 0 )
+	    status = writeAt( lb->fd, lb->buf, lb->len,
+			      lseek( lb->fd, 0, SEEK_END ) );
+	  for( pos = 0; status == 0; pos += n )
+	    {
+	      if( (n = pread( lb->fd, lb->buf, HPYR_BUFSIZE, pos )) == 0 )
+		break;
+	      if( n < 0 )
+		{
+		  if( errno != EINTR ) status = -1;
+		  n = 0;
+		  continue;
+		}
+	      status = writeAt( p->fd, lb->buf, n, off+pos );
+	    }
+	  off += HPYR_ALIGN(lb->count*p->psize);
+	}
+      if( status == 0 && ftruncate( p->fd, off ) ) status = -1;
+    }
+
+  err = errno;
+  if( p->fd >= 0 && close( p->fd ) && status == 0 )
+    {
+      status = -1;
+      err = errno;
+    }
+  for( k = 0; k < HPYR_MAXLEVELS; k++ )
+    {
+      if( p->level[k].fd >= 0 ) close( p->level[k].fd );
+      free( p->level[k].sum );
+      free( p->level[k].buf );
+    }
+  free( p );
+  errno = err;
+  return status;
+} /* hpyrClose */
+
+/**
+   Map a pyramid file for reading, and check its layout.
+   @param[in] path File name.
+   @return Mapped file, or NULL with errno set: EINVAL if it is not a
+   pyramid file of this version and byte order, or is cut short.
+*/
+HPYRMAP *hpyrMap( const char *path )
+{
+  HPYRMAP *m;
+  struct stat st;
+  void *map;
+  int fd, k, ok, err;
+
+  if( (fd = open( path, O_RDONLY )) < 0 ) return NULL;
+  if( fstat( fd, &st ) || (size_t) st.st_size < sizeof(HPYRHEADER) )
+    {
+      err = (size_t) st.st_size < sizeof(HPYRHEADER) ? EINVAL : errno;
+      close( fd );
+      errno = err;
+      return NULL;
+    }
+  map = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+  err = errno;
+  close( fd );
+  if( map == MAP_FAILED )
+    {
+      errno = err;
+      return NULL;
+    }
+  if( (m = calloc( 1, sizeof(HPYRMAP) )) == NULL )
+    {
+      munmap( map, st.st_size );
+      errno = ENOMEM;
+      return NULL;
+    }
+  m->map = map;
+  m->size = st.st_size;
+  m->hdr = (const HPYRHEADER *) map;
+  ok = memcmp( m->hdr->magic, HPYR_MAGIC, sizeof(HPYR_MAGIC) ) == 0 &&
+    m->hdr->version == HPYR_VERSION &&
+    m->hdr->byteOrder == HPYR_BYTEORDER &&
+    m->hdr->nfields > 0 && m->hdr->nlevels > 0 &&
+    m->hdr->nlevels <= HPYR_MAXLEVELS && m->hdr->nfields < 4096 &&
+    m->hdr->headerSize == sizeof(HPYRHEADER)+
+    m->hdr->nfields*sizeof(HPYRFIELD)+m->hdr->nlevels*sizeof(HPYRLEVEL) &&
+    m->hdr->headerSize <= m->size;
+  if( ok )
+    {
+      m->field = (const HPYRFIELD *) (m->map+sizeof(HPYRHEADER));
+      m->level = (const HPYRLEVEL *) (m->field+m->hdr->nfields);
+      m->psize = sizeof(HPYRPERIOD)+m->hdr->nfields*sizeof(double);
+      for( k = 0; k < (int) m->hdr->nlevels && ok; k++ )
+	ok = m->level[k].offset % 8 == 0 && m->level[k].offset <= m->size &&
+	  m->level[k].count <= (m->size-m->level[k].offset)/m->psize;
+    }
+  if( !ok )
+    {
+      hpyrUnmap( m );
+      errno = EINVAL;
+      return NULL;
+    }
+  return m;
+} /* hpyrMap */
+
+/**
+   Choose the level to serve a resolution from: the one with the longest
+   period no longer than @a secs, or level 0 if all are longer.
+   @param[in] m Mapped file.
+   @param[in] secs Period wanted, s.
+   @return Level.
+*/
+int hpyrLevel( const HPYRMAP *m, double secs )
+{
+  int k;
+
+  for( k = m->hdr->nlevels-1; k > 0; k-- )
+    if( m->level[k].secs <= secs*(1.0+1e-9) ) break;
+  return k;
+} /* hpyrLevel */
+
+/**
+   Find the first period of a level that ends after a time, by binary
+   search.
+   @param[in] m Mapped file.
+   @param[in] level Level.
+   @param[in] tsecs Time, s.
+   @return Period number within the level, HPYRLEVEL::count if there is
+   none.
+*/
+uint64_t hpyrFind( const HPYRMAP *m, int level, double tsecs )
+{
+  uint64_t lo, hi, mid;
+  double index;
+
+  index = floor( tsecs/m->level[level].secs );
+  lo = 0;
+  hi = m->level[level].count;
+  while( lo < hi )
+    {
+      mid = lo+(hi-lo)/2;
+      if( hpyrPeriod( m, level, mid )->index < index ) lo = mid+1;
+      else hi = mid;
+    }
+  return lo;
+} /* hpyrFind */
+
+/**
+   Get one period of a level.  Its sums follow it, as double
+   sums[HPYRHEADER::nfields] at (const double *) (period+1).
+   @param[in] m Mapped file.
+   @param[in] level Level.
+   @param[in] i Period number within the level, less than
+   HPYRLEVEL::count.
+   @return Period.
+*/
+const HPYRPERIOD *hpyrPeriod( const HPYRMAP *m, int level, uint64_t i )
+{
+  return (const HPYRPERIOD *) (m->map+m->level[level].offset+i*m->psize);
+} /* hpyrPeriod */
+
+/**
+   Release a mapped file.
+   @param[in] m Mapped file, or NULL.
+*/
+void hpyrUnmap( HPYRMAP *m )
+{
+  if( m == NULL ) return;
+  munmap( (void *) m->map, m->size );
+  free( m );
+} /* hpyrUnmap */
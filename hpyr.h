@@ -0,0 +1,162 @@
+/** @file hpyr.h
+    @brief
+    Pyramids of pre-aggregated averaging periods for zoomable plots.
+
+    @details
+    A pyramid file holds the sums and counts of the records of a flight
+    over periods of several lengths at once, so a plot can be redrawn at
+    any zoom from the level nearest its resolution without reducing the
+    raw data again.  Level 0 has periods of the base length, 1 s by
+    default, and each level after it has periods HPYR_FACTOR times as
+    long: 1 s, 4 s, 16 s and so on, up to the first level left with a
+    single period.  Periods are aligned to multiples of their length in
+    tsecs, so period i of a level starts at i*secs and holds exactly
+    periods HPYR_FACTOR*i to HPYR_FACTOR*i+HPYR_FACTOR-1 of the level
+    below; each level is summed from the periods of the level below, not
+    from the records.  Periods without records are left out.  The
+    average of a field over a period is its sum divided by the count, and
+    the average over any run of periods is found the same way from their
+    totals.
+
+    The records must come in tsecs order, as they do through --sort;
+    hpyrAdd() leaves out a record from before the period it is filling, or
+    one whose tsecs is not a number, and counts it.  The levels are written
+    to unlinked temporary files next to the output, as hcol does its
+    columns, and copied into place by hpyrClose(), so memory use does not
+    grow with the input.  All values are in the byte order of the machine
+    that wrote the file; the layout is:
+    @verbatim
+    HPYRHEADER                 48 bytes at offset 0
+    HPYRFIELD[nfields]         32 bytes each, right after the header
+    HPYRLEVEL[nlevels]         24 bytes each, right after the fields
+    periods of each level      HPYRLEVEL::count periods in order of
+                               index, each an HPYRPERIOD and nfields
+                               double sums, starting at HPYRLEVEL::offset
+                               (64-byte aligned)
+    @endverbatim
+    For example, with numpy on a machine of the same byte order:
+    @verbatim
+    h = numpy.fromfile( f, [('magic','S8'),('version','=u4'),('order','=u4'),
+        ('nfields','=u4'),('nlevels','=u4'),('factor','=u4'),
+        ('hsize','=u4'),('base','=f8'),('spare','=u8')], 1 )[0]
+    l = numpy.fromfile( f, [('secs','=f8'),('count','=u8'),('offset','=u8')],
+        h['nlevels'], offset=48+32*h['nfields'] )
+    p = numpy.memmap( f, [('index','=i8'),('count','=i8'),
+        ('sum','=f8',h['nfields'])], 'r', int( l['offset'][k] ),
+        l['count'][k] )
+    @endverbatim
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    @endverbatim
+*/
+#ifndef HPYR_H
+#define HPYR_H
+#include <stddef.h>
+#include <stdint.h>
+#include "hcol.h"
+
+#define HPYR_MAGIC "HARBPYR"    ///< File magic, NUL padded to 8 bytes
+#define HPYR_VERSION 1          ///< Format version
+#define HPYR_BYTEORDER 0x01020304 ///< Byte order mark
+#define HPYR_FACTOR 4           ///< Periods of a level in one of the next
+#define HPYR_MAXLEVELS 16       ///< Most levels in a file
+
+/**
+   File header.
+*/
+typedef struct
+{
+  char magic[8];       ///< HPYR_MAGIC
+  uint32_t version;    ///< HPYR_VERSION
+  uint32_t byteOrder;  ///< HPYR_BYTEORDER as written
+  uint32_t nfields;    ///< Number of fields summed
+  uint32_t nlevels;    ///< Number of levels
+  uint32_t factor;     ///< HPYR_FACTOR
+  uint32_t headerSize; ///< Bytes of header, fields and levels
+  double base;         ///< Period of level 0, s
+  uint64_t spare;      ///< Zero
+} HPYRHEADER;
+
+/**
+   Field descriptor in the file.
+*/
+typedef struct
+{
+  char name[16];   ///< Field name, NUL padded
+  char units[16];  ///< Units, NUL padded
+} HPYRFIELD;
+
+/**
+   Level descriptor in the file.
+*/
+typedef struct
+{
+  double secs;     ///< Period, s
+  uint64_t count;  ///< Periods with records
+  uint64_t offset; ///< File offset of the first period
+} HPYRLEVEL;
+
+/**
+   One period of a level, followed in the file by the sums of its fields.
+*/
+typedef struct
+{
+  int64_t index;   ///< Period number: it starts at index*secs
+  int64_t count;   ///< Records summed
+} HPYRPERIOD;
+
+/**
+   Period being summed for one level while writing, and the periods done.
+*/
+typedef struct
+{
+  HPYRPERIOD open; ///< Period being summed, count 0 before the first
+  double *sum;     ///< Sums of the open period
+  uint64_t count;  ///< Periods written
+  char *buf;       ///< Periods waiting to be written
+  size_t len;      ///< Bytes in the buffer
+  int fd;          ///< Unlinked temporary file holding the level
+} HPYRBUF;
+
+/**
+   Pyramid output.  Use hpyrOpen() to create one.
+*/
+typedef struct
+{
+  int fd;                         ///< Output file
+  const HCOLDEF *def;             ///< Fields, taken from each record
+  int nfields;                    ///< Number of fields
+  double base;                    ///< Period of level 0, s
+  size_t psize;                   ///< Bytes per period in the file
+  HPYRBUF level[HPYR_MAXLEVELS];  ///< Levels
+  long long nskip;                ///< Records left out: late, or no tsecs
+} HPYR;
+
+/**
+   Mapped pyramid file, for reading.  Use hpyrMap() to create one.
+*/
+typedef struct
+{
+  const char *map;          ///< File contents
+  size_t size;              ///< File size
+  const HPYRHEADER *hdr;    ///< Header
+  const HPYRFIELD *field;   ///< Field descriptors
+  const HPYRLEVEL *level;   ///< Level descriptors
+  size_t psize;             ///< Bytes per period
+} HPYRMAP;
+
+HPYR *hpyrOpen( const char *path, double base, const HCOLDEF *def,
+		int nfields );
+void hpyrAdd( HPYR *p, double tsecs, const void *rec );
+int hpyrClose( HPYR *p );
+HPYRMAP *hpyrMap( const char *path );
+int hpyrLevel( const HPYRMAP *m, double secs );
+uint64_t hpyrFind( const HPYRMAP *m, int level, double tsecs );
+const HPYRPERIOD *hpyrPeriod( const HPYRMAP *m, int level, uint64_t i );
+void hpyrUnmap( HPYRMAP *m );
+
+#endif /* HPYR_H */
@@ -0,0 +1,915 @@
+/** @file hread.c
+    @brief
+    Line reader for Harbor CSV files.
+
+    @details
+    A regular file is mapped read-only with a sequential access hint, and
+    hreadLine() walks the line boundaries in place.  Anything that cannot
+    be mapped is read through the read-ahead ring below, except an empty
+    file, or standard input from a file, which is read with getline().
+    In follow mode the mapping is used for the data already in the file and
+    then read() continues from the same offset.  Only complete lines are
+    returned, so a record the writer has not finished is held back until
+    its newline arrives.  hreadWait() sleeps on inotify where available,
+    otherwise it polls with a backoff from 10 ms to HREAD_MAXWAIT.
+
+    A compressed file, a pipe or standard input from a pipe is read with
+    read() by a reader thread, decompressing if need be, and hreadLine()
+    returns spans into the last buffer it took; only a line that
+    straddles two buffers is copied.  Buffers go round a pair of HRING
+    rings, filled ones to hreadLine() and read ones back to the thread,
+    so the two threads share no lock and wait only when the other is
+    HREAD_ZBUFS buffers behind.  A mapped file needs no reader thread:
+    the kernel's read-ahead for the sequential hint fills the page cache
+    while the lines are parsed.  gzip needs zlib (-lz); zstd is built in with
+    -DHREAD_ZSTD and -lzstd, and without it a zstd file fails to open with
+    ENOTSUP.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added follow mode.
+    2026-Oct-14 Added hreadRange().
+    2026-Oct-14 Added compressed input.
+    2026-Oct-14 Reader thread and lock-free rings for pipes too.
+    2026-Oct-14 Lines of any length, in a growing line buffer.
+    2026-Oct-14 Block scan for runs of comment lines.
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <zlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef HREAD_ZSTD
+#include <zstd.h>
+#endif
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "hread.h"
+#include "hring.h"
+
+/**
+   First poll delay in milliseconds when inotify is not available.
+*/
+#define HREAD_MINWAIT 10
+
+/**
+   Compressed data read from the file at a time.
+*/
+#define HREAD_ZINSIZE (256<<10)
+
+/**
+   Input formats read through the ring: compressed ones recognised by
+   hreadOpen(), and plain data from a pipe.
+*/
+enum { HREAD_GZIP = 1, HREAD_ZSTD_FMT, HREAD_RAW };
+
+/**
+   One buffer of the ring.
+*/
+struct HZBUF
+{
+  char *data;                    ///< Data
+  size_t len;                    ///< Bytes of data
+};
+
+/**
+   Read-ahead ring.  The reader thread takes empty buffers from freed,
+   fills them and puts them on filled, then a NULL at the end of the
+   data, while hreadLine() walks the lines of the buffer it took last
+   and hands it back, so parsing overlaps reading and decompression.
+*/
+struct HZRING
+{
+  pthread_t thread;              ///< Reader thread
+  HRING filled;                  ///< Filled buffers, to hreadLine()
+  HRING freed;                   ///< Empty buffers, to the thread
+  struct HZBUF buf[HREAD_ZBUFS]; ///< Buffers
+  struct HZBUF *cur;             ///< Buffer being read, or NULL
+  int done;                      ///< Nonzero once the NULL is taken
+  int err;                       ///< Nonzero if the data were bad
+  atomic_int stop;               ///< Nonzero to stop the thread
+  size_t cpos, clen;             ///< Next line and end of data in cur
+  int format;                    ///< HREAD_GZIP, HREAD_ZSTD_FMT or
+                                 ///< HREAD_RAW
+  int fd;                        ///< Compressed input
+  int ended;                     ///< Nonzero at the end of a stream
+  char *path;                    ///< File name for messages
+  unsigned char *in;             ///< Compressed input buffer
+  z_stream zs;                   ///< gzip decoder
+#ifdef HREAD_ZSTD
+  ZSTD_DStream *zd;              ///< zstd decoder
+  ZSTD_inBuffer zin;             ///< zstd input
+#endif
+};
+
+/**
+   Decompress gzip data into one buffer.
+   @param[in,out] z Ring.
+   @param[out] out Buffer.
+   @param[in] size Size of the buffer.
+   @param[out] eof Set nonzero at the end of the input.
+   @return Bytes decompressed.  z->err is set if the data are bad.
+*/
+static size_t gzFill( struct HZRING *z, char *out, size_t size, int *eof )
+{
+  ssize_t got;
+  size_t avail;
+  int ret;
+
+  z->zs.next_out = (unsigned char *) out;
+  z->zs.avail_out = size;
+  while( z->zs.avail_out > 0 )
+    {
+      if( z->zs.avail_in == 0 )
+	{
+	  if( (got = read( z->fd, z->in, HREAD_ZINSIZE )) <= 0 )
+	    { /* A stream cut short is an error */
+	      z->err = got < 0 || !z->ended;
+	      *eof = 1;
+	      break;
+	    }
+	  z->zs.next_in = z->in;
+	  z->zs.avail_in = got;
+	}
+      avail = z->zs.avail_in;
+      ret = inflate( &z->zs, Z_NO_FLUSH );
+      if( ret == Z_STREAM_END )
+	{ /* Concatenated members may follow, as gunzip allows */
+	  z->ended = 1;
+	  inflateReset( &z->zs );
+	}
+      else if( ret == Z_OK || ret == Z_BUF_ERROR )
+	{
+	  if( z->zs.avail_in < avail ) z->ended = 0;
+	}
+      else
+	{
+	  z->err = 1;
+	  *eof = 1;
+	  break;
+	}
+    }
+  return size-z->zs.avail_out;
+} /* gzFill */
+
+#ifdef HREAD_ZSTD
+/**
+   Decompress zstd data into one buffer.
+   @param[in,out] z Ring.
+   @param[out] out Buffer.
+   @param[in] size Size of the buffer.
+   @param[out] eof Set nonzero at the end of the input.
+   @return Bytes decompressed.  z->err is set if the data are bad.
+*/
+static size_t zstdFill( struct HZRING *z, char *out, size_t size, int *eof )
+{
+  ZSTD_outBuffer zout;
+  ssize_t got;
+  size_t ret;
+
+  zout.dst = out;
+  zout.size = size;
+  zout.pos = 0;
+  while( zout.pos < zout.size )
+    {
+      if( z->zin.pos == z->zin.size )
+	{
+	  if( (got = read( z->fd, z->in, HREAD_ZINSIZE )) <= 0 )
+	    { /* A frame cut short is an error */
+	      z->err = got < 0 || !z->ended;
+	      *eof = 1;
+	      break;
+	    }
+	  z->zin.src = z->in;
+	  z->zin.size = got;
+	  z->zin.pos = 0;
+	}
+      ret = ZSTD_decompressStream( z->zd, &zout, &z->zin );
+      if( ZSTD_isError( ret ) )
+	{
+	  z->err = 1;
+	  *eof = 1;
+	  break;
+	}
+      z->ended = ret == 0; /* Frame complete */
+    }
+  return zout.pos;
+} /* zstdFill */
+#endif
+
+/**
+   Read plain data into one buffer, as much as one read() gives.
+   @param[in,out] z Ring.
+   @param[out] out Buffer.
+   @param[in] size Size of the buffer.
+   @param[out] eof Set nonzero at the end of the input.
+   @return Bytes read.  z->err is set on a read error.
+*/
+static size_t rawFill( struct HZRING *z, char *out, size_t size, int *eof )
+{
+  ssize_t got;
+
+  while( (got = read( z->fd, out, size )) < 0 && errno == EINTR )
+    ;
+  if( got <= 0 )
+    {
+      z->err = got < 0;
+      *eof = 1;
+      return 0;
+    }
+  return got;
+} /* rawFill */
+
+/**
+   Reader thread: fill empty buffers until the input ends or the reader
+   is closed, then put a NULL.
+   @param[in,out] arg Ring.
+   @return NULL.
+*/
+static void *zThread( void *arg )
+{
+  struct HZRING *z = arg;
+  struct HZBUF *b;
+  int eof;
+
+  for( b = NULL, eof = 0; !eof; )
+    {
+      if( b == NULL ) b = hringGet( &z->freed );
+      if( atomic_load( &z->stop ) ) break;
+      if( z->format == HREAD_RAW )
+	b->len = rawFill( z, b->data, HREAD_ZBUFSIZE, &eof );
+#ifdef HREAD_ZSTD
+      else if( z->format == HREAD_ZSTD_FMT )
+	b->len = zstdFill( z, b->data, HREAD_ZBUFSIZE, &eof );
+#endif
+      else
+	b->len = gzFill( z, b->data, HREAD_ZBUFSIZE, &eof );
+      if( b->len > 0 )
+	{
+	  hringPut( &z->filled, b );
+	  b = NULL;
+	}
+    }
+  hringPut( &z->filled, NULL );
+  return NULL;
+} /* zThread */
+
+/**
+   Start reading a file ahead on a separate thread.
+   @param[in,out] rd Reader; rd->z is set.
+   @param[in] fd Input, positioned at the start.
+   @param[in] format HREAD_GZIP, HREAD_ZSTD_FMT or HREAD_RAW.
+   @param[in] path File name for messages.
+   @return 0 on success, or -1 with errno set.
+*/
+static int zOpen( HREADER *rd, int fd, int format, const char *path )
+{
+  struct HZRING *z;
+  int i, err, rings;
+
+  if( (z = calloc( 1, sizeof(struct HZRING) )) == NULL ) return -1;
+  z->format = format;
+  z->fd = fd;
+  z->ended = 1; /* An empty file is an empty stream */
+  rings = 0;
+  err = ENOMEM;
+  if( (z->path = strdup( path )) == NULL ||
+      (format != HREAD_RAW && (z->in = malloc( HREAD_ZINSIZE )) == NULL) )
+    goto fail;
+  for( i = 0; i < HREAD_ZBUFS; i++ )
+    if( (z->buf[i].data = malloc( HREAD_ZBUFSIZE )) == NULL ) goto fail;
+  /* Room for every buffer and the NULL */
+  if( hringInit( &z->filled, HREAD_ZBUFS+1 ) ) goto fail;
+  if( hringInit( &z->freed, HREAD_ZBUFS ) )
+    {
+      hringDestroy( &z->filled );
+      goto fail;
+    }
+  rings = 1;
+  for( i = 0; i < HREAD_ZBUFS; i++ ) hringPut( &z->freed, &z->buf[i] );
+  if( format == HREAD_GZIP &&
+      inflateInit2( &z->zs, 15+32 ) != Z_OK ) /* gzip or zlib header */
+    goto fail;
+#ifdef HREAD_ZSTD
+  if( format == HREAD_ZSTD_FMT && ((z->zd = ZSTD_createDStream()) == NULL ||
+				   ZSTD_isError( ZSTD_initDStream( z->zd ) )) )
+    goto fail;
+#endif
+  if( (err = pthread_create( &z->thread, NULL, zThread, z )) != 0 )
+    {
+      if( format == HREAD_GZIP ) inflateEnd( &z->zs );
+      goto fail;
+    }
+  posix_fadvise( fd, 0, 0, POSIX_FADV_SEQUENTIAL );
+  rd->z = z;
+  return 0;
+
+ fail:
+#ifdef HREAD_ZSTD
+  if( z->zd ) ZSTD_freeDStream( z->zd );
+#endif
+  if( rings )
+    {
+      hringDestroy( &z->filled );
+      hringDestroy( &z->freed );
+    }
+  for( i = 0; i < HREAD_ZBUFS; i++ ) free( z->buf[i].data );
+  free( z->in );
+  free( z->path );
+  free( z );
+  errno = err;
+  return -1;
+} /* zOpen */
+
+/**
+   Hand back the buffer being read and wait for the next one.
+   @param[in,out] z Ring.
+   @return 1 if a buffer is ready, 0 at the end of the data.  Exits if the
+   compressed data were bad.
+*/
+static int zNext( struct HZRING *z )
+{
+  if( z->done ) return 0;
+  if( z->cur ) hringPut( &z->freed, z->cur );
+  if( (z->cur = hringGet( &z->filled )) == NULL )
+    {
+      z->done = 1;
+      if( z->err && z->format == HREAD_RAW )
+	{
+	  perror( z->path );
+	  exit(EXIT_FAILURE);
+	}
+      if( z->err )
+	{
+	  fprintf( stderr, "%s: corrupt or truncated compressed data\n",
+		   z->path );
+	  exit(EXIT_FAILURE);
+	}
+      return 0;
+    }
+  z->cpos = 0;
+  z->clen = z->cur->len;
+  return 1;
+} /* zNext */
+
+/**
+   Make room for a line of at least @a n bytes in a growing buffer.  The
+   buffer doubles, so a file of long lines costs a few reallocations in
+   all, not one per line.
+   @param[in,out] buf Buffer, or NULL for none yet; the contents are kept.
+   @param[in,out] size Allocated size of the buffer.
+   @param[in] n Bytes needed.  Exits if memory runs out.
+*/
+static void growLine( char **buf, size_t *size, size_t n )
+{
+  size_t want;
+
+  if( n <= *size ) return;
+  for( want = *size ? *size : HREAD_LINELEN; want < n; want *= 2 )
+    ;
+  if( (*buf = realloc( *buf, want )) == NULL )
+    {
+      perror( "hreadLine" );
+      exit(EXIT_FAILURE);
+    }
+  *size = want;
+} /* growLine */
+
+/**
+   Get the next line of the ring's data.  A line that runs across two or
+   more buffers is put together in rd->line.
+   @param[in,out] rd Reader.
+   @param[out] line Start of the line.
+   @param[out] len Length of the line in bytes.
+   @return 1 if a line was read, 0 at end of file.
+*/
+static int zLine( HREADER *rd, const char **line, size_t *len )
+{
+  struct HZRING *z = rd->z;
+  const char *p, *nl;
+  size_t n, have;
+
+  for( have = 0;; )
+    {
+      if( z->cpos < z->clen )
+	{
+	  p = z->cur->data+z->cpos;
+	  n = z->clen-z->cpos;
+	  if( (nl = memchr( p, '\n', n )) != NULL ) n = nl-p+1;
+	  z->cpos += n;
+	  if( have == 0 && nl )
+	    { /* Whole line in this buffer */
+	      *line = p;
+	      *len = n;
+	      return 1;
+	    }
+	  growLine( &rd->line, &rd->lineSize, have+n );
+	  memcpy( rd->line+have, p, n );
+	  have += n;
+	  if( nl ) break;
+	}
+      if( !zNext( z ) )
+	{
+	  if( have == 0 ) return 0;
+	  break;
+	}
+    }
+  *line = rd->line;
+  *len = have;
+  return 1;
+} /* zLine */
+
+/**
+   Stop the reader thread and release the ring.  Filled buffers are
+   handed back until the thread's NULL arrives, so the thread never
+   waits on a ring that nobody is reading.
+   @param[in] z Ring.
+*/
+static void zClose( struct HZRING *z )
+{
+  struct HZBUF *b;
+  int i;
+
+  atomic_store( &z->stop, 1 );
+  if( !z->done )
+    {
+      if( z->cur ) hringPut( &z->freed, z->cur );
+      while( (b = hringGet( &z->filled )) != NULL )
+	hringPut( &z->freed, b );
+    }
+  pthread_join( z->thread, NULL );
+  if( z->format == HREAD_GZIP ) inflateEnd( &z->zs );
+#ifdef HREAD_ZSTD
+  if( z->zd ) ZSTD_freeDStream( z->zd );
+#endif
+  hringDestroy( &z->filled );
+  hringDestroy( &z->freed );
+  for( i = 0; i < HREAD_ZBUFS; i++ ) free( z->buf[i].data );
+  free( z->in );
+  free( z->path );
+  free( z );
+} /* zClose */
+
+/**
+   Open an input file for reading lines.
+   @param[in] path File name, or "-" for standard input.
+   @return Reader, or NULL with errno set on failure.
+*/
+HREADER *hreadOpen( const char *path )
+{
+  HREADER *rd;
+  struct stat st;
+  unsigned char magic[4];
+  int fd, err, format;
+  void *map;
+
+  if( (rd = calloc( 1, sizeof(HREADER) )) == NULL ) return NULL;
+  rd->notify = -1;
+  if( strcmp( path, "-" ) == 0 )
+    {
+      rd->fp = stdin; /* Not closed */
+      rd->fd = STDIN_FILENO;
+      if( fstat( rd->fd, &st ) == 0 && !S_ISREG(st.st_mode) &&
+	  zOpen( rd, rd->fd, HREAD_RAW, path ) )
+	{
+	  err = errno;
+	  free( rd );
+	  errno = err;
+	  return NULL;
+	}
+      return rd;
+    }
+  if( (fd = open( path, O_RDONLY )) < 0 )
+    {
+      err = errno;
+      free( rd );
+      errno = err;
+      return NULL;
+    }
+  if( fstat( fd, &st ) == 0 && !S_ISREG(st.st_mode) )
+    { /* Pipe or device: read ahead on a separate thread */
+      rd->fd = fd;
+      if( zOpen( rd, fd, HREAD_RAW, path ) == 0 ) return rd;
+      err = errno;
+      close( fd );
+      free( rd );
+      errno = err;
+      return NULL;
+    }
+  if( S_ISREG(st.st_mode) && st.st_size > 0 )
+    {
+      format = 0;
+      if( pread( fd, magic, 4, 0 ) == 4 )
+	{
+	  if( magic[0] == 0x1f && magic[1] == 0x8b ) format = HREAD_GZIP;
+	  else if( magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f &&
+		   magic[3] == 0xfd )
+	    format = HREAD_ZSTD_FMT;
+	}
+      if( format )
+	{ /* Decompress on a separate thread */
+	  rd->fd = fd;
+#ifndef HREAD_ZSTD
+	  if( format == HREAD_ZSTD_FMT )
+	    {
+	      errno = ENOTSUP;
+	      err = -1;
+	    }
+	  else
+#endif
+	    err = zOpen( rd, fd, format, path );
+	  if( err == 0 ) return rd;
+	  err = errno;
+	  close( fd );
+	  free( rd );
+	  errno = err;
+	  return NULL;
+	}
+      map = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+      if( map != MAP_FAILED )
+	{ /* Read straight from the page cache */
+	  madvise( map, st.st_size, MADV_SEQUENTIAL );
+	  rd->fd = fd; /* Kept open for follow mode */
+	  rd->map = map;
+	  rd->mapSize = rd->size = st.st_size;
+	  return rd;
+	}
+    }
+  if( (rd->fp = fdopen( fd, "r" )) == NULL )
+    {
+      err = errno;
+      close( fd );
+      free( rd );
+      errno = err;
+      return NULL;
+    }
+  rd->fd = fd;
+  return rd;
+} /* hreadOpen */
+
+/**
+   Limit a mapped reader to a range of the file.  Both ends must be line
+   boundaries as hreadLine() would find them, such as the offsets in a
+   hidx index.
+   @param[in,out] rd Reader from hreadOpen().
+   @param[in] start Offset of the first line to read.
+   @param[in] end Offset just past the last line to read.
+   @return 0 on success, or -1 with errno set if the reader is not mapped
+   or the range is outside the file.
+*/
+int hreadRange( HREADER *rd, size_t start, size_t end )
+{
+  if( rd->map == NULL || start > end || end > rd->mapSize )
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  rd->pos = start;
+  rd->size = end;
+  return 0;
+} /* hreadRange */
+
+/**
+   Switch a reader to follow mode, like "tail -f": at the end of the data
+   hreadLine() returns 0, and after hreadWait() it picks up whatever has
+   been appended since.  Call before the first hreadLine().
+   @param[in,out] rd Reader from hreadOpen() on a regular file.
+   @param[in] path The same file name, to watch for changes.
+   @return 0 on success, or -1 with errno set.
+*/
+int hreadFollow( HREADER *rd, const char *path )
+{
+  struct stat st;
+
+  if( fstat( rd->fd, &st ) ) return -1;
+  if( !S_ISREG(st.st_mode) || rd->z )
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  if( (rd->buf = malloc( HREAD_BUFSIZE )) == NULL ) return -1;
+  rd->bufSize = HREAD_BUFSIZE;
+  rd->bpos = rd->blen = 0;
+  rd->delay = HREAD_MINWAIT;
+  rd->follow = 1;
+#ifdef __linux__
+  if( (rd->notify = inotify_init1( IN_NONBLOCK | IN_CLOEXEC )) >= 0 &&
+      inotify_add_watch( rd->notify, path, IN_MODIFY ) < 0 )
+    { /* Fall back to polling */
+      close( rd->notify );
+      rd->notify = -1;
+    }
+#endif
+  return 0;
+} /* hreadFollow */
+
+/**
+   Get the next complete line in follow mode.
+   @param[in,out] rd Reader.
+   @param[out] line Start of the line.
+   @param[out] len Length of the line in bytes.
+   @return 1 if a line was read, 0 if no complete line is available yet.
+*/
+static int followLine( HREADER *rd, const char **line, size_t *len )
+{
+  size_t n;
+  ssize_t got;
+
+  if( rd->map )
+    {
+      if( rd->pos < rd->size )
+	{
+	  n = hreadLineLen( rd->map+rd->pos, rd->size-rd->pos );
+	  if( rd->map[rd->pos+n-1] == '\n' )
+	    {
+	      *line = rd->map+rd->pos;
+	      *len = n;
+	      rd->pos += n;
+	      return 1;
+	    }
+	}
+      /* End of the mapped data; read() the rest from the same offset */
+      munmap( (void *) rd->map, rd->mapSize );
+      rd->map = NULL;
+      if( lseek( rd->fd, rd->pos, SEEK_SET ) < 0 ) return 0;
+    }
+  for( ;; )
+    {
+      if( rd->bpos < rd->blen )
+	{
+	  n = hreadLineLen( rd->buf+rd->bpos, rd->blen-rd->bpos );
+	  if( rd->buf[rd->bpos+n-1] == '\n' )
+	    {
+	      *line = rd->buf+rd->bpos;
+	      *len = n;
+	      rd->bpos += n;
+	      return 1;
+	    }
+	}
+      /* Keep the partial line and read more after it */
+      memmove( rd->buf, rd->buf+rd->bpos, rd->blen-rd->bpos );
+      rd->blen -= rd->bpos;
+      rd->bpos = 0;
+      if( rd->blen == rd->bufSize ) /* Line longer than the buffer */
+	growLine( &rd->buf, &rd->bufSize, 2*rd->bufSize );
+      if( (got = read( rd->fd, rd->buf+rd->blen, rd->bufSize-rd->blen ))
+	  <= 0 )
+	return 0;
+      rd->blen += got;
+      rd->delay = HREAD_MINWAIT;
+    }
+} /* followLine */
+
+/**
+   Wait in follow mode until the file may have grown.  Returns after a
+   change is seen, after at most HREAD_MAXWAIT milliseconds, or when a
+   signal arrives.  If the file was truncated, reading starts over at the
+   beginning.
+   @param[in,out] rd Reader in follow mode.
+   @return 0 on success, or -1 with errno set (EINTR for a signal).
+*/
+int hreadWait( HREADER *rd )
+{
+  struct pollfd pfd;
+  struct stat st;
+  char ev[4096];
+  off_t off;
+  int ms;
+
+  if( rd->notify >= 0 )
+    {
+      pfd.fd = rd->notify;
+      pfd.events = POLLIN;
+      if( poll( &pfd, 1, HREAD_MAXWAIT ) < 0 ) return -1;
+      while( read( rd->notify, ev, sizeof(ev) ) > 0 )
+	; /* Drain the events */
+    }
+  else
+    {
+      ms = rd->delay;
+      if( (rd->delay *= 2) > HREAD_MAXWAIT ) rd->delay = HREAD_MAXWAIT;
+      if( poll( NULL, 0, ms ) < 0 ) return -1;
+    }
+  off = rd->map ? (off_t) rd->pos : lseek( rd->fd, 0, SEEK_CUR );
+  if( fstat( rd->fd, &st ) == 0 && st.st_size < off )
+    { /* Truncated: start over */
+      if( rd->map )
+	{
+	  munmap( (void *) rd->map, rd->mapSize );
+	  rd->map = NULL;
+	}
+      rd->bpos = rd->blen = 0;
+      if( lseek( rd->fd, 0, SEEK_SET ) < 0 ) return -1;
+    }
+  return 0;
+} /* hreadWait */
+
+/**
+   Find the length of the line at @a p, up to and including its newline.
+   Used to walk lines in any newline-aligned part of a mapping.
+   @param[in] p Start of the line.
+   @param[in] n Bytes available, at least 1.
+   @return Length of the line including its newline, if any.
+*/
+size_t hreadLineLen( const char *p, size_t n )
+{
+  const char *nl;
+
+  if( (nl = memchr( p, '\n', n )) != NULL ) n = nl-p+1;
+  return n;
+} /* hreadLineLen */
+
+/**
+   Find the newlines and NULs in the next block of bytes: 16 compared at
+   once with SSE2, one at a time elsewhere.
+   @param[in] p Start of the block.
+   @param[in] n Bytes available, at least 1.
+   @param[out] nul Bit k set if p[k] is a NUL.
+   @return Bit k set if p[k] is a newline.  Bits past @a n are clear.
+*/
+static inline unsigned blockMasks( const char *p, size_t n, unsigned *nul )
+{
+  unsigned nl;
+  size_t k;
+
+#ifdef __SSE2__
+  __m128i v;
+
+  if( n >= 16 )
+    {
+      v = _mm_loadu_si128( (const __m128i *) p );
+      *nul = _mm_movemask_epi8( _mm_cmpeq_epi8( v, _mm_setzero_si128() ) );
+      return _mm_movemask_epi8( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\n' ) ) );
+    }
+#endif
+  for( nl = *nul = 0, k = 0; k < n && k < 16; k++ )
+    {
+      nl |= (unsigned) (p[k] == '\n') << k;
+      *nul |= (unsigned) (p[k] == '\0') << k;
+    }
+  return nl;
+} /* blockMasks */
+
+/**
+   Find the run of comment lines at @a p: lines that do not start with a
+   digit, each shorter than @a maxLine with its newline and holding no
+   NUL, so they can be copied with houtComments().  The bytes are
+   scanned HREAD_SCAN at a time for newlines and NULs together, and
+   only the byte after each newline is looked at, so a run costs no
+   call per line.
+   @param[in] p Start of a line.
+   @param[in] n Bytes available.
+   @param[in] final Nonzero if a last line without a newline is complete,
+   as at the end of a file or of a newline-aligned chunk.
+   @param[in] maxLine Lines this long or longer end the run.
+   @param[out] nlines Lines in the run.
+   @return Length of the run, 0 if the line at @a p cannot start one.
+*/
+size_t hreadCommentRun( const char *p, size_t n, int final, size_t maxLine,
+			size_t *nlines )
+{
+  unsigned nl, nul;
+  size_t i, s, j, count;
+
+  for( count = s = i = 0; i < n && !isdigit( (unsigned char) p[s] );
+       i += HREAD_SCAN )
+    {
+      nl = blockMasks( p+i, n-i, &nul );
+      if( nul ) nl &= (1u << __builtin_ctz( nul ))-1;
+      for( ; nl; nl &= nl-1 )
+	{ /* Each line that ends in this block */
+	  j = i+__builtin_ctz( nl )+1;
+	  if( j-s >= maxLine ) break;
+	  count++;
+	  if( (s = j) == n || isdigit( (unsigned char) p[s] ) ) break;
+	}
+      if( nl || nul || (i+HREAD_SCAN < n ? i+HREAD_SCAN : n)-s >= maxLine )
+	break;
+    }
+  if( final && i >= n && s < n && n-s < maxLine &&
+      !isdigit( (unsigned char) p[s] ) )
+    { /* Last line, without a newline */
+      count++;
+      s = n;
+    }
+  *nlines = count;
+  return s;
+} /* hreadCommentRun */
+
+/**
+   Take the comment lines that follow a comment line along with it.
+   Only lines already in the mapping or the current buffer are taken,
+   and only if the line was returned from there too and is itself one
+   hreadCommentRun() accepts.
+   @param[in,out] rd Reader.
+   @param[in] line Comment line just returned by hreadLine().
+   @param[in,out] len Length of the line, updated to the length of the
+   run, which is read past.
+   @param[in] maxLine Lines this long or longer are not taken.
+   @return Lines in the run, 1 if only the line itself.
+*/
+size_t hreadComments( HREADER *rd, const char *line, size_t *len,
+		      size_t maxLine )
+{
+  struct HZRING *z = rd->z;
+  const char *next;
+  size_t avail, run, nlines;
+  int final;
+
+  if( z )
+    {
+      if( z->cur == NULL ) return 1;
+      next = z->cur->data+z->cpos;
+      avail = z->clen-z->cpos;
+      final = 0;
+    }
+  else if( rd->map )
+    {
+      next = rd->map+rd->pos;
+      avail = rd->size-rd->pos;
+      final = !rd->follow;
+    }
+  else if( rd->follow )
+    {
+      next = rd->buf+rd->bpos;
+      avail = rd->blen-rd->bpos;
+      final = 0;
+    }
+  else
+    return 1;
+  if( line+*len != next || avail == 0 ) return 1; /* Put together */
+  run = hreadCommentRun( line, *len+avail, final, maxLine, &nlines );
+  if( run <= *len ) return 1;
+  if( z ) z->cpos += run-*len;
+  else if( rd->map ) rd->pos += run-*len;
+  else rd->bpos += run-*len;
+  *len = run;
+  return nlines;
+} /* hreadComments */
+
+/**
+   Get the next line.  The returned span includes the newline, if any, and
+   stays valid until the next call.
+   @param[in,out] rd Reader.
+   @param[out] line Start of the line.
+   @param[out] len Length of the line in bytes.
+   @return 1 if a line was read, 0 at end of file (in follow mode, at the
+   end of the data written so far).
+*/
+int hreadLine( HREADER *rd, const char **line, size_t *len )
+{
+  ssize_t got;
+
+  if( rd->follow ) return followLine( rd, line, len );
+  if( rd->z ) return zLine( rd, line, len );
+  if( rd->map == NULL )
+    {
+      if( rd->fp == NULL ||
+	  (got = getline( &rd->line, &rd->lineSize, rd->fp )) <= 0 )
+	return 0;
+      *line = rd->line;
+      *len = got;
+      return 1;
+    }
+  if( rd->pos >= rd->size ) return 0;
+  *line = rd->map+rd->pos;
+  *len = hreadLineLen( *line, rd->size-rd->pos );
+  rd->pos += *len;
+  return 1;
+} /* hreadLine */
+
+/**
+   Close the input and release the reader.
+   @param[in] rd Reader from hreadOpen().
+*/
+void hreadClose( HREADER *rd )
+{
+  if( rd->map ) munmap( (void *) rd->map, rd->mapSize );
+  if( rd->z ) zClose( rd->z );
+  if( rd->notify >= 0 ) close( rd->notify );
+  if( rd->fp ) /* Closes fd too */
+    {
+      if( rd->fp != stdin ) fclose( rd->fp );
+    }
+  else
+    close( rd->fd );
+  free( rd->buf );
+  free( rd->line );
+  free( rd );
+} /* hreadClose */
@@ -0,0 +1,106 @@
+/** @file hread.h
+    @brief
+    Line reader for Harbor CSV files.
+
+    @details
+    Regular files are memory mapped and lines are returned as pointer and
+    length spans directly into the mapping, so no bytes are copied before
+    parsing.  Pipes, terminals and standard input (named "-") are read ahead
+    into buffers.  Lines may be of any length: every path returns the whole
+    line up to and including its newline, and only a line that runs across
+    two buffers is put together, in a line buffer that grows by doubling and
+    is kept for the next such line.  hreadFollow() turns a reader into a
+    "tail -f" reader that keeps the file open and resumes where it stopped
+    as the file grows.  hreadRange() limits a mapped reader to part of the
+    file, such as a time range found with hidxRange().  Files compressed
+    with gzip, or zstd when built with -DHREAD_ZSTD, are recognised by their
+    magic number and decompressed on a separate thread while the caller
+    parses.  hreadComments() and hreadCommentRun() find the comment lines
+    that follow a comment line a block of bytes at a time, so a run of them
+    can be copied to the output in one go.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added compressed input.
+    2026-Oct-14 Lines of any length.
+    2026-Oct-14 Added hreadComments() and hreadCommentRun().
+    @endverbatim
+*/
+#ifndef HREAD_H
+#define HREAD_H
+#include <stdio.h>
+
+/**
+   First size of the line buffer; it grows to hold the longest line put
+   together so far.
+*/
+#define HREAD_LINELEN 256
+
+/**
+   First read buffer size for follow mode; it grows if a line is longer.
+*/
+#define HREAD_BUFSIZE (64<<10)
+
+/**
+   Longest wait in hreadWait(), in milliseconds, between checks of the file.
+*/
+#define HREAD_MAXWAIT 1000
+
+/**
+   Buffer size of the read-ahead ring, which holds HREAD_ZBUFS of them.
+*/
+#define HREAD_ZBUFSIZE (1<<20)
+
+/**
+   Number of buffers in the read-ahead ring.
+*/
+#define HREAD_ZBUFS 4
+
+/**
+   Bytes hreadCommentRun() scans at a time: one SSE2 vector.
+*/
+#define HREAD_SCAN 16
+
+/**
+   Read-ahead ring for compressed files and pipes, private to hread.c.
+*/
+struct HZRING;
+
+/**
+   Reader state.  Use hreadOpen() to create one.
+*/
+typedef struct
+{
+  FILE *fp;                  ///< stdio stream, NULL if mapped
+  const char *map;           ///< Mapped file, NULL if using stdio
+  size_t mapSize;            ///< Size of the mapping in bytes
+  size_t size;               ///< End of the data to read in the mapping
+  size_t pos;                ///< Offset of the next line in the mapping
+  char *line;                ///< Line buffer, NULL until needed
+  size_t lineSize;           ///< Allocated size of line
+  int fd;                    ///< Input file descriptor
+  int follow;                ///< Nonzero in follow mode
+  int notify;                ///< inotify descriptor, -1 to poll
+  int delay;                 ///< Next poll delay in milliseconds
+  char *buf;                 ///< Read buffer for follow mode
+  size_t bufSize;            ///< Allocated size of buf
+  size_t bpos, blen;         ///< Next line and end of data in buf
+  struct HZRING *z;          ///< Read-ahead ring, NULL if not used
+} HREADER;
+
+HREADER *hreadOpen( const char *path );
+size_t hreadLineLen( const char *p, size_t n );
+size_t hreadCommentRun( const char *p, size_t n, int final, size_t maxLine,
+			size_t *nlines );
+size_t hreadComments( HREADER *rd, const char *line, size_t *len,
+		      size_t maxLine );
+int hreadLine( HREADER *rd, const char **line, size_t *len );
+int hreadRange( HREADER *rd, size_t start, size_t end );
+int hreadFollow( HREADER *rd, const char *path );
+int hreadWait( HREADER *rd );
+void hreadClose( HREADER *rd );
+
+#endif /* HREAD_H */
@@ -0,0 +1,243 @@
+/** @file hrec.c
+    @brief
+    Harbor GPS and sensor record types and parsers.
+
+    @details
+    Both parsers use the hcsv field scanner and give the same values and
+    field counts as the sscanf() formats they replaced.  They, the
+    formatters and the column tables are expanded from the field tables
+    in hrec.h.  The projected
+    sensor parser steps over unselected fields with memchr() instead of
+    converting them, so their contents are not checked; a record still
+    needs all SENSOR_NFIELDS fields.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added sensor field projections.
+    2026-Oct-14 Generate parsers, formatters and columns from field tables.
+    @endverbatim
+*/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "hrec.h"
+
+/*
+  The GPS and sensor parsers, formatters and column tables, expanded from
+  the field tables in hrec.h.
+*/
+#define HREC_OFFSET( name ) offsetof(GPSDATA, name)
+const HCOLDEF gpsColumns[GPS_NCOLS] = { HREC_COLUMNS( HREC_GPS_FIELDS ) };
+#undef HREC_OFFSET
+#define HREC_OFFSET( name ) offsetof(SENSORDATA, name)
+const HCOLDEF sensorColumns[SENSOR_NFIELDS] =
+  { HREC_COLUMNS( HREC_SENSOR_FIELDS ) };
+#undef HREC_OFFSET
+
+/**
+   Name of one field; the expansion of sensorNames.
+*/
+#define HREC_NAME1( name, type, sep, units, width, prec, col ) #name,
+
+/**
+   Sensor field names, in record order.
+*/
+const char *const sensorNames[SENSOR_NFIELDS] =
+  { HREC_SENSOR_FIELDS( HREC_NAME1 ) };
+
+/**
+   Format of one field; the expansion of sensorFormat.
+*/
+#define HREC_FORMAT1( name, type, sep, units, width, prec, col ) \
+  { width, prec },
+
+/**
+   Text format of each sensor field, for showSensorFields().
+*/
+static const struct
+{
+  int width, prec;
+} sensorFormat[SENSOR_NFIELDS] = { HREC_SENSOR_FIELDS( HREC_FORMAT1 ) };
+
+/**
+   Check that a sensor field is in its lane; the expansion of the lane
+   order checks.
+*/
+#define HREC_LANE1( name, type, sep, units, width, prec, col )		\
+  _Static_assert( offsetof(SENSORDATA, name) == n##name*sizeof(float),	\
+		  "SENSORDATA lane order differs from HREC_SENSOR_FIELDS" );
+#define HREC_ENUM1( name, type, sep, units, width, prec, col ) n##name,
+enum { HREC_SENSOR_FIELDS( HREC_ENUM1 ) nSensorFields };
+_Static_assert( nSensorFields == SENSOR_NFIELDS,
+		"SENSOR_NFIELDS differs from HREC_SENSOR_FIELDS" );
+HREC_SENSOR_FIELDS( HREC_LANE1 )
+
+/**
+   Parse one GPS record, equivalent to sscanf() with the format
+   "%f,%d/%d/%d,%d:%d:%d,%f,%f,%f,%d".  Fields are stored as they are
+   converted, so a partial record leaves the leading fields set.
+   @param[in] str Start of the record.
+   @param[in] end End of the record.
+   @param[out] raw Parsed values.
+   @return Number of fields converted, GPS_NFIELDS for a complete record.
+*/
+HREC_PARSER( parseGPS, GPSDATA, HREC_GPS_FIELDS )
+
+/**
+   Write the fixed length columns of a GPS record, without the newline,
+   the same text as printf( "%6.1f %2d %2d %4d %2d %2d %2d %11.7f %12.7f
+   %8.1f %2d" ).
+   @param[in] out Output buffer.
+   @param[in] rec Record to write.
+*/
+HREC_SHOWER( showGPS, GPSDATA, HREC_GPS_FIELDS )
+
+/**
+   Write a GPS record in wide form, such as an average, as showGPS().
+   @param[in] out Output buffer.
+   @param[in] rec Record to write.
+*/
+HREC_SHOWER( showGPSWide, GPSWIDE, HREC_GPS_FIELDS )
+
+/**
+   Parse the fields of one sensor record.
+*/
+static HREC_PARSER( parseSensorRecord, SENSORDATA, HREC_SENSOR_FIELDS )
+
+/**
+   Parse one sensor record, equivalent to sscanf() with 18 comma-separated
+   "%f" conversions.  Fields are stored as they are converted, so a partial
+   record leaves the leading fields set.  The padding lanes are set to
+   zero.
+   @param[in] str Start of the record.
+   @param[in] end End of the record.
+   @param[out] raw Parsed values.
+   @return Number of fields converted, SENSOR_NFIELDS for a complete record.
+*/
+int parseSensor( const char *str, const char *end, SENSORDATA *raw )
+{
+  int n;
+
+  for( n = SENSOR_NFIELDS; n < SENSOR_NLANES; n++ ) raw->v[n] = 0.0;
+  return parseSensorRecord( str, end, raw );
+} /* parseSensor */
+
+/**
+   Write the fixed length columns of a sensor record, without the newline,
+   the same text as printf( "%6.1f %5.1f %f %f ... %f" ).
+   @param[in] out Output buffer.
+   @param[in] rec Record to write.
+*/
+HREC_SHOWER( showSensor, SENSORDATA, HREC_SENSOR_FIELDS )
+
+/**
+   Make a sensor field projection from a list of field names.
+   @param[in] list Comma-separated field names, such as
+   "tsecs,prss,tmpx,vbat", in the order they are to be written.
+   @param[out] proj Projection.
+   @return 0 on success, or -1 with errno set to EINVAL if a name is
+   unknown or repeated, or the list is empty.
+*/
+int sensorProject( const char *list, SENSORPROJ *proj )
+{
+  const char *p, *comma;
+  size_t len;
+  int n, i;
+
+  memset( proj, 0, sizeof(SENSORPROJ) );
+  proj->want[0] = 1; /* tsecs */
+  for( p = list; *p; p = comma ? comma+1 : p+len )
+    {
+      comma = strchr( p, ',' );
+      len = comma ? (size_t) (comma-p) : strlen( p );
+      for( n = 0; n < SENSOR_NFIELDS; n++ )
+	if( strlen( sensorNames[n] ) == len &&
+	    strncmp( sensorNames[n], p, len ) == 0 )
+	  break;
+      for( i = 0; i < proj->nsel && n < SENSOR_NFIELDS; i++ )
+	if( proj->field[i] == n ) n = SENSOR_NFIELDS; /* Repeated */
+      if( n == SENSOR_NFIELDS )
+	{
+	  errno = EINVAL;
+	  return -1;
+	}
+      proj->field[proj->nsel++] = n;
+      proj->want[n] = 1;
+    }
+  if( proj->nsel == 0 )
+    {
+      errno = EINVAL;
+      return -1;
+    }
+  for( i = 0; i < SENSOR_NLANES/4; i++ )
+    for( n = 4*i; n < 4*i+4 && n < SENSOR_NFIELDS; n++ )
+      if( proj->want[n] )
+	{
+	  proj->vec[proj->nvec++] = i;
+	  break;
+	}
+  return 0;
+} /* sensorProject */
+
+/**
+   Parse one sensor record, converting only the fields of a projection.
+   The other lanes are set to zero.
+   @param[in] str Start of the record.
+   @param[in] end End of the record.
+   @param[in] proj Projection, or NULL for all fields as parseSensor().
+   @param[out] raw Parsed values.
+   @return Number of fields found, SENSOR_NFIELDS for a complete record.
+*/
+int parseSensorFields( const char *str, const char *end,
+		       const SENSORPROJ *proj, SENSORDATA *raw )
+{
+  const char *p = str, *comma;
+  int n;
+
+  if( proj == NULL ) return parseSensor( str, end, raw );
+  for( n = 0; n < SENSOR_NLANES/4; n++ )
+    raw->vec[n] = (SENSORVEC) { 0.0, 0.0, 0.0, 0.0 };
+  for( n = 0; n < SENSOR_NFIELDS; n++ )
+    {
+      if( n > 0 && !hcsvSep( &p, end, ',' ) ) break;
+      if( proj->want[n] )
+	{
+	  if( !hcsvFloat( &p, end, &raw->v[n] ) ) break;
+	}
+      else
+	{ /* Skip to the next separator */
+	  comma = memchr( p, ',', end-p );
+	  p = comma ? comma : end;
+	}
+    }
+  return n;
+} /* parseSensorFields */
+
+/**
+   Write the columns of a projection, in its order, without the newline.
+   Each field has the same format as in showSensor().
+   @param[in] out Output buffer.
+   @param[in] proj Projection, or NULL for all fields as showSensor().
+   @param[in] raw Record to write.
+*/
+void showSensorFields( HOUT *out, const SENSORPROJ *proj,
+		       const SENSORDATA *raw )
+{
+  int i, n;
+
+  if( proj == NULL )
+    {
+      showSensor( out, raw );
+      return;
+    }
+  for( i = 0; i < proj->nsel; i++ )
+    {
+      if( i > 0 ) houtChar( out, ' ' );
+      n = proj->field[i];
+      houtFixed( out, raw->v[n], sensorFormat[n].width,
+		 sensorFormat[n].prec );
+    }
+} /* showSensorFields */
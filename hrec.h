@@ -0,0 +1,285 @@
+/** @file hrec.h
+    @brief
+    Harbor GPS and sensor record types and parsers.
+
+    @details
+    The record layouts and field parsers shared by hgps, hsensor and hjoin.
+    Each record type is described once by a field table, an X-macro such as
+    HREC_GPS_FIELDS, and its parser, text formatter, column table and field
+    names are all expanded from that table at compile time.  The expansions
+    are straight-line code, one statement per field with the separator,
+    conversion and format as constants, so there is no per-field dispatch at
+    run time.  A new payload format needs only its record structure, its
+    table and one HREC_PARSER() and HREC_SHOWER() line in hrec.c.  A
+    SENSORPROJ made by sensorProject() selects some of the sensor fields;
+    parseSensorFields() then converts only those and showSensorFields()
+    writes only those.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Added sensor field projections.
+    2026-Oct-14 Generate parsers, formatters and columns from field tables.
+    @endverbatim
+*/
+#ifndef HREC_H
+#define HREC_H
+#include <stddef.h>
+#include "hout.h"
+#include "hcol.h"
+#include "hcsv.h"
+
+/**
+   Fields of a GPS record in record order:
+   X( name, type, sep, units, width, prec, col ) for each, where @a name
+   is the member and column name, @a type is float or int, @a sep is the
+   separator before the field (0 for the first), @a width and @a prec are
+   the text format, and @a col is 1 if the field is a -c column.
+*/
+#define HREC_GPS_FIELDS( X )			\
+  X( tsecs,  float, 0,   "s",     6,  1, 1 )	\
+  X( mday,   int,   ',', "",      2,  0, 0 )	\
+  X( month,  int,   '/', "",      2,  0, 0 )	\
+  X( year,   int,   '/', "",      4,  0, 0 )	\
+  X( hour,   int,   ',', "",      2,  0, 0 )	\
+  X( minute, int,   ':', "",      2,  0, 0 )	\
+  X( second, int,   ':', "",      2,  0, 0 )	\
+  X( lat,    float, ',', "deg",  11,  7, 1 )	\
+  X( lon,    float, ',', "deg",  12,  7, 1 )	\
+  X( alt,    float, ',', "m",     8,  1, 1 )	\
+  X( nsats,  int,   ',', "count", 2,  0, 1 )
+
+/**
+   Fields of a sensor record in record order, as for HREC_GPS_FIELDS.
+   The order must also be the lane order of SENSORDATA.
+*/
+#define HREC_SENSOR_FIELDS( X )			\
+  X( tsecs, float, 0,   "s",      6, 1, 1 )	\
+  X( tmpi,  float, ',', "counts", 5, 1, 1 )	\
+  X( a1x,   float, ',', "counts", 0, 6, 1 )	\
+  X( a1y,   float, ',', "counts", 0, 6, 1 )	\
+  X( a1z,   float, ',', "counts", 0, 6, 1 )	\
+  X( a2x,   float, ',', "counts", 0, 6, 1 )	\
+  X( a2y,   float, ',', "counts", 0, 6, 1 )	\
+  X( a2z,   float, ',', "counts", 0, 6, 1 )	\
+  X( magx,  float, ',', "counts", 0, 6, 1 )	\
+  X( magy,  float, ',', "counts", 0, 6, 1 )	\
+  X( magz,  float, ',', "counts", 0, 6, 1 )	\
+  X( gyrx,  float, ',', "counts", 0, 6, 1 )	\
+  X( gyry,  float, ',', "counts", 0, 6, 1 )	\
+  X( gyrz,  float, ',', "counts", 0, 6, 1 )	\
+  X( humid, float, ',', "counts", 0, 6, 1 )	\
+  X( prss,  float, ',', "counts", 0, 6, 1 )	\
+  X( tmpx,  float, ',', "counts", 0, 6, 1 )	\
+  X( vbat,  float, ',', "counts", 0, 6, 1 )
+
+/*
+  Per-type pieces of the expansions below: the converter, column type,
+  wide type and formatter of float and int fields.
+*/
+#define HREC_CONV_float hcsvFloat
+#define HREC_CONV_int hcsvInt
+#define HREC_HCOL_float HCOL_FLOAT32
+#define HREC_HCOL_int HCOL_INT32
+#define HREC_WIDE_float double
+#define HREC_WIDE_int int
+#define HREC_SHOW_float( out, v, width, prec ) houtFixed( out, v, width, prec )
+#define HREC_SHOW_int( out, v, width, prec ) houtInt( out, v, width )
+
+/**
+   Parse one field; the expansion of HREC_PARSER().  n counts the fields
+   converted, as the sscanf() return value would.
+*/
+#define HREC_PARSE1( name, type, sep, units, width, prec, col )		\
+  if( (sep && !hcsvSep( &p, end, sep )) ||				\
+      !HREC_CONV_##type( &p, end, &raw->name ) )			\
+    return n;								\
+  n++;
+
+/**
+   Define a parser, int fn( const char *str, const char *end, rtype *raw ),
+   from a field table.  It returns the number of fields converted and
+   stores them as they are converted, like sscanf().
+*/
+#define HREC_PARSER( fn, rtype, TABLE )					\
+  int fn( const char *str, const char *end, rtype *raw )		\
+  {									\
+    const char *p = str;						\
+    int n = 0;								\
+									\
+    TABLE( HREC_PARSE1 )						\
+    return n;								\
+  }
+
+/**
+   Format one field; the expansion of HREC_SHOWER().
+*/
+#define HREC_SHOW1( name, type, sep, units, width, prec, col )		\
+  if( n++ > 0 ) houtChar( out, ' ' );					\
+  HREC_SHOW_##type( out, rec->name, width, prec );
+
+/**
+   Define a formatter, void fn( HOUT *out, const rtype *rec ), that writes
+   the fields of a table as space-separated fixed length columns without
+   the newline.  Any structure with members of those names will do, such
+   as the wide form of a record.
+*/
+#define HREC_SHOWER( fn, rtype, TABLE )					\
+  void fn( HOUT *out, const rtype *rec )				\
+  {									\
+    int n = 0;								\
+									\
+    TABLE( HREC_SHOW1 )							\
+  }
+
+/**
+   One -c column; the expansion of HREC_COLUMNS().  The offset is taken
+   with HREC_OFFSET( name ), which the user defines, for example as
+   offsetof(GPSDATA, name).
+*/
+#define HREC_COLUMN1( name, type, sep, units, width, prec, col )	\
+  HREC_COLUMN_##col( name, type, units )
+#define HREC_COLUMN_0( name, type, units )
+#define HREC_COLUMN_1( name, type, units )			\
+  { #name, units, HREC_HCOL_##type, HREC_OFFSET( name ) },
+
+/**
+   Initializers of the hcol column definitions of a table.
+*/
+#define HREC_COLUMNS( TABLE ) TABLE( HREC_COLUMN1 )
+
+/**
+   Count one -c column; the expansion of HREC_NCOLUMNS().
+*/
+#define HREC_NCOLUMN1( name, type, sep, units, width, prec, col ) +col
+
+/**
+   Number of -c columns of a table, a constant expression.
+*/
+#define HREC_NCOLUMNS( TABLE ) (0 TABLE( HREC_NCOLUMN1 ))
+
+/**
+   One member of the wide form of a record; the expansion of
+   HREC_WIDE().
+*/
+#define HREC_WIDE1( name, type, sep, units, width, prec, col )	\
+  HREC_WIDE_##type name;
+
+/**
+   Members of the wide form of a record: the fields of a table with the
+   floating point ones in double, for averages.
+*/
+#define HREC_WIDE( TABLE ) TABLE( HREC_WIDE1 )
+
+/**
+   GPS record data structure.  All times are UT.
+*/
+typedef struct
+{
+  int mday;      ///< Day of month, 1-31
+  int month;     ///< Month, 1-12
+  int year;      ///< Year, >2000
+  int hour;      ///< Hour, 0-23
+  int minute;    ///< Minute, 0-59
+  int second;    ///< Second, 0-59
+  int todaySecs; ///< Seconds since midnight, 0-86399
+  int nsats;     ///< Number of GPS satellites in view
+  float tsecs;   ///< Seconds since start of dataset
+  float lat;     ///< Latitude, deg north
+  float lon;     ///< Longitude, deg east
+  float alt;     ///< Altitude, m above MSL
+} GPSDATA;
+
+/**
+   GPS record in wide form, for writing averages at full precision.
+*/
+typedef struct
+{
+  HREC_WIDE( HREC_GPS_FIELDS )
+} GPSWIDE;
+
+/**
+   Number of fields in a GPS record.
+*/
+#define GPS_NFIELDS 11
+
+/**
+   Number of comma-separated fields in a sensor record.
+*/
+#define SENSOR_NFIELDS 18
+
+/**
+   Number of float lanes in a record, SENSOR_NFIELDS padded to a whole
+   number of SENSORVEC vectors.
+*/
+#define SENSOR_NLANES 20
+
+/**
+   Four float lanes, an SSE or NEON register.  Arithmetic on these is done
+   lane by lane, so sums and averages are bit-identical to scalar code.
+*/
+typedef float SENSORVEC __attribute__((vector_size(16)));
+
+/**
+   Sensor record data structure.  All times are UT.  Note that at this
+   point most of the units are unknown and the values are assumed to be
+   ADC counts.  Conversion factors need to be added.  The fields are
+   also a contiguous array, in record order, so the average can be
+   accumulated a vector at a time; the padding lanes are kept at zero.
+*/
+typedef union
+{
+  struct
+  {
+    float tsecs;            ///< Seconds since start of dataset
+    float tmpi;             ///< Internal temperature
+    float a1x, a1y, a1z;    ///< 3D Acceleration sensor 1
+    float a2x, a2y, a2z;    ///< 3D Acceleration sensor 2
+    float magx, magy, magz; ///< 3D Magnetometer
+    float gyrx, gyry, gyrz; ///< 3D Gyroscope
+    float humid;            ///< Humidity
+    float prss;             ///< Pressure
+    float tmpx;             ///< External pressure
+    float vbat;             ///< Battery voltage
+  };
+  float v[SENSOR_NLANES];                ///< Fields in record order
+  SENSORVEC vec[SENSOR_NLANES/4];        ///< Fields as vectors
+} SENSORDATA;
+
+/**
+   Selection of sensor fields, from sensorProject().  tsecs is always
+   converted, since averaging and time ranges need it, but it is only
+   written if selected.
+*/
+typedef struct
+{
+  int nsel;                  ///< Number of fields selected
+  int field[SENSOR_NFIELDS]; ///< Selected fields in output order
+  char want[SENSOR_NFIELDS]; ///< Nonzero for each field to convert
+  int nvec;                  ///< Number of vectors holding selected fields
+  int vec[SENSOR_NLANES/4];  ///< Vectors holding selected fields
+} SENSORPROJ;
+
+/**
+   Number of -c columns of a GPS record.
+*/
+#define GPS_NCOLS HREC_NCOLUMNS( HREC_GPS_FIELDS )
+
+extern const HCOLDEF gpsColumns[GPS_NCOLS];
+extern const HCOLDEF sensorColumns[SENSOR_NFIELDS];
+extern const char *const sensorNames[SENSOR_NFIELDS];
+
+int parseGPS( const char *str, const char *end, GPSDATA *raw );
+void showGPS( HOUT *out, const GPSDATA *rec );
+void showGPSWide( HOUT *out, const GPSWIDE *rec );
+int parseSensor( const char *str, const char *end, SENSORDATA *raw );
+void showSensor( HOUT *out, const SENSORDATA *raw );
+int sensorProject( const char *list, SENSORPROJ *proj );
+int parseSensorFields( const char *str, const char *end,
+		       const SENSORPROJ *proj, SENSORDATA *raw );
+void showSensorFields( HOUT *out, const SENSORPROJ *proj,
+		       const SENSORDATA *raw );
+
+#endif /* HREC_H */
@@ -0,0 +1,165 @@
+/** @file hring.h
+    @brief
+    Bounded single-producer, single-consumer ring for handing buffers
+    between threads.
+
+    @details
+    One thread puts items and one other thread gets them, in order.  The
+    ring takes no lock: the producer only ever changes the head index and
+    the consumer only the tail.  Each publishes its slot with a store of
+    its index that the other side reads with an acquire load, so while
+    the ring is neither empty nor full a hand-off is one atomic store
+    and a load or two, and neither thread makes a system call.  Only an
+    empty or full ring puts a thread to sleep, on a semaphore: it sets its
+    waiting flag and looks at the other index once more, and the other
+    thread, after its store, posts if it sees the flag.  Both pairs of
+    store and load are sequentially consistent, so either the sleeper
+    sees the index move or the other thread sees the flag.  Pipeline
+    stages use a pair of rings per link, one carrying full buffers
+    downstream and one bringing them back to be reused, so nothing is
+    allocated once a pipeline runs.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Atomic head and tail indices instead of counting semaphores.
+    @endverbatim
+*/
+#ifndef HRING_H
+#define HRING_H
+#include <stdlib.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+
+/**
+   Ring of pointers.  Use hringInit() to set one up.
+*/
+typedef struct
+{
+  void **slot;         ///< Items
+  unsigned size;       ///< Number of slots
+  atomic_uint head;    ///< Next to put, modulo 2*size, by the producer
+  atomic_uint tail;    ///< Next to get, modulo 2*size, by the consumer
+  atomic_int putWait;  ///< Nonzero while the producer may sleep
+  atomic_int getWait;  ///< Nonzero while the consumer may sleep
+  sem_t putWake;       ///< Posted for a sleeping producer
+  sem_t getWake;       ///< Posted for a sleeping consumer
+} HRING;
+
+/**
+   Set up an empty ring.
+   @param[out] r Ring.
+   @param[in] size Number of slots.
+   @return 0 on success, or -1 with errno set.
+*/
+static inline int hringInit( HRING *r, int size )
+{
+  if( (r->slot = calloc( size, sizeof(void *) )) == NULL ) return -1;
+  r->size = size;
+  atomic_init( &r->head, 0 );
+  atomic_init( &r->tail, 0 );
+  atomic_init( &r->putWait, 0 );
+  atomic_init( &r->getWait, 0 );
+  sem_init( &r->putWake, 0, 0 );
+  sem_init( &r->getWake, 0, 0 );
+  return 0;
+} /* hringInit */
+
+/**
+   Sleep until the other thread may have moved its index off a value.
+   The caller looks at the index again afterwards, as a post left over
+   from an earlier wait can end the sleep early.
+   @param[in,out] wait Waiting flag of this thread.
+   @param[in,out] wake Semaphore of this thread.
+   @param[in] index Index of the other thread.
+   @param[in] value Value it must move off.
+*/
+static inline void hringSleep( atomic_int *wait, sem_t *wake,
+			       atomic_uint *index, unsigned value )
+{
+  atomic_store( wait, 1 );
+  if( atomic_load( index ) == value )
+    while( sem_wait( wake ) && errno == EINTR )
+      ;
+  atomic_store_explicit( wait, 0, memory_order_relaxed );
+} /* hringSleep */
+
+/**
+   Wake the other thread if it may be sleeping, after moving an index
+   with atomic_store().
+   @param[in] wait Waiting flag of the other thread.
+   @param[in,out] wake Semaphore of the other thread.
+*/
+static inline void hringWake( atomic_int *wait, sem_t *wake )
+{
+  if( atomic_load( wait ) )
+    sem_post( wake );
+} /* hringWake */
+
+/**
+   Index after another.  Indices count modulo twice the size, so a full
+   ring, with the head size past the tail, differs from an empty one.
+   @param[in] r Ring.
+   @param[in] i Index.
+   @param[in] n Steps, at most 2*size.
+   @return Index n after i.
+*/
+static inline unsigned hringStep( const HRING *r, unsigned i, unsigned n )
+{
+  return i+n < 2*r->size ? i+n : i+n-2*r->size;
+} /* hringStep */
+
+/**
+   Put an item, waiting for an empty slot if the ring is full.  Only the
+   producer thread may call this.
+   @param[in,out] r Ring.
+   @param[in] item Item, which may be NULL.
+*/
+static inline void hringPut( HRING *r, void *item )
+{
+  unsigned h, full;
+
+  h = atomic_load_explicit( &r->head, memory_order_relaxed );
+  full = hringStep( r, h, r->size );
+  while( atomic_load_explicit( &r->tail, memory_order_acquire ) == full )
+    hringSleep( &r->putWait, &r->putWake, &r->tail, full );
+  r->slot[h%r->size] = item;
+  atomic_store( &r->head, hringStep( r, h, 1 ) );
+  hringWake( &r->getWait, &r->getWake );
+} /* hringPut */
+
+/**
+   Get the oldest item, waiting for one if the ring is empty.  Only the
+   consumer thread may call this.
+   @param[in,out] r Ring.
+   @return Item.
+*/
+static inline void *hringGet( HRING *r )
+{
+  void *item;
+  unsigned t;
+
+  t = atomic_load_explicit( &r->tail, memory_order_relaxed );
+  while( atomic_load_explicit( &r->head, memory_order_acquire ) == t )
+    hringSleep( &r->getWait, &r->getWake, &r->head, t );
+  item = r->slot[t%r->size];
+  atomic_store( &r->tail, hringStep( r, t, 1 ) );
+  hringWake( &r->putWait, &r->putWake );
+  return item;
+} /* hringGet */
+
+/**
+   Release a ring.  Neither thread may be using it.
+   @param[in,out] r Ring.
+*/
+static inline void hringDestroy( HRING *r )
+{
+  sem_destroy( &r->putWake );
+  sem_destroy( &r->getWake );
+  free( r->slot );
+} /* hringDestroy */
+
+#endif /* HRING_H */
@@ -8,206 +8,1559 @@
     columns of data (space-separated).  Records may be averaged over a given
     number of seconds.
     @verbatim
-    Compile: gcc -Wall -o hsensor hsensor.c
-    Use: hsensor input.csv avg_secs > output.txt
+    Compile: gcc -Wall -O2 -o hsensor hsensor.c hrec.c hcsv.c hread.c hout.c
+             hcol.c hidx.c hfilt.c hstat.c hcal.c hckpt.c hsort.c hpyr.c
+             harbor.c -pthread -lz -lm
+    Use: hsensor [-f] [-j nthreads] [--from tsecs] [--to tsecs]
+                 [--fields name[,name...]] [--cal file] [--reject k[,n]]
+                 [--slide] [--decimate minmax|lttb[,name]] [--sort[=MiB]]
+                 [--pyramid file[,secs]] [--stats] [--checkpoint file]
+                 [-o output_%s.txt] [-c output_%s.hcol] input.csv
+                 avg_secs[,avg_secs...] > output.txt
     @endverbatim
-    @arg @c input.csv is the Harbor sensor CSV data file to process
+    @arg @c --from @c tsecs and @c --to @c tsecs keep only the records
+    with tsecs in that range.  For a regular file a sidecar index,
+    input.csv.hidx (see hidx.h), is built on first use so only the part
+    of the file holding the range is read; comments are copied from that
+    part only.
+    @arg @c --fields @c name[,name...] keeps only the named fields, such
+    as tsecs,prss,tmpx,vbat, in that order.  The other fields of each
+    record are skipped without being converted or averaged.  The names
+    are those of the -c columns.
+    @arg @c --cal @c file converts the fields it names from ADC counts to
+    engineering units as each record is parsed, before any filtering or
+    averaging (see hcal.h for the format).  The -c columns get the units
+    given in the file.
+    @arg @c --reject @c k[,n] drops spikes before averaging: a record is
+    written as a comment instead if any field other than tsecs (only the
+    --fields ones, if given) is more than k robust standard deviations
+    from the median of its last n values, default n 15 (see hfilt.h).
+    -j is ignored, since the filter runs through the records in order.
+    @arg @c --slide makes each average a sliding window: every record is
+    written as the average of itself and the records of the avg_secs
+    before it, instead of one average per avg_secs period.  The window
+    sums are updated by adding the new record and subtracting the
+    expired ones, so the cost per record does not grow with avg_secs.
+    -j is ignored.
+    @arg @c --decimate @c minmax|lttb[,name] thins the records for
+    plotting instead of averaging them, keeping the spikes that an
+    average flattens; avg_secs sets the bucket length.  With @c minmax
+    each bucket is written as one line of three groups of the --fields
+    selection: the mean, the minimum and the maximum of every field, so
+    the envelope can be plotted with the mean.  With @c lttb one record
+    of each bucket is written as it is, the one chosen by the
+    Largest-Triangle-Three-Buckets method on field @a name, by default
+    the first field other than tsecs: the record making the largest
+    triangle with the record written for the bucket before and the mean
+    of the bucket after.  The first and last records are always
+    written.  Only the records of two buckets are held.  -j is ignored,
+    and minmax cannot be used with -c.
+    @arg @c --sort[=MiB] reads all the records first and reduces them in
+    order of tsecs, keeping only the first record read of each tsecs, for
+    a file with the repeated and out of order stretches a restarted
+    ground station leaves.  At most @a MiB, default 256, of records are
+    held; the sorted runs beyond that go to temporary files in $TMPDIR
+    and are merged (see hsort.h).  The comments are written as they are
+    read, so they come before the data, and --reject checks the records
+    in the order they are read.  The whole file is read even with
+    --from or --to.  -j is ignored, and it cannot be used with -f.
+    @arg @c --pyramid @c file[,secs] also writes @a file, a pyramid of
+    the sums and counts of the --fields selection over periods of secs,
+    default 1, and of 4, 16, 64 and so on times that, each level summed
+    from the one below (see hpyr.h), so that hzoom can serve the
+    averages for any zoom without another run.  The periods are aligned
+    to multiples of their length in tsecs rather than starting at a
+    record.  Records must be in tsecs order, as with --sort; any from
+    before the period being summed are left out, with a warning.  -j is
+    ignored.
+    @arg @c --stats writes a report to stderr at the end: how many lines
+    were comments, too short, cut off at the end of the input, outside
+    --from and --to, rejected, dropped or reordered by --sort, how many were
+    256 bytes or longer, the bytes and records per second, and an estimate
+    of the time spent reading, parsing, filtering, averaging and formatting
+    (see hstat.h).  It is cheap enough to leave on.  With -j the times are
+    summed over the threads, and averaging includes formatting.
+    @arg @c --checkpoint @c file saves the state of the run in @a file at
+    the end (see hckpt.h).  If @a file holds a checkpoint from a run with
+    the same options on the same input, since grown by appending, only
+    the data after it are reduced: each -o output is cut back to before
+    the average of the period that was still open, and appended to, so
+    it ends up as a run over the whole input would write it.  Otherwise,
+    as after the --cal file has been edited, the input is reduced from
+    the start.  A last line without a newline is left for the next run.
+    It needs -o and an uncompressed regular input file, and cannot be
+    used with -c, -f, --slide, --decimate, --reject, --sort or --pyramid.
+    @arg @c -f follows a file that is still being written, like "tail -f":
+    new records are processed as they are appended, with the averages
+    carried across, and the text output is flushed whenever the input is
+    caught up.  SIGINT or SIGTERM writes the open averages and exits.
+    Columnar files are finished only at exit.
+    @arg @c -j @c nthreads splits a large input file into chunks processed
+    by that many threads; the output is identical to a single-thread run.
+    Ignored with -f.
+    @arg @c -c @c output.hcol writes the records to a binary columnar file
+    (see hcol.h) instead of text columns; comments still go to the text
+    output
+    @arg @c -o @c output.txt writes the text output to a file instead of
+    stdout.  With several avg_secs values the -o and -c names must contain
+    "%s", which is replaced by each avg_secs value.  Each output file, or
+    stdout with a single avg_secs, is written by a thread of its own
+    while the next records are formatted.
+    @arg @c input.csv is the Harbor sensor CSV data file to process,
+    or - for standard input.  A gzip or zstd compressed file is
+    decompressed as it is read (see hread.h); -f, -j and the sidecar
+    index need an uncompressed file.
     @arg @c avg_secs is the number of seconds for averaging; zero for no
-    averaging
+    averaging.  A comma-separated list computes several averages in one
+    pass, each written to its own -o file.
 
     Any record that does not begin with a digit 0-9 is written as a comment
-    starting with '#'.
+    starting with '#'.  Lines may be of any length; fields after the last
+    one hsensor knows, such as the extra channels of newer firmware, are
+    ignored.
 
     @author Don Rice
     @date 2014-Nov-15 Initial version
     @verbatim
     History:
     2014-Nov-15 Initial version
+    2026-Oct-14 Replaced sscanf() with the hcsv field scanner.
+    2026-Oct-14 Read input through the memory-mapped hread reader.
+    2026-Oct-14 Added -j for multi-threaded chunked processing.
+    2026-Oct-14 Write output through the buffered hout formatter.
+    2026-Oct-14 Added -c for binary columnar output.
+    2026-Oct-14 Accept a list of avg_secs values, averaged in one pass.
+    2026-Oct-14 Added -f to follow a file that is still being written.
+    2026-Oct-14 Keep SENSORDATA as float vectors for averaging.
+    2026-Oct-14 Sum averages in double precision.
+    2026-Oct-14 Added --from and --to with a sidecar time index.
+    2026-Oct-14 Read gzip and zstd compressed input.
+    2026-Oct-14 Added --fields to select the fields converted and written.
+    2026-Oct-14 Use the field table formatters and columns of hrec.
+    2026-Oct-14 Added --reject for a streaming outlier filter.
+    2026-Oct-14 Added --slide for sliding window averages.
+    2026-Oct-14 Added --stats for line counts and stage times.
+    2026-Oct-14 Added --cal for calibration to engineering units.
+    2026-Oct-14 Write output on a writer thread; read pipes ahead.
+    2026-Oct-14 Read lines of any length.
+    2026-Oct-14 Added --checkpoint to resume where the last run ended.
+    2026-Oct-14 Added --decimate for min/max envelopes and LTTB samples.
+    2026-Oct-14 Copy runs of comment lines together.
+    2026-Oct-14 Average with the libharbor functions.
+    2026-Oct-14 Added --sort to reorder and deduplicate records by tsecs.
+    2026-Oct-14 Added --pyramid for multi-resolution averages.
+    2026-Oct-14 Read the input through harborRead().
+    2026-Oct-14 Match checkpoints on the calibration, not its file name.
     @endverbatim
 */
 /**
    Code modification date
 */
-#define CODE_MOD_DATE "Mod_Date:2014-Nov-15"
+#define CODE_MOD_DATE "Mod_Date:2026-Oct-14"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <math.h>
 #include <ctype.h>
+#include <pthread.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include "hread.h"
+#include "hout.h"
+#include "hcol.h"
+#include "hidx.h"
+#include "hrec.h"
+#include "hfilt.h"
+#include "hstat.h"
+#include "hcal.h"
+#include "hckpt.h"
+#include "hsort.h"
+#include "hpyr.h"
+#include "harbor.h"
 
 /**
-   Sensor record data structure.  All times are UT.  Note that at this
-   point most of the units are unknown and the values are assumed to be
-   ADC counts.  Conversion factors need to be added.
+   Four int lanes, the result of comparing SENSORVEC values.
+*/
+typedef int SENSORMASK __attribute__((vector_size(16)));
+
+/**
+   --decimate modes.
+*/
+enum { DECIM_NONE, DECIM_MINMAX, DECIM_LTTB };
+
+/**
+   Size of the input chunk given to each worker thread in parallel mode.
+*/
+#ifndef CHUNK_BYTES
+#define CHUNK_BYTES (8<<20)
+#endif
+
+/**
+   One line of a chunk in parallel mode: either a comment to be copied to
+   the output or a parsed record.
+*/
+typedef struct
+{
+  const char *str; ///< Start of the line
+  size_t len;      ///< Length of the line
+  int rec;         ///< Index of the parsed record, or minus the number
+                   ///< of lines of a run of comments
+} LINE;
+
+/**
+   One averaging window.  Several windows, each with its own avg_secs and
+   output, are computed in a single pass over the input.
+*/
+typedef struct
+{
+  const char *label; ///< avg_secs as given on the command line
+  float avgSecs;     ///< Averaging period, zero for no averaging
+  float t0;          ///< Start time of the current period
+  int navg;          ///< Records in the current period
+  SENSORSUM avg;     ///< Sums for the current period
+  HOUT *out;         ///< Text output
+  HCOL *col;         ///< Columnar output, or NULL for text
+  int slide;         ///< Nonzero for a sliding window
+  SENSORDATA *ring;  ///< Records in the sliding window
+  int tail;          ///< Oldest record in ring
+  int maxring;       ///< Allocated size of ring
+  int nexp;          ///< Records expired since the sums were recomputed
+  int decim;         ///< --decimate mode, DECIM_NONE for averages
+  SENSORDATA lo, hi; ///< Envelope of the current period, DECIM_MINMAX
+  SENSORDATA *bucket; ///< Records of the current period, DECIM_LTTB
+  int nbucket, maxbucket; ///< Records in bucket and allocated
+  SENSORDATA *prev;  ///< Records of the last period, waiting for a pick
+  int nprev, maxprev; ///< Records in prev and allocated
+  SENSORDATA pick;   ///< Last record written, DECIM_LTTB
+  int npick;         ///< Records written, DECIM_LTTB
+} WINDOW;
+
+/**
+   State of one window saved in a checkpoint.
 */
 typedef struct
 {
-  float tsecs;            ///< Seconds since start of dataset
-  float tmpi;             ///< Internal temperature
-  float a1x, a1y, a1z;    ///< 3D Acceleration sensor 1
-  float a2x, a2y, a2z;    ///< 3D Acceleration sensor 2
-  float magx, magy, magz; ///< 3D Magnetometer
-  float gyrx, gyry, gyrz; ///< 3D Gyroscope
-  float humid;            ///< Humidity
-  float prss;             ///< Pressure
-  float tmpx;             ///< External pressure
-  float vbat;             ///< Battery voltage
-} SENSORDATA;
-
-void showAverage( int navg, SENSORDATA *avg );
-int updateAverage( int navg, SENSORDATA *raw, SENSORDATA *avg );
+  long long outSize; ///< Size of the output without the open period
+  float t0;          ///< Start time of the open period
+  int navg;          ///< Records in the open period
+  SENSORSUM avg;     ///< Sums for the open period
+} SAVEDWIN;
+
+/**
+   Where the records and comments that harborRead() passes on go: the
+   context of its callbacks.
+*/
+typedef struct
+{
+  const char *prog;  ///< Program name, for errors
+  WINDOW *win;       ///< Windows
+  int nwin;          ///< Number of windows
+  HSORT *sort;       ///< Records held for --sort, or NULL
+  HPYR *pyr;         ///< --pyramid output, or NULL
+} SINK;
+
+/**
+   Results of one chunk for one window in parallel mode.  Records before
+   the first averaging period that starts in the chunk belong to a period
+   carried in from earlier chunks; their sums and the position of that
+   period's average in the output are left for the in-order merge.
+*/
+typedef struct
+{
+  HOUT *out;         ///< Formatted output, kept in memory
+  HCOL *col;         ///< Columnar output in memory, or NULL
+  size_t split;      ///< Output offset for the carried-in average
+  int started;       ///< Nonzero if a period starts in the chunk
+  int nhead;         ///< Records belonging to the carried-in period
+  int navg;          ///< Records in the period open at the end
+  SENSORSUM avg;     ///< Sums for the period open at the end
+} PART;
+
+/**
+   Work and results for one newline-aligned chunk of the input in parallel
+   mode.
+*/
+typedef struct
+{
+  const char *start, *end; ///< Part of the mapped input
+  WINDOW *win;             ///< Windows to compute
+  int nwin;                ///< Number of windows
+  float from, to;          ///< Range of record times to keep
+  int direct;              ///< Nonzero to format records while parsing
+  LINE *line;              ///< Lines in the chunk
+  int nline, maxline;      ///< Lines used and allocated
+  SENSORDATA *rec;         ///< Parsed records
+  int nrec, maxrec;        ///< Records used and allocated
+  char *first;             ///< Nonzero if a record starts a new period,
+                           ///< nwin flags per record
+  int maxfirst;            ///< Allocated size of first
+  PART *part;              ///< Results for each window
+  HSTAT *stats;            ///< Statistics of the chunks of this thread,
+                           ///< or NULL
+} CHUNK;
+
+/**
+   Fields selected with --fields, or NULL for all.
+*/
+static const SENSORPROJ *fields;
+
+/**
+   Calibration from --cal, or NULL for counts.
+*/
+static HCAL *cal;
+
+/**
+   Columns written with -c: sensorColumns, or the --fields selection.
+*/
+static HCOLDEF columns[SENSOR_NFIELDS];
+
+/**
+   Number of columns written with -c.
+*/
+static int ncolumns;
+
+/**
+   Field that --decimate lttb picks records by.
+*/
+static int decimField;
+
+/**
+   Statistics for --stats, or NULL.
+*/
+static HSTAT *stats;
+
+/**
+   Set by SIGINT or SIGTERM to end follow mode.
+*/
+static volatile sig_atomic_t stopFollow;
+
+void stopHandler( int sig );
+void takeRecord( void *ctx, const void *rec );
+void takeComment( void *ctx, const char *str, size_t len, size_t nlines,
+		  int why );
+void addRecord( WINDOW *w, SENSORDATA *raw );
+void slideRecord( WINDOW *w, SENSORDATA *raw );
+void decimRecord( WINDOW *w, SENSORDATA *raw );
+void showDecimated( WINDOW *w, int last );
+void pickRecord( WINDOW *w, SENSORDATA *rec, int nrec, SENSORDATA *next );
+void showRecord( HOUT *out, HCOL *col, SENSORDATA *raw );
+void showAverage( HOUT *out, HCOL *col, int navg, SENSORSUM *avg );
+void runParallel( HREADER *in, WINDOW *win, int nwin, int nthreads,
+		  float from, float to );
+void *parseChunk( void *arg );
+void *formatChunk( void *arg );
+void runThreads( void *(*fn)( void * ), CHUNK *chunk, int nchunk );
+void *growArray( void *ptr, int *max, size_t size );
+uint32_t hashCal( uint32_t hash, const HCAL *cal );
+SAVEDWIN *loadCheckpoint( const char *path, HREADER *in, uint32_t config,
+			  WINDOW *win, int nwin, const char *outName,
+			  size_t *offset );
+void saveState( SAVEDWIN *saved, WINDOW *win, int nwin );
 
 int main( int argc, char **argv )
 {
-  int navg;
-  float avgSecs, t0;
-  char str[256];
-  FILE *in;
-  SENSORDATA raw, avg;
+  int nthreads, nwin, follow, ranged, slide, decim, nchk, c, i;
+  int chkField[SENSOR_NFIELDS];
+  float from, to;
+  double mib, pyrBase;
+  const char *outName, *colName, *reject, *ckptName;
+  const char *fieldList, *decimate, *pyrName;
+  char *list, *tok, *name, range[64];
+  size_t start, end, offset, whole, tail;
+  uint32_t config;
+  SAVEDWIN *saved;
+  HSORT *sort;
+  HPYR *pyr;
+  const void *rec;
+  HREADER *in;
+  WINDOW *win, *w;
+  SENSORDATA raw;
+  SENSORPROJ proj;
+  HARBOROPTS opt;
+  HARBORCALLS calls;
+  HARBOR *h;
+  SINK sink;
+  struct sigaction sa;
 
-  if( argc != 3 )
+  static const struct option longOpts[] =
     {
-      fprintf( stderr, "Use: %s input.csv avg_secs > output.txt\n", argv[0] );
+      { "from", required_argument, NULL, 'F' },
+      { "to", required_argument, NULL, 'T' },
+      { "fields", required_argument, NULL, 'L' },
+      { "cal", required_argument, NULL, 'C' },
+      { "reject", required_argument, NULL, 'R' },
+      { "slide", no_argument, NULL, 'S' },
+      { "decimate", required_argument, NULL, 'D' },
+      { "sort", optional_argument, NULL, 'O' },
+      { "pyramid", required_argument, NULL, 'P' },
+      { "stats", no_argument, NULL, 'Z' },
+      { "checkpoint", required_argument, NULL, 'K' },
+      { NULL, 0, NULL, 0 }
+    };
+
+  nthreads = 1;
+  follow = ranged = slide = 0;
+  from = -HUGE_VALF;
+  to = HUGE_VALF;
+  outName = colName = reject = ckptName = fieldList = NULL;
+  decimate = pyrName = NULL;
+  pyrBase = 1.0;
+  sort = NULL;
+  while( (c = getopt_long( argc, argv, "fj:c:o:", longOpts, NULL )) != -1 )
+    switch( c )
+      {
+      case 'F':
+	from = atof( optarg );
+	ranged = 1;
+	break;
+      case 'T':
+	to = atof( optarg );
+	ranged = 1;
+	break;
+      case 'L':
+	if( sensorProject( optarg, &proj ) )
+	  {
+	    fprintf( stderr, "%s: bad --fields list %s\n", argv[0], optarg );
+	    exit(EXIT_FAILURE);
+	  }
+	fields = &proj;
+	fieldList = optarg;
+	break;
+      case 'C':
+	if( (cal = hcalOpen( optarg, &i )) == NULL )
+	  {
+	    if( errno == EINVAL )
+	      fprintf( stderr, "%s:%d: bad calibration\n", optarg, i );
+	    else
+	      perror( optarg );
+	    exit(EXIT_FAILURE);
+	  }
+	break;
+      case 'R':
+	reject = optarg;
+	break;
+      case 'S':
+	slide = 1;
+	break;
+      case 'D':
+	decimate = optarg;
+	break;
+      case 'P':
+	pyrName = optarg;
+	if( (tok = strrchr( optarg, ',' )) )
+	  { /* Base period after the last comma */
+	    *tok = '\0';
+	    if( !((pyrBase = atof( tok+1 )) > 0.0) )
+	      {
+		fprintf( stderr, "%s: bad --pyramid period %s\n", argv[0],
+			 tok+1 );
+		exit(EXIT_FAILURE);
+	      }
+	  }
+	break;
+      case 'O':
+	mib = optarg ? atof( optarg ) : HSORT_LIMIT/1048576.0;
+	if( mib <= 0.0 || (sort = hsortOpen( sizeof(SENSORDATA),
+					     offsetof(SENSORDATA, tsecs),
+					     mib*1048576.0 )) == NULL )
+	  {
+	    fprintf( stderr, "%s: bad --sort %s\n", argv[0], optarg );
+	    exit(EXIT_FAILURE);
+	  }
+	break;
+      case 'K':
+	ckptName = optarg;
+	break;
+      case 'Z':
+	if( (stats = hstatOpen()) == NULL )
+	  {
+	    perror( argv[0] );
+	    exit(EXIT_FAILURE);
+	  }
+	break;
+      case 'f':
+	follow = 1;
+	break;
+      case 'j':
+	nthreads = atoi( optarg );
+	break;
+      case 'c':
+	colName = optarg;
+	break;
+      case 'o':
+	outName = optarg;
+	break;
+      default:
+	nthreads = 0;
+	break;
+      }
+  if( argc-optind != 2 || nthreads < 1 )
+    {
+      fprintf( stderr, "Use: %s [-f] [-j nthreads] [--from tsecs] [--to tsecs] "
+	       "[--fields name[,name...]] [--cal file] [--reject k[,n]] "
+	       "[--slide] [--decimate minmax|lttb[,name]] [--sort[=MiB]] "
+	       "[--pyramid file[,secs]] [--stats] [--checkpoint file] "
+	       "[-o output_%%s.txt] [-c output_%%s.hcol] "
+	       "input.csv avg_secs[,avg_secs...] > output.txt\n", argv[0] );
       fprintf( stderr, "[%s]\n", CODE_MOD_DATE );
       exit(EXIT_FAILURE);
     }
+  if( (list = strdup( argv[optind+1] )) == NULL ||
+      (win = calloc( strlen( list )/2+1, sizeof(WINDOW) )) == NULL )
+    {
+      perror( argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  for( nwin = 0, tok = strtok( list, "," ); tok; tok = strtok( NULL, "," ) )
+    win[nwin++].label = tok;
+  if( nwin > 1 && (!outName || !strstr( outName, "%s" ) ||
+		   (colName && !strstr( colName, "%s" ))) )
+    {
+      fprintf( stderr, "%s: several avg_secs need -o (and -c) names "
+	       "containing %%s\n", argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  decim = DECIM_NONE;
+  if( decimate && strcmp( decimate, "minmax" ) == 0 && !colName && !slide )
+    decim = DECIM_MINMAX;
+  else if( decimate && strncmp( decimate, "lttb", 4 ) == 0 && !slide &&
+	   (decimate[4] == '\0' || decimate[4] == ',') )
+    decim = DECIM_LTTB;
+  else if( decimate )
+    {
+      fprintf( stderr, "%s: --decimate must be minmax or lttb[,name], "
+	       "without --slide, and minmax cannot be used with -c\n",
+	       argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  if( ckptName && (!outName || colName || follow || slide || reject ||
+		   decim || sort || pyrName) )
+    {
+      fprintf( stderr, "%s: --checkpoint needs -o, and cannot be used with "
+	       "-c, -f, --slide, --decimate, --reject, --sort or "
+	       "--pyramid\n", argv[0] );
+      exit(EXIT_FAILURE);
+    }
+  if( sort && follow )
+    {
+      fprintf( stderr, "%s: --sort cannot be used with -f\n", argv[0] );
+      exit(EXIT_FAILURE);
+    }
   /* Open input file, CSV format */
-  if( (in = fopen( argv[1], "r" )) == NULL )
+  if( (in = hreadOpen( argv[optind] )) == NULL )
     {
-      perror( argv[1] );
+      perror( argv[optind] );
       exit(EXIT_FAILURE);
     }
-  avgSecs = atof( argv[2] );
-  printf( "# %s %s %s\n", argv[0], argv[1], argv[2] );
-
-  /* Read through input file; process lines that start with a digit. */
-  t0 = -1.0;
-  navg = 0;
-  while( fgets( str, 256, in ) )
+  saved = NULL;
+  config = 0;
+  end = tail = 0;
+  if( ckptName )
+    { /* The options the output depends on, for matching a checkpoint */
+      if( in->map == NULL )
+	{
+	  fprintf( stderr, "%s: --checkpoint needs an uncompressed regular "
+		   "file\n", argv[optind] );
+	  exit(EXIT_FAILURE);
+	}
+      snprintf( range, sizeof(range), "%a %a", from, to );
+      config = hckptHash( 0, "hsensor" );
+      config = hckptHash( config, argv[optind+1] );
+      config = hckptHash( config, fieldList ? fieldList : "" );
+      config = hashCal( config, cal );
+      config = hckptHash( config, range );
+      config = hckptHash( config, outName );
+      saved = loadCheckpoint( ckptName, in, config, win, nwin, outName,
+			      &offset );
+    }
+  if( follow )
     {
-      if( !isdigit( *str ) ) /* Not a data record */
+      if( hreadFollow( in, argv[optind] ) )
 	{
-	  printf( "# %s", str );
-	  continue;
+	  perror( argv[optind] );
+	  exit(EXIT_FAILURE);
 	}
-      if( sscanf( str, "%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f,%f",
-		  &raw.tsecs, &raw.tmpi, &raw.a1x, &raw.a1y, &raw.a1z,
-		  &raw.a2x, &raw.a2y, &raw.a2z, &raw.magx, &raw.magy,
-		  &raw.magz, &raw.gyrx, &raw.gyry, &raw.gyrz, &raw.humid,
-		  &raw.prss, &raw.tmpx, &raw.vbat ) != 18 )
-	{ /* Insufficient data, treat at somment */
-	  printf( "# %s", str );
-	  continue;
+      /* Finish the open periods and exit normally on a signal */
+      memset( &sa, 0, sizeof(sa) );
+      sa.sa_handler = stopHandler;
+      sigaction( SIGINT, &sa, NULL );
+      sigaction( SIGTERM, &sa, NULL );
+    }
+  else if( ((ranged && !sort) || ckptName) && in->map )
+    { /* Read only the part of the file that holds the time range, and
+	 with a checkpoint the whole lines not yet reduced */
+      start = 0;
+      end = in->mapSize;
+      if( ranged && hidxRange( argv[optind], in, from, to, &start, &end ) )
+	{
+	  perror( argv[optind] );
+	  exit(EXIT_FAILURE);
+	}
+      if( saved && start < offset ) start = offset;
+      if( start > end ) start = end;
+      tail = end;
+      if( ckptName && end > (whole = hckptWhole( in )) )
+	end = start > whole ? start : whole;
+      if( hreadRange( in, start, end ) )
+	{
+	  perror( argv[optind] );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  /* Fields checked for outliers, as harborOpen() finds them */
+  for( nchk = 0, i = 0; i < (fields ? fields->nsel : SENSOR_NFIELDS); i++ )
+    if( (c = fields ? fields->field[i] : i) != 0 ) chkField[nchk++] = c;
+  if( decim == DECIM_LTTB )
+    { /* Field to pick by: as named, or the first checked for outliers */
+      decimField = nchk > 0 ? chkField[0] : 0;
+      if( decimate[4] == ',' )
+	{
+	  for( i = 0; i < nchk && strcmp( sensorNames[chkField[i]],
+					  decimate+5 ); i++ )
+	    ;
+	  if( i == nchk )
+	    {
+	      fprintf( stderr, "%s: --decimate field %s is not a selected "
+		       "field other than tsecs\n", argv[0], decimate+5 );
+	      exit(EXIT_FAILURE);
+	    }
+	  decimField = chkField[i];
+	}
+    }
+  /* The records and comments of each line, for the windows to average */
+  harborOptions( &opt, HARBOR_SENSOR );
+  opt.from = from;
+  opt.to = to;
+  opt.reject = reject;
+  opt.fields = fields;
+  opt.cal = cal;
+  opt.stats = stats;
+  calls = (HARBORCALLS) { &sink, takeRecord, NULL, takeComment };
+  if( (h = harborOpen( &opt, &calls )) == NULL )
+    {
+      fprintf( stderr, "%s: bad --reject %s\n", argv[0], reject );
+      exit(EXIT_FAILURE);
+    }
+  if( fields )
+    for( ncolumns = 0; ncolumns < fields->nsel; ncolumns++ )
+      columns[ncolumns] = sensorColumns[fields->field[ncolumns]];
+  else
+    for( ncolumns = 0; ncolumns < SENSOR_NFIELDS; ncolumns++ )
+      columns[ncolumns] = sensorColumns[ncolumns];
+  for( i = 0; cal && i < ncolumns; i++ )
+    { /* Units of the calibrated columns */
+      c = fields ? fields->field[i] : i;
+      if( cal->units[c][0] ) columns[i].units = cal->units[c];
+    }
+  pyr = NULL;
+  if( pyrName &&
+      (pyr = hpyrOpen( pyrName, pyrBase, columns, ncolumns )) == NULL )
+    {
+      perror( pyrName );
+      exit(EXIT_FAILURE);
+    }
+  for( i = 0; i < nwin; i++ )
+    { /* Open the outputs for each window */
+      w = &win[i];
+      w->avgSecs = atof( w->label );
+      w->t0 = saved ? saved[i].t0 : -1.0;
+      w->navg = saved ? saved[i].navg : 0;
+      if( saved ) w->avg = saved[i].avg;
+      w->slide = slide && w->avgSecs > 0.0;
+      w->decim = w->avgSecs > 0.0 ? decim : DECIM_NONE;
+      if( outName )
+	{
+	  name = houtName( outName, w->label );
+	  if( (w->out = saved ? houtResume( name, saved[i].outSize ) :
+	       houtCreate( name )) == NULL )
+	    {
+	      perror( name );
+	      exit(EXIT_FAILURE);
+	    }
+	  free( name );
 	}
-      /* Write out as fixed length columns */
-      if( avgSecs <= 0.0 ) /* No averaging */
-	printf( "%6.1f %5.1f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f\n",
-		raw.tsecs, raw.tmpi, raw.a1x, raw.a1y, raw.a1z,
-		raw.a2x, raw.a2y, raw.a2z, raw.magx, raw.magy,
-		raw.magz, raw.gyrx, raw.gyry, raw.gyrz, raw.humid,
-		raw.prss, raw.tmpx, raw.vbat );
       else
-	{ /* Average measurements for given number of seconds */
-	  if( raw.tsecs-t0 > avgSecs || t0 < 0.0 )
-	    { /* Compute and display average for last period */
-	      showAverage( navg, &avg );
-	      navg = updateAverage( 0, &raw, &avg );
-	      t0 = raw.tsecs;
+	w->out = houtOpen( STDOUT_FILENO );
+      /* Windows sharing standard output keep writing it in turn */
+      if( (outName || nwin == 1) && houtAsync( w->out ) )
+	{
+	  perror( "houtAsync" );
+	  exit(EXIT_FAILURE);
+	}
+      if( colName )
+	{
+	  name = houtName( colName, w->label );
+	  if( (w->col = hcolOpen( name, columns, ncolumns ))
+	      == NULL )
+	    {
+	      perror( name );
+	      exit(EXIT_FAILURE);
 	    }
-	  else /* Accumulate data for next average */
-	    navg = updateAverage( navg, &raw, &avg );
+	  free( name );
+	}
+      if( !saved )
+	houtPrintf( w->out, "# %s %s %s\n", argv[0], argv[optind], w->label );
+    }
+  if( ckptName )
+    { /* Filled in by saveState() */
+      free( saved );
+      if( (saved = calloc( nwin, sizeof(SAVEDWIN) )) == NULL )
+	{
+	  perror( argv[0] );
+	  exit(EXIT_FAILURE);
+	}
+    }
+
+  sink = (SINK) { argv[0], win, nwin, sort, pyr };
+  if( nthreads > 1 && in->map && !follow && !reject && !slide && !decim &&
+      !sort && !pyr )
+    { /* Split the mapped file between worker threads */
+      runParallel( in, win, nwin, nthreads, from, to );
+      if( ckptName && in->size < tail )
+	{ /* Checkpoint at the last whole line, then do the rest */
+	  offset = in->size;
+	  saveState( saved, win, nwin );
+	  hreadRange( in, offset, tail );
+	  runParallel( in, win, nwin, nthreads, from, to );
+	}
+    }
+  else
+    {
+      for( ;; )
+	{
+	  harborRead( h, in );
+	  if( ckptName && in->size < tail )
+	    { /* Checkpoint at the last whole line, then read the rest */
+	      offset = in->size;
+	      saveState( saved, win, nwin );
+	      hreadRange( in, offset, tail );
+	      continue;
+	    }
+	  if( !follow || stopFollow ) break;
+	  /* Show what we have, then wait for the file to grow */
+	  for( i = 0; i < nwin; i++ ) houtFlush( win[i].out );
+	  if( hreadWait( in ) && errno != EINTR )
+	    {
+	      perror( argv[optind] );
+	      exit(EXIT_FAILURE);
+	    }
+	}
+    }
+  harborClose( h );
+  if( sort )
+    { /* The records in order of tsecs, without repeats */
+      if( hsortFinish( sort ) )
+	{
+	  perror( argv[0] );
+	  exit(EXIT_FAILURE);
+	}
+      while( (rec = hsortNext( sort )) )
+	{
+	  raw = *(const SENSORDATA *) rec;
+	  for( i = 0; i < nwin; i++ ) addRecord( &win[i], &raw );
+	  if( pyr ) hpyrAdd( pyr, raw.tsecs, &raw );
+	}
+      if( sort->err )
+	{
+	  errno = sort->err;
+	  perror( argv[0] );
+	  exit(EXIT_FAILURE);
+	}
+      hstatAdd( stats, HSTAT_RECORDS, -sort->ndup );
+      hstatAdd( stats, HSTAT_DUPLICATES, sort->ndup );
+      hstatAdd( stats, HSTAT_UNORDERED, sort->nout );
+      hstatLap( stats, HSTAT_AVERAGE );
+      hsortClose( sort );
+    }
+  if( ckptName && in->size == end )
+    { /* No partial line: checkpoint at the end */
+      offset = end;
+      saveState( saved, win, nwin );
+    }
+  for( i = 0; i < nwin; i++ )
+    {
+      w = &win[i];
+      if( w->decim ) showDecimated( w, 1 );
+      else if( !w->slide ) showAverage( w->out, w->col, w->navg, &w->avg );
+      free( w->ring );
+      free( w->bucket );
+      free( w->prev );
+      if( w->col && hcolClose( w->col ) )
+	{
+	  perror( colName );
+	  exit(EXIT_FAILURE);
 	}
+      houtClose( w->out );
     }
-  showAverage( navg, &avg );
-  fclose( in );
+  if( saved && hckptSave( ckptName, in, offset, config, saved,
+			  nwin*sizeof(SAVEDWIN) ) )
+    {
+      perror( ckptName );
+      exit(EXIT_FAILURE);
+    }
+  free( saved );
+  if( pyr )
+    {
+      if( pyr->nskip )
+	fprintf( stderr, "%s: %lld records out of order left out of %s\n",
+		 argv[0], pyr->nskip, pyrName );
+      if( hpyrClose( pyr ) )
+	{
+	  perror( pyrName );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  if( stats )
+    {
+      hstatLap( stats, HSTAT_FORMAT );
+      hstatReport( stats, stderr, argv[0], argv[optind] );
+      hstatClose( stats );
+    }
+  hreadClose( in );
+  hcalClose( cal );
+  free( win );
+  free( list );
   exit(EXIT_SUCCESS);
 } /* main */
 
+/**
+   Signal handler that ends follow mode.
+   @param[in] sig Signal number.
+*/
+void stopHandler( int sig )
+{
+  stopFollow = 1;
+} /* stopHandler */
+
+/**
+   Take an accepted record from harborRead(): hold it for --sort, or add
+   it to each window and the pyramid.
+   @param[in] ctx SINK.
+   @param[in] rec SENSORDATA record.
+*/
+void takeRecord( void *ctx, const void *rec )
+{
+  SINK *s = ctx;
+  SENSORDATA raw;
+  int i;
+
+  if( s->sort )
+    { /* Reduced in order at the end */
+      if( hsortAdd( s->sort, rec ) )
+	{
+	  perror( s->prog );
+	  exit(EXIT_FAILURE);
+	}
+    }
+  else
+    {
+      raw = *(const SENSORDATA *) rec;
+      for( i = 0; i < s->nwin; i++ ) addRecord( &s->win[i], &raw );
+      if( s->pyr ) hpyrAdd( s->pyr, raw.tsecs, &raw );
+    }
+  hstatLap( stats, HSTAT_AVERAGE );
+} /* takeRecord */
+
+/**
+   Take a line, or a run of comment lines, from harborRead() and write it
+   to each window as comments.
+   @param[in] ctx SINK.
+   @param[in] str Lines.
+   @param[in] len Length of the lines.
+   @param[in] nlines Number of lines.
+   @param[in] why HSTAT_* reason, not used.
+*/
+void takeComment( void *ctx, const char *str, size_t len, size_t nlines,
+		  int why )
+{
+  SINK *s = ctx;
+  int i;
+
+  for( i = 0; i < s->nwin; i++ )
+    houtComments( s->win[i].out, str, len, nlines );
+  hstatLap( stats, HSTAT_FORMAT );
+} /* takeComment */
+
+/**
+   Add one parsed record to a window.  Without averaging the record is
+   written out directly; otherwise it is accumulated, and the average of
+   the last period is written when a new period starts.
+   @param[in,out] w Window.
+   @param[in] raw Record.
+*/
+void addRecord( WINDOW *w, SENSORDATA *raw )
+{
+  /* Write out as fixed length columns */
+  if( w->avgSecs <= 0.0 ) /* No averaging */
+    {
+      hstatLap( stats, HSTAT_AVERAGE );
+      showRecord( w->out, w->col, raw );
+      hstatLap( stats, HSTAT_FORMAT );
+    }
+  else if( w->slide )
+    slideRecord( w, raw );
+  else if( w->decim )
+    decimRecord( w, raw );
+  else
+    { /* Average measurements for given number of seconds */
+      if( raw->tsecs-w->t0 > w->avgSecs || w->t0 < 0.0 )
+	{ /* Compute and display average for last period */
+	  hstatLap( stats, HSTAT_AVERAGE );
+	  showAverage( w->out, w->col, w->navg, &w->avg );
+	  hstatLap( stats, HSTAT_FORMAT );
+	  w->navg = harborSensorAdd( fields, 0, raw, &w->avg );
+	  w->t0 = raw->tsecs;
+	}
+      else /* Accumulate data for next average */
+	w->navg = harborSensorAdd( fields, w->navg, raw, &w->avg );
+    }
+} /* addRecord */
+
+/**
+   Add one parsed record to a sliding window and write the average of the
+   window.  The records more than avgSecs older than the new one are
+   subtracted from the sums and the new one is added, so the work per
+   record is constant on average however many records the window holds.
+   Once as many records have been subtracted as the window holds, the
+   sums are recomputed from the records, so rounding errors do not build
+   up; that too is a constant amount of work per record on average.
+   @param[in,out] w Window.
+   @param[in] raw Record.
+*/
+void slideRecord( WINDOW *w, SENSORDATA *raw )
+{
+  int i, r;
+
+  while( w->navg > 0 && raw->tsecs-w->ring[w->tail].tsecs > w->avgSecs )
+    { /* Expire the oldest record */
+      w->navg = harborSensorDrop( fields, w->navg, &w->ring[w->tail],
+				  &w->avg );
+      if( ++w->tail == w->maxring ) w->tail = 0;
+      w->nexp++;
+    }
+  if( w->navg == w->maxring )
+    { /* Grow the ring, keeping the records in order from tail */
+      r = w->maxring;
+      w->ring = growArray( w->ring, &w->maxring, sizeof(SENSORDATA) );
+      memcpy( w->ring+r, w->ring, w->tail*sizeof(SENSORDATA) );
+    }
+  w->ring[(w->tail+w->navg)%w->maxring] = *raw;
+  w->navg = harborSensorAdd( fields, w->navg, raw, &w->avg );
+  if( w->nexp >= w->navg )
+    { /* Recompute the sums from the records */
+      for( i = 0, r = w->tail; i < w->navg; i++, r = (r+1)%w->maxring )
+	harborSensorAdd( fields, i, &w->ring[r], &w->avg );
+      w->nexp = 0;
+    }
+  hstatLap( stats, HSTAT_AVERAGE );
+  showAverage( w->out, w->col, w->navg, &w->avg );
+  hstatLap( stats, HSTAT_FORMAT );
+} /* slideRecord */
+
+/**
+   Add one parsed record to a decimating window.  The periods are those
+   of averaging; when a new one starts the last one is written by
+   showDecimated().  For DECIM_MINMAX the sums and the envelope of the
+   period are kept, for DECIM_LTTB its records.
+   @param[in,out] w Window.
+   @param[in] raw Record.
+*/
+void decimRecord( WINDOW *w, SENSORDATA *raw )
+{
+  SENSORMASK m;
+  int i, n, nvec;
+
+  if( raw->tsecs-w->t0 > w->avgSecs || w->t0 < 0.0 )
+    { /* Write out the last period */
+      hstatLap( stats, HSTAT_AVERAGE );
+      showDecimated( w, 0 );
+      hstatLap( stats, HSTAT_FORMAT );
+      w->navg = 0;
+      w->t0 = raw->tsecs;
+      w->lo = w->hi = *raw;
+    }
+  if( w->decim == DECIM_MINMAX )
+    {
+      w->navg = harborSensorAdd( fields, w->navg, raw, &w->avg );
+      nvec = fields ? fields->nvec : SENSOR_NLANES/4;
+      for( n = 0; n < nvec; n++ )
+	{ /* Blend the lanes outside the envelope into it */
+	  i = fields ? fields->vec[n] : n;
+	  m = raw->vec[i] < w->lo.vec[i];
+	  w->lo.vec[i] = (SENSORVEC) (((SENSORMASK) raw->vec[i] & m) |
+				      ((SENSORMASK) w->lo.vec[i] & ~m));
+	  m = raw->vec[i] > w->hi.vec[i];
+	  w->hi.vec[i] = (SENSORVEC) (((SENSORMASK) raw->vec[i] & m) |
+				      ((SENSORMASK) w->hi.vec[i] & ~m));
+	}
+    }
+  else if( w->npick == 0 )
+    { /* The first record is always written */
+      showRecord( w->out, w->col, raw );
+      w->pick = *raw;
+      w->npick++;
+    }
+  else
+    {
+      if( w->nbucket == w->maxbucket )
+	w->bucket = growArray( w->bucket, &w->maxbucket, sizeof(SENSORDATA) );
+      w->bucket[w->nbucket++] = *raw;
+    }
+} /* decimRecord */
+
+/**
+   Write out a decimating window for the period that just ended.  For
+   DECIM_MINMAX that is the mean, minimum and maximum of the period on one
+   line of text.  For DECIM_LTTB the mean of the period is what the record
+   of the period before is picked against, and the period's records wait
+   for the mean of the next one.  At the end of the input the last record
+   is the third point instead, and it is written too.
+   @param[in,out] w Window.
+   @param[in] last Nonzero at the end of the input.
+*/
+void showDecimated( WINDOW *w, int last )
+{
+  SENSORDATA next, *r;
+  double t, y;
+  int i, n;
+
+  if( w->decim == DECIM_MINMAX )
+    {
+      if( w->navg < 1 ) return;
+      harborSensorMean( fields, w->navg, &w->avg, &next );
+      showSensorFields( w->out, fields, &next );
+      houtChar( w->out, ' ' );
+      showSensorFields( w->out, fields, &w->lo );
+      houtChar( w->out, ' ' );
+      showSensorFields( w->out, fields, &w->hi );
+      houtChar( w->out, '\n' );
+      return;
+    }
+  if( w->nbucket > 0 )
+    {
+      if( w->nprev > 0 )
+	{ /* Pick from the last period against the mean of this one */
+	  t = y = 0.0;
+	  for( i = 0; i < w->nbucket; i++ )
+	    {
+	      t += w->bucket[i].tsecs;
+	      y += w->bucket[i].v[decimField];
+	    }
+	  next.tsecs = t/w->nbucket;
+	  next.v[decimField] = y/w->nbucket;
+	  pickRecord( w, w->prev, w->nprev, &next );
+	}
+      /* This period now waits for the next */
+      r = w->prev;
+      w->prev = w->bucket;
+      w->bucket = r;
+      n = w->maxprev;
+      w->maxprev = w->maxbucket;
+      w->maxbucket = n;
+      w->nprev = w->nbucket;
+      w->nbucket = 0;
+    }
+  if( last && w->nprev > 0 )
+    { /* Pick from the rest of the last period against its last record */
+      r = &w->prev[w->nprev-1];
+      if( w->nprev > 1 ) pickRecord( w, w->prev, w->nprev-1, r );
+      showRecord( w->out, w->col, r );
+      w->nprev = 0;
+    }
+} /* showDecimated */
+
+/**
+   Write the record of a period that makes the largest triangle with the
+   last record written and a point after the period, and make it the
+   last record written.  Only tsecs and the decimField field are used;
+   the first of equal records is taken, and NaN values never are unless
+   every record has them.
+   @param[in,out] w Window, with the last record written in pick.
+   @param[in] rec Records of the period.
+   @param[in] nrec Number of records, at least one.
+   @param[in] next Point after the period.
+*/
+void pickRecord( WINDOW *w, SENSORDATA *rec, int nrec, SENSORDATA *next )
+{
+  double at, ay, dt, dy, area, best;
+  int i, b;
+
+  at = w->pick.tsecs;
+  ay = w->pick.v[decimField];
+  dt = next->tsecs-at;
+  dy = next->v[decimField]-ay;
+  for( b = 0, best = -1.0, i = 0; i < nrec; i++ )
+    { /* Twice the area of the triangle */
+      area = fabs( dt*(rec[i].v[decimField]-ay)-(rec[i].tsecs-at)*dy );
+      if( area > best )
+	{
+	  best = area;
+	  b = i;
+	}
+    }
+  showRecord( w->out, w->col, &rec[b] );
+  w->pick = rec[b];
+  w->npick++;
+} /* pickRecord */
+
+/**
+   Process a mapped input file on several threads.  The file is handled in
+   rounds of one CHUNK_BYTES chunk per thread.  Each round the chunks are
+   parsed in parallel, the averaging periods of every window are found
+   with one cheap pass over the record times, the chunks are averaged and
+   formatted in parallel, and the results are merged in order.  Write
+   order and the order of every floating point sum match the serial loop
+   in main(), so the output is identical.  The period still open at the
+   end is left in each WINDOW for main() to write.
+   @param[in] in Reader with a mapped input file.
+   @param[in,out] win Windows, with their outputs open.
+   @param[in] nwin Number of windows.
+   @param[in] nthreads Number of worker threads.
+   @param[in] from Earliest record time to keep.
+   @param[in] to Latest record time to keep.
+*/
+void runParallel( HREADER *in, WINDOW *win, int nwin, int nthreads,
+		  float from, float to )
+{
+  CHUNK *chunk, *c;
+  PART *pt;
+  WINDOW *w;
+  const char *p, *end, *nl;
+  int nchunk, i, j, r;
+
+  if( (chunk = calloc( nthreads, sizeof(CHUNK) )) == NULL )
+    {
+      perror( "runParallel" );
+      exit(EXIT_FAILURE);
+    }
+  for( i = 0; i < nthreads; i++ )
+    {
+      c = &chunk[i];
+      c->win = win;
+      c->nwin = nwin;
+      c->from = from;
+      c->to = to;
+      c->direct = (nwin == 1 && win[0].avgSecs <= 0.0);
+      if( stats && (c->stats = hstatOpen()) == NULL )
+	{
+	  perror( "runParallel" );
+	  exit(EXIT_FAILURE);
+	}
+      if( (c->part = calloc( nwin, sizeof(PART) )) == NULL )
+	{
+	  perror( "runParallel" );
+	  exit(EXIT_FAILURE);
+	}
+      for( j = 0; j < nwin; j++ )
+	{
+	  c->part[j].out = houtOpen( -1 );
+	  if( win[j].col )
+	    c->part[j].col = hcolOpen( NULL, columns, ncolumns );
+	}
+    }
+  p = in->map+in->pos;
+  end = in->map+in->size;
+  while( p < end )
+    {
+      /* Cut the next round of newline-aligned chunks */
+      for( nchunk = 0; nchunk < nthreads && p < end; nchunk++ )
+	{
+	  c = &chunk[nchunk];
+	  c->start = p;
+	  if( end-p <= CHUNK_BYTES ) p = end;
+	  else
+	    {
+	      p += CHUNK_BYTES;
+	      nl = memchr( p-1, '\n', end-(p-1) );
+	      p = nl ? nl+1 : end;
+	    }
+	  c->end = p;
+	}
+      runThreads( parseChunk, chunk, nchunk );
+      if( !chunk[0].direct )
+	{
+	  /* Find where each averaging period starts, as addRecord() would */
+	  for( i = 0; i < nchunk; i++ )
+	    {
+	      c = &chunk[i];
+	      if( c->nrec*nwin > c->maxfirst )
+		{
+		  c->maxfirst = c->nrec*nwin;
+		  if( (c->first = realloc( c->first, c->maxfirst )) == NULL )
+		    {
+		      perror( "runParallel" );
+		      exit(EXIT_FAILURE);
+		    }
+		}
+	      for( j = 0; j < nwin; j++ )
+		{
+		  w = &win[j];
+		  if( w->avgSecs <= 0.0 ) continue;
+		  for( r = 0; r < c->nrec; r++ )
+		    if( (c->first[r*nwin+j] = (c->rec[r].tsecs-w->t0 >
+					       w->avgSecs || w->t0 < 0.0)) )
+		      w->t0 = c->rec[r].tsecs;
+		}
+	    }
+	  runThreads( formatChunk, chunk, nchunk );
+	}
+      for( i = 0; i < nchunk; i++ )
+	for( c = &chunk[i], j = 0; j < nwin; j++ )
+	  {
+	    w = &win[j];
+	    pt = &c->part[j];
+	    if( w->avgSecs > 0.0 )
+	      { /* Finish the period carried in from the previous chunk */
+		for( r = 0; r < pt->nhead; r++ )
+		  w->navg = harborSensorAdd( fields, w->navg, &c->rec[r],
+					     &w->avg );
+		if( pt->started )
+		  {
+		    houtStr( w->out, pt->out->buf, pt->split );
+		    showAverage( w->out, w->col, w->navg, &w->avg );
+		    houtStr( w->out, pt->out->buf+pt->split,
+			     pt->out->len-pt->split );
+		    w->navg = pt->navg;
+		    w->avg = pt->avg;
+		  }
+		else
+		  houtStr( w->out, pt->out->buf, pt->out->len );
+	      }
+	    else
+	      houtStr( w->out, pt->out->buf, pt->out->len );
+	    if( w->col ) hcolMerge( w->col, pt->col );
+	  }
+    }
+
+  for( i = 0; i < nthreads; i++ )
+    {
+      c = &chunk[i];
+      for( j = 0; j < nwin; j++ )
+	{
+	  houtClose( c->part[j].out );
+	  if( c->part[j].col ) hcolClose( c->part[j].col );
+	}
+      if( c->stats )
+	{
+	  hstatMerge( stats, c->stats );
+	  hstatClose( c->stats );
+	}
+      free( c->part );
+      free( c->line );
+      free( c->rec );
+      free( c->first );
+    }
+  free( chunk );
+} /* runParallel */
+
+/**
+   Worker thread: parse the lines of one chunk.  With a single window and
+   no averaging the records are formatted directly; otherwise lines and
+   records are saved for formatChunk().
+   @param[in,out] arg CHUNK to process.
+   @return NULL.
+*/
+void *parseChunk( void *arg )
+{
+  CHUNK *c = arg;
+  const char *p;
+  SENSORDATA raw;
+  LINE *l;
+  size_t len, run, nrun;
+
+  c->nline = c->nrec = 0;
+  if( c->direct )
+    {
+      c->part[0].out->len = 0;
+      if( c->part[0].col ) hcolReset( c->part[0].col );
+    }
+  if( c->stats ) c->stats->sampled = 0;
+  for( p = c->start; p < c->end; p += len )
+    {
+      len = hreadLineLen( p, c->end-p );
+      hstatLine( c->stats, len );
+      if( isdigit( *p ) &&
+	  parseSensorFields( p, p+len, fields, &raw ) == SENSOR_NFIELDS )
+	{ /* Data record */
+	  if( cal ) hcalApply( cal, &raw );
+	  hstatLap( c->stats, HSTAT_PARSE );
+	  if( raw.tsecs < c->from || raw.tsecs > c->to )
+	    {
+	      hstatCount( c->stats, HSTAT_RANGE );
+	      continue;
+	    }
+	  hstatCount( c->stats, HSTAT_RECORDS );
+	  if( c->direct )
+	    {
+	      showRecord( c->part[0].out, c->part[0].col, &raw );
+	      hstatLap( c->stats, HSTAT_FORMAT );
+	      continue;
+	    }
+	  if( c->nrec == c->maxrec )
+	    c->rec = growArray( c->rec, &c->maxrec, sizeof(SENSORDATA) );
+	  c->rec[c->nrec] = raw;
+	  if( c->nline == c->maxline )
+	    c->line = growArray( c->line, &c->maxline, sizeof(LINE) );
+	  l = &c->line[c->nline++];
+	  l->str = p;
+	  l->len = len;
+	  l->rec = c->nrec++;
+	  hstatLap( c->stats, HSTAT_AVERAGE );
+	  continue;
+	}
+      nrun = 1;
+      if( !isdigit( *p ) )
+	{ /* With the comment lines that follow it */
+	  hstatCount( c->stats, HSTAT_COMMENTS );
+	  if( (run = hreadCommentRun( p, c->end-p, 1, HSTAT_LONGLINE,
+				      &nrun )) > len )
+	    {
+	      hstatComments( c->stats, nrun-1, run-len );
+	      len = run;
+	    }
+	  else
+	    nrun = 1;
+	}
+      else
+	hstatCount( c->stats, p[len-1] == '\n' ? HSTAT_MALFORMED :
+		    HSTAT_TRUNCATED );
+      if( c->direct ) /* Comment */
+	houtComments( c->part[0].out, p, len, nrun );
+      else
+	{
+	  if( c->nline == c->maxline )
+	    c->line = growArray( c->line, &c->maxline, sizeof(LINE) );
+	  l = &c->line[c->nline++];
+	  l->str = p;
+	  l->len = len;
+	  l->rec = -(int) nrun;
+	}
+      hstatLap( c->stats, HSTAT_FORMAT );
+    }
+  return NULL;
+} /* parseChunk */
+
+/**
+   Worker thread: format the parsed lines of one chunk for every window,
+   averaging where requested.  The averaging periods must already be
+   marked in CHUNK::first.
+   @param[in,out] arg CHUNK to process.
+   @return NULL.
+*/
+void *formatChunk( void *arg )
+{
+  CHUNK *c = arg;
+  PART *pt;
+  LINE *l;
+  int i, j, r;
+
+  for( j = 0; j < c->nwin; j++ )
+    {
+      pt = &c->part[j];
+      pt->out->len = 0;
+      if( pt->col ) hcolReset( pt->col );
+      pt->started = pt->nhead = pt->navg = 0;
+      pt->split = 0;
+      for( i = 0; i < c->nline; i++ )
+	{
+	  /* Time one line in HSTAT_SAMPLE, as hstatLine() would */
+	  if( c->stats && (c->stats->sampled = (i & (HSTAT_SAMPLE-1)) == 0) )
+	    c->stats->last = hstatTicks();
+	  l = &c->line[i];
+	  if( (r = l->rec) < 0 )
+	    houtComments( pt->out, l->str, l->len, -r );
+	  else if( c->win[j].avgSecs <= 0.0 ) /* No averaging */
+	    showRecord( pt->out, pt->col, &c->rec[r] );
+	  else if( c->first[r*c->nwin+j] )
+	    { /* Start of a new period */
+	      if( pt->started ) showAverage( pt->out, pt->col, pt->navg,
+					     &pt->avg );
+	      else
+		{ /* Merge puts the carried-in average here */
+		  pt->split = pt->out->len;
+		  pt->started = 1;
+		}
+	      pt->navg = harborSensorAdd( fields, 0, &c->rec[r], &pt->avg );
+	    }
+	  else if( pt->started )
+	    pt->navg = harborSensorAdd( fields, pt->navg, &c->rec[r],
+					&pt->avg );
+	  else
+	    pt->nhead++;
+	  hstatLap( c->stats, HSTAT_AVERAGE );
+	}
+    }
+  if( c->stats ) c->stats->sampled = 0;
+  return NULL;
+} /* formatChunk */
+
+/**
+   Run one worker thread per chunk and wait for all of them.
+   @param[in] fn Thread function, given a pointer to its CHUNK.
+   @param[in,out] chunk Chunks to process.
+   @param[in] nchunk Number of chunks.
+*/
+void runThreads( void *(*fn)( void * ), CHUNK *chunk, int nchunk )
+{
+  pthread_t tid[nchunk];
+  int i;
+
+  for( i = 0; i < nchunk; i++ )
+    if( pthread_create( &tid[i], NULL, fn, &chunk[i] ) )
+      {
+	perror( "pthread_create" );
+	exit(EXIT_FAILURE);
+      }
+  for( i = 0; i < nchunk; i++ )
+    pthread_join( tid[i], NULL );
+} /* runThreads */
+
+/**
+   Double the size of a growable array.
+   @param[in] ptr Array, or NULL.
+   @param[in,out] max Allocated entries, updated.
+   @param[in] size Size of one entry.
+   @return Reallocated array.  Exits if memory runs out.
+*/
+void *growArray( void *ptr, int *max, size_t size )
+{
+  *max = *max ? 2**max : 1024;
+  if( (ptr = realloc( ptr, *max*size )) == NULL )
+    {
+      perror( "growArray" );
+      exit(EXIT_FAILURE);
+    }
+  return ptr;
+} /* growArray */
+
+/**
+   Write one record as fixed length columns, the same text as
+   printf( "%6.1f %5.1f %f %f ... %f\n" ).
+   @param[in] out Output buffer.
+   @param[in] col Columnar output, used instead of @a out if not NULL.
+   @param[in] raw Record to write.
+*/
+void showRecord( HOUT *out, HCOL *col, SENSORDATA *raw )
+{
+  if( col )
+    {
+      hcolAppend( col, raw );
+      return;
+    }
+
+  showSensorFields( out, fields, raw );
+  houtChar( out, '\n' );
+} /* showRecord */
+
 /**
    If one or more data points are available, calculate and display
-   averages to stdout.
+   averages of the --fields selection.
+   @param[in] out Output buffer.
+   @param[in] col Columnar output, used instead of @a out if not NULL.
    @param[in] navg Number of points in average.
-   @param[in,out] avg Sums to be converted to averages for display.
+   @param[in] avg Sums for the period.
 */
-void showAverage( int navg, SENSORDATA *avg )
+void showAverage( HOUT *out, HCOL *col, int navg, SENSORSUM *avg )
 {
+  SENSORDATA rec;
+
   if( navg < 1 ) return; /* Nothing to do */
 
-  avg->tsecs /= (float) navg;
-  avg->tmpi /= (float) navg;
-  avg->a1x /= (float) navg;
-  avg->a1y /= (float) navg;
-  avg->a1z /= (float) navg;
-  avg->a2x /= (float) navg;
-  avg->a2y /= (float) navg;
-  avg->a2z /= (float) navg;
-  avg->magx /= (float) navg;
-  avg->magy /= (float) navg;
-  avg->magz /= (float) navg;
-  avg->gyrx /= (float) navg;
-  avg->gyry /= (float) navg;
-  avg->gyrz /= (float) navg;
-  avg->humid /= (float) navg;
-  avg->prss /= (float) navg;
-  avg->tmpx /= (float) navg;
-  avg->vbat /= (float) navg;
-  printf( "%6.1f %5.1f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f %f\n",
-	  avg->tsecs, avg->tmpi, avg->a1x, avg->a1y, avg->a1z,
-	  avg->a2x, avg->a2y, avg->a2z, avg->magx, avg->magy,
-	  avg->magz, avg->gyrx, avg->gyry, avg->gyrz, avg->humid,
-	  avg->prss, avg->tmpx, avg->vbat );
+  harborSensorMean( fields, navg, avg, &rec );
+  showRecord( out, col, &rec );
 } /* showAverage */
 
 /**
-   Adds values from raw to avg.
-   @param[in] navg Number of points in current average.
-   @param[in] raw Raw data values.
-   @param[in,out] avg Sums to be converted to averages by showAverage().
-   @return navg+1.
-*/
-int updateAverage( int navg, SENSORDATA *raw, SENSORDATA *avg )
-{
-  if( navg < 1 )
-    { /* First data for new average */
-      avg->tsecs = raw->tsecs;
-      avg->tmpi = raw->tmpi;
-      avg->a1x = raw->a1x;
-      avg->a1y = raw->a1y;
-      avg->a1z = raw->a1z;
-      avg->a2x = raw->a2x;
-      avg->a2y = raw->a2y;
-      avg->a2z = raw->a2z;
-      avg->magx = raw->magx;
-      avg->magy = raw->magy;
-      avg->magz = raw->magz;
-      avg->gyrx = raw->gyrx;
-      avg->gyry = raw->gyry;
-      avg->gyrz = raw->gyrz;
-      avg->humid = raw->humid;
-      avg->prss = raw->prss;
-      avg->tmpx = raw->tmpx;
-      avg->vbat = raw->vbat;
-      navg = 0;
+   Add a calibration to the hash of the options of a run: the compiled
+   coefficients, lanes, tables and units rather than the name of the
+   file, so a checkpoint is not resumed once the file has been edited.
+   @param[in] hash Hash of the options so far.
+   @param[in] cal Calibration, or NULL for counts.
+   @return Hash.
+*/
+uint32_t hashCal( uint32_t hash, const HCAL *cal )
+{
+  int i;
+
+  if( cal == NULL ) return hckptHash( hash, "" );
+  hash = hckptHashData( hash, &cal->deg, sizeof(cal->deg) );
+  hash = hckptHashData( hash, cal->coef, sizeof(cal->coef) );
+  hash = hckptHashData( hash, cal->mask, sizeof(cal->mask) );
+  for( i = 0; i < cal->nlut; i++ )
+    {
+      hash = hckptHashData( hash, &cal->lut[i].field, sizeof(int) );
+      hash = hckptHashData( hash, cal->lut[i].table,
+			    cal->lut[i].size*sizeof(float) );
     }
-  else
-    { /* Additional data for average */
-      avg->tsecs += raw->tsecs;
-      avg->tmpi += raw->tmpi;
-      avg->a1x += raw->a1x;
-      avg->a1y += raw->a1y;
-      avg->a1z += raw->a1z;
-      avg->a2x += raw->a2x;
-      avg->a2y += raw->a2y;
-      avg->a2z += raw->a2z;
-      avg->magx += raw->magx;
-      avg->magy += raw->magy;
-      avg->magz += raw->magz;
-      avg->gyrx += raw->gyrx;
-      avg->gyry += raw->gyry;
-      avg->gyrz += raw->gyrz;
-      avg->humid += raw->humid;
-      avg->prss += raw->prss;
-      avg->tmpx += raw->tmpx;
-      avg->vbat += raw->vbat;
-    }
-  return navg+1;
-} /* updateAverage */
+  return hckptHashData( hash, cal->units, sizeof(cal->units) );
+} /* hashCal */
+
+/**
+   Load a checkpoint for resuming a run, if there is one that matches the
+   input and options and every -o output it was saved with is still
+   there, at least as long as it was then.
+   @param[in] path Checkpoint file name.
+   @param[in] in Mapped input.
+   @param[in] config hckptHash() of the options.
+   @param[in] win Windows, with their labels.
+   @param[in] nwin Number of windows.
+   @param[in] outName -o file name template.
+   @param[out] offset Input bytes already reduced.
+   @return Saved state of each window, or NULL to start from the
+   beginning.  Exits if the checkpoint cannot be read.
+*/
+SAVEDWIN *loadCheckpoint( const char *path, HREADER *in, uint32_t config,
+			  WINDOW *win, int nwin, const char *outName,
+			  size_t *offset )
+{
+  SAVEDWIN *saved;
+  struct stat st;
+  char *name;
+  int i, ok;
+
+  if( (saved = hckptLoad( path, in, config, nwin*sizeof(SAVEDWIN),
+			  offset )) == NULL )
+    {
+      if( errno != ENOENT && errno != ESTALE )
+	{
+	  perror( path );
+	  exit(EXIT_FAILURE);
+	}
+      return NULL;
+    }
+  for( i = 0, ok = 1; i < nwin && ok; i++ )
+    {
+      name = houtName( outName, win[i].label );
+      ok = stat( name, &st ) == 0 && st.st_size >= saved[i].outSize;
+      free( name );
+    }
+  if( !ok )
+    {
+      free( saved );
+      return NULL;
+    }
+  return saved;
+} /* loadCheckpoint */
+
+/**
+   Save the state of the windows for a checkpoint, before the averages of
+   the open periods are written.
+   @param[out] saved State of each window.
+   @param[in] win Windows.
+   @param[in] nwin Number of windows.
+*/
+void saveState( SAVEDWIN *saved, WINDOW *win, int nwin )
+{
+  int i;
+
+  for( i = 0; i < nwin; i++ )
+    {
+      saved[i].outSize = houtTell( win[i].out );
+      saved[i].t0 = win[i].t0;
+      saved[i].navg = win[i].navg;
+      saved[i].avg = win[i].avg;
+    }
+} /* saveState */
@@ -0,0 +1,446 @@
+/** @file hsort.c
+    @brief
+    Bounded-memory sort of Harbor records by time, dropping duplicates.
+
+    @details
+    See hsort.h.  The float keys are mapped to unsigned integers of the
+    same order (the sign bit flipped for positive values, all bits for
+    negative ones), so the radix sort and the merge compare integers.
+    The LSD radix sort is stable, so within a run the first record added
+    of each key comes first and the repeats after it are dropped.  Only
+    the last runs are merged together, into the place of the first of
+    them, so earlier runs still come first for equal keys and the first
+    record read of each key is the one kept.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Merge at most HSORT_FANIN runs at once.
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "hsort.h"
+
+/**
+   Records the arena is first allocated for.
+*/
+#define HSORT_FIRST 4096
+
+static uint32_t sortKey( const HSORT *s, const void *rec );
+static void sortRun( HSORT *s );
+static int spillRun( HSORT *s );
+static FILE *spillFile( void );
+static int mergeRuns( HSORT *s, int first );
+static int startMerge( HSORT *s, int first );
+static const void *mergeNext( HSORT *s );
+static int lessRun( const HSORT *s, int a, int b );
+static void siftDown( HSORT *s, int i );
+
+/**
+   Start a sort.
+   @param[in] size Bytes per record.
+   @param[in] keyOffset Offset of the float key in a record.
+   @param[in] limit Bytes the arena and its keys may use.
+   @return Sort, or NULL with errno set: EINVAL if the limit holds fewer
+   than HSORT_FIRST records.
+*/
+HSORT *hsortOpen( size_t size, size_t keyOffset, size_t limit )
+{
+  HSORT *s;
+  size_t maxrec;
+
+  maxrec = limit/(size+2*sizeof(HSORTKEY));
+  if( maxrec < HSORT_FIRST || keyOffset+sizeof(float) > size )
+    {
+      errno = EINVAL;
+      return NULL;
+    }
+  if( (s = calloc( 1, sizeof(HSORT) )) == NULL ) return NULL;
+  s->size = size;
+  s->keyOffset = keyOffset;
+  s->maxrec = maxrec < UINT32_MAX ? maxrec : UINT32_MAX;
+  return s;
+} /* hsortOpen */
+
+/**
+   Integer key of a record, of the same order as its float key.
+   @param[in] s Sort.
+   @param[in] rec Record.
+   @return Key.
+*/
+static uint32_t sortKey( const HSORT *s, const void *rec )
+{
+  uint32_t u;
+
+  memcpy( &u, (const char *) rec+s->keyOffset, sizeof(u) );
+  return u & 0x80000000u ? ~u : u | 0x80000000u;
+} /* sortKey */
+
+/**
+   Add a record.  When the arena is full its records are written out as
+   a sorted run first.
+   @param[in,out] s Sort.
+   @param[in] rec Record, of the size given to hsortOpen().
+   @return 0 on success, or -1 with errno set.
+*/
+int hsortAdd( HSORT *s, const void *rec )
+{
+  size_t alloc;
+  char *arena;
+  HSORTKEY *keys;
+
+  if( s->nrec == s->alloc )
+    {
+      if( s->alloc == s->maxrec && spillRun( s ) ) return -1;
+      if( s->nrec == s->alloc )
+	{ /* Grow the arena, up to the limit */
+	  alloc = s->alloc ? 2*s->alloc : HSORT_FIRST;
+	  if( alloc > s->maxrec ) alloc = s->maxrec;
+	  if( (arena = realloc( s->arena, alloc*s->size )) == NULL )
+	    return -1;
+	  s->arena = arena;
+	  if( (keys = realloc( s->keys, alloc*sizeof(HSORTKEY) )) == NULL )
+	    return -1;
+	  s->keys = keys;
+	  if( (keys = realloc( s->tmp, alloc*sizeof(HSORTKEY) )) == NULL )
+	    return -1;
+	  s->tmp = keys;
+	  s->alloc = alloc;
+	}
+    }
+  memcpy( s->arena+s->nrec*s->size, rec, s->size );
+  s->keys[s->nrec].key = sortKey( s, rec );
+  s->keys[s->nrec].idx = s->nrec;
+  if( s->nrec+s->nrun > 0 && s->keys[s->nrec].key < s->prev ) s->nout++;
+  s->prev = s->keys[s->nrec].key;
+  s->nrec++;
+  return 0;
+} /* hsortAdd */
+
+/**
+   Sort the keys of the arena and drop the repeated ones, leaving s->nrec
+   keys in order.
+   @param[in,out] s Sort.
+*/
+static void sortRun( HSORT *s )
+{
+  size_t count[4][256], sum, c;
+  HSORTKEY *from, *to, *t;
+  size_t i, n;
+  int b;
+
+  if( (n = s->nrec) == 0 ) return;
+  memset( count, 0, sizeof(count) );
+  for( i = 0; i < n; i++ )
+    for( b = 0; b < 4; b++ )
+      count[b][(s->keys[i].key >> 8*b) & 0xff]++;
+  from = s->keys;
+  to = s->tmp;
+  for( b = 0; b < 4; b++ )
+    {
+      if( count[b][(from[0].key >> 8*b) & 0xff] == n )
+	continue; /* All keys share this byte */
+      for( sum = 0, c = 0; c < 256; c++ )
+	{ /* Bucket offsets */
+	  i = count[b][c];
+	  count[b][c] = sum;
+	  sum += i;
+	}
+      for( i = 0; i < n; i++ )
+	to[count[b][(from[i].key >> 8*b) & 0xff]++] = from[i];
+      t = from;
+      from = to;
+      to = t;
+    }
+  if( from != s->keys )
+    { /* Sorted into the scratch array: swap them over */
+      s->tmp = s->keys;
+      s->keys = from;
+    }
+  for( i = 1, c = 1; c < n; c++ )
+    if( s->keys[c].key != s->keys[i-1].key )
+      s->keys[i++] = s->keys[c];
+  s->ndup += n-i;
+  s->nrec = i;
+} /* sortRun */
+
+/**
+   Sort the arena and write it out as a run, leaving it empty.  Once the
+   last HSORT_FANIN runs have the same depth they are merged into one run
+   of the next depth, so at most HSORT_FANIN-1 runs of each depth are
+   left open.
+   @param[in,out] s Sort.
+   @return 0 on success, or -1 with errno set.
+*/
+static int spillRun( HSORT *s )
+{
+  FILE **run, *fp;
+  int *depth;
+  size_t i;
+
+  sortRun( s );
+  if( (run = realloc( s->run, (s->nrun+1)*sizeof(FILE *) )) == NULL )
+    return -1;
+  s->run = run;
+  if( (depth = realloc( s->depth, (s->nrun+1)*sizeof(int) )) == NULL )
+    return -1;
+  s->depth = depth;
+  if( (fp = spillFile()) == NULL ) return -1;
+  for( i = 0; i < s->nrec; i++ )
+    if( fwrite( s->arena+s->keys[i].idx*s->size, s->size, 1, fp ) != 1 )
+      break;
+  if( i < s->nrec || fflush( fp ) )
+    {
+      fclose( fp );
+      if( errno == 0 ) errno = EIO;
+      return -1;
+    }
+  s->depth[s->nrun] = 0;
+  s->run[s->nrun++] = fp;
+  s->nrec = 0;
+  while( s->nrun >= HSORT_FANIN &&
+	 s->depth[s->nrun-HSORT_FANIN] == s->depth[s->nrun-1] )
+    if( mergeRuns( s, s->nrun-HSORT_FANIN ) ) return -1;
+  return 0;
+} /* spillRun */
+
+/**
+   Merge the runs from one to the last into a single run in its place.
+   @param[in,out] s Sort.
+   @param[in] first First run to merge.
+   @return 0 on success, or -1 with errno set.
+*/
+static int mergeRuns( HSORT *s, int first )
+{
+  const void *rec;
+  FILE *fp;
+  int r;
+
+  if( (fp = spillFile()) == NULL ) return -1;
+  if( startMerge( s, first ) )
+    {
+      fclose( fp );
+      return -1;
+    }
+  while( (rec = mergeNext( s )) != NULL )
+    if( fwrite( rec, s->size, 1, fp ) != 1 ) break;
+  if( rec != NULL || s->err || fflush( fp ) )
+    {
+      fclose( fp );
+      if( s->err ) errno = s->err;
+      else if( errno == 0 ) errno = EIO;
+      return -1;
+    }
+  for( r = first; r < s->nrun; r++ ) fclose( s->run[r] );
+  s->run[first] = fp;
+  s->depth[first]++;
+  s->nrun = first+1;
+  return 0;
+} /* mergeRuns */
+
+/**
+   Create a temporary file for a run, removed when it is closed.
+   @return Stream open for update, or NULL with errno set.
+*/
+static FILE *spillFile( void )
+{
+  const char *dir;
+  char *path;
+  FILE *fp;
+  int fd, err;
+
+  if( (dir = getenv( "TMPDIR" )) == NULL || *dir == '\0' ) dir = "/tmp";
+  if( (path = malloc( strlen( dir )+16 )) == NULL ) return NULL;
+  sprintf( path, "%s/hsort.XXXXXX", dir );
+  fd = mkstemp( path );
+  err = errno;
+  if( fd >= 0 ) unlink( path );
+  free( path );
+  if( fd < 0 )
+    {
+      errno = err;
+      return NULL;
+    }
+  if( (fp = fdopen( fd, "w+" )) == NULL )
+    {
+      err = errno;
+      close( fd );
+      errno = err;
+    }
+  return fp;
+} /* spillFile */
+
+/**
+   End the adding of records and start giving them back.  Without runs
+   the arena is sorted in place; otherwise it is written out as the last
+   run, the last runs are merged until HSORT_FANIN are left, and those
+   are merged as they are read.
+   @param[in,out] s Sort.
+   @return 0 on success, or -1 with errno set.
+*/
+int hsortFinish( HSORT *s )
+{
+  s->next = 0;
+  if( s->nrun == 0 )
+    {
+      sortRun( s );
+      return 0;
+    }
+  if( s->nrec > 0 && spillRun( s ) ) return -1;
+  /* The merge needs only the runs */
+  free( s->arena );
+  free( s->keys );
+  free( s->tmp );
+  s->arena = NULL;
+  s->keys = s->tmp = NULL;
+  s->alloc = 0;
+  while( s->nrun > HSORT_FANIN )
+    if( mergeRuns( s, s->nrun-HSORT_FANIN ) ) return -1;
+  return startMerge( s, 0 );
+} /* hsortFinish */
+
+/**
+   Start merging the runs from one to the last: read the first record of
+   each into the heap.
+   @param[in,out] s Sort.
+   @param[in] first First run to merge.
+   @return 0 on success, or -1 with errno set.
+*/
+static int startMerge( HSORT *s, int first )
+{
+  char *head;
+  int *heap;
+  int r, i;
+
+  if( (head = realloc( s->head, (s->nrun+1)*s->size )) == NULL )
+    return -1;
+  s->head = head;
+  if( (heap = realloc( s->heap, s->nrun*sizeof(int) )) == NULL )
+    return -1;
+  s->heap = heap;
+  s->nheap = 0;
+  s->started = 0;
+  for( r = first; r < s->nrun; r++ )
+    {
+      rewind( s->run[r] );
+      if( fread( s->head+r*s->size, s->size, 1, s->run[r] ) == 1 )
+	s->heap[s->nheap++] = r;
+      else if( ferror( s->run[r] ) )
+	s->err = errno ? errno : EIO;
+    }
+  for( i = s->nheap/2-1; i >= 0; i-- ) siftDown( s, i );
+  return 0;
+} /* startMerge */
+
+/**
+   Order of the next records of two runs.
+   @param[in] s Sort.
+   @param[in] a First run.
+   @param[in] b Second run.
+   @return Nonzero if run a comes first: a smaller key, or the same key
+   and an earlier run.
+*/
+static int lessRun( const HSORT *s, int a, int b )
+{
+  uint32_t ka, kb;
+
+  ka = sortKey( s, s->head+a*s->size );
+  kb = sortKey( s, s->head+b*s->size );
+  return ka < kb || (ka == kb && a < b);
+} /* lessRun */
+
+/**
+   Move a heap entry down to its place.
+   @param[in,out] s Sort.
+   @param[in] i Heap index.
+*/
+static void siftDown( HSORT *s, int i )
+{
+  int c, r;
+
+  r = s->heap[i];
+  while( (c = 2*i+1) < s->nheap )
+    {
+      if( c+1 < s->nheap && lessRun( s, s->heap[c+1], s->heap[c] ) ) c++;
+      if( !lessRun( s, s->heap[c], r ) ) break;
+      s->heap[i] = s->heap[c];
+      i = c;
+    }
+  s->heap[i] = r;
+} /* siftDown */
+
+/**
+   Next record in key order, after hsortFinish().
+   @param[in,out] s Sort.
+   @return Record, valid until the next call, or NULL at the end or if a
+   run could not be read, when s->err is set.
+*/
+const void *hsortNext( HSORT *s )
+{
+  if( s->nrun == 0 )
+    return s->next < s->nrec ?
+      s->arena+s->keys[s->next++].idx*s->size : NULL;
+  return mergeNext( s );
+} /* hsortNext */
+
+/**
+   Next record of the runs being merged, dropping repeated keys.
+   @param[in,out] s Sort, after startMerge().
+   @return Record, valid until the next call, or NULL at the end or if a
+   run could not be read, when s->err is set.
+*/
+static const void *mergeNext( HSORT *s )
+{
+  char *out;
+  uint32_t key;
+  int r;
+
+  out = s->head+s->nrun*s->size;
+  while( s->nheap > 0 )
+    {
+      r = s->heap[0];
+      memcpy( out, s->head+r*s->size, s->size );
+      if( fread( s->head+r*s->size, s->size, 1, s->run[r] ) != 1 )
+	{ /* Run finished */
+	  if( ferror( s->run[r] ) ) s->err = errno ? errno : EIO;
+	  s->heap[0] = s->heap[--s->nheap];
+	}
+      if( s->nheap > 0 ) siftDown( s, 0 );
+      key = sortKey( s, out );
+      if( s->started && key == s->last )
+	{ /* Repeated in a later run */
+	  s->ndup++;
+	  continue;
+	}
+      s->started = 1;
+      s->last = key;
+      return out;
+    }
+  return NULL;
+} /* mergeNext */
+
+/**
+   Free a sort and remove its runs.
+   @param[in] s Sort, or NULL.
+*/
+void hsortClose( HSORT *s )
+{
+  int r;
+
+  if( s == NULL ) return;
+  for( r = 0; r < s->nrun; r++ ) fclose( s->run[r] );
+  free( s->run );
+  free( s->depth );
+  free( s->head );
+  free( s->heap );
+  free( s->arena );
+  free( s->keys );
+  free( s->tmp );
+  free( s );
+} /* hsortClose */
@@ -0,0 +1,100 @@
+/** @file hsort.h
+    @brief
+    Bounded-memory sort of Harbor records by time, dropping duplicates.
+
+    @details
+    A restarted ground station sends part of a flight again, leaving runs
+    of records in a file whose tsecs go back in time or repeat.  An HSORT
+    takes the records of a whole file in any order and gives them back
+    in order of their float sort key, tsecs, with only the first record
+    read of each key, so periods can be averaged from them as from a
+    clean file.
+
+    Records are held in an arena, with their keys in a separate column
+    of (key, index) pairs.  When the arena reaches its limit the pairs
+    are radix sorted, eight bits of the key a pass, which reads and
+    writes them sequentially and passes over bytes all keys share, and
+    the records are written to a temporary file in that order as one
+    sorted run.  Runs are merged through a heap, earlier runs first for
+    equal keys, and never more than HSORT_FANIN at once: each time
+    HSORT_FANIN runs of the same depth have been written they are merged
+    into one run of the next depth, and at the end the last runs are
+    merged until HSORT_FANIN are left, for the final merge as the records
+    are read back.  A file that fits in the limit is never written out.
+
+    A file n times the limit has at most HSORT_FANIN+1 runs open, and
+    HSORT_FANIN-1 more for each further factor of HSORT_FANIN in n, so 128
+    for up to 4096 times the limit; each such factor also writes the records
+    out once more.  The memory used is the limit, plus for each open run a
+    stdio buffer (BUFSIZ bytes), a record and an int; the temporary files
+    take the size of the records, twice over while runs are merged, and go
+    in $TMPDIR, or /tmp.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Merge at most HSORT_FANIN runs at once.
+    @endverbatim
+*/
+#ifndef HSORT_H
+#define HSORT_H
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+   Default memory limit, in bytes.
+*/
+#define HSORT_LIMIT (256ull<<20)
+
+/**
+   Most runs merged at once.
+*/
+#define HSORT_FANIN 64
+
+/**
+   Sort key of a record and its place in the arena.
+*/
+typedef struct
+{
+  uint32_t key;        ///< Key, with the order of the float key
+  uint32_t idx;        ///< Record index in the arena
+} HSORTKEY;
+
+/**
+   Sort state.  Use hsortOpen() to create one.
+*/
+typedef struct
+{
+  size_t size;         ///< Bytes per record
+  size_t keyOffset;    ///< Offset of the float key in a record
+  size_t maxrec;       ///< Records the limit allows in the arena
+  size_t nrec;         ///< Records in the arena
+  size_t alloc;        ///< Records allocated in the arena
+  size_t next;         ///< Next key to return from the arena
+  char *arena;         ///< Records, in the order added
+  HSORTKEY *keys;      ///< Keys of the arena records
+  HSORTKEY *tmp;       ///< Radix sort scratch
+  int nrun;            ///< Sorted runs written out
+  FILE **run;          ///< Runs
+  int *depth;          ///< Merges behind each run
+  char *head;          ///< Next record of each run while merging
+  int *heap;           ///< Runs with records left, by next key
+  int nheap;           ///< Entries in heap
+  int started;         ///< Nonzero once a record has been returned
+  uint32_t last;       ///< Key of the last record returned
+  uint32_t prev;       ///< Key of the last record added
+  long long nout;      ///< Records added with an earlier key than the last
+  long long ndup;      ///< Records dropped for a repeated key
+  int err;             ///< errno of a failed run read, or 0
+} HSORT;
+
+HSORT *hsortOpen( size_t size, size_t keyOffset, size_t limit );
+int hsortAdd( HSORT *s, const void *rec );
+int hsortFinish( HSORT *s );
+const void *hsortNext( HSORT *s );
+void hsortClose( HSORT *s );
+
+#endif /* HSORT_H */
@@ -0,0 +1,121 @@
+/** @file hstat.c
+    @brief
+    Line counters and sampled stage timers for Harbor reductions.
+
+    @details
+    See hstat.h.  The report goes to a stdio stream, normally stderr, so
+    it never mixes with the reduced output.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Count truncated records and long lines.
+    2026-Oct-14 Count duplicate and out of order records.
+    @endverbatim
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "hstat.h"
+
+/**
+   Report labels of the counters, in HSTAT_LINES order.
+*/
+static const char *const countNames[HSTAT_NCOUNTS] =
+  { "lines", "records", "comments", "malformed", "truncated",
+    "out of range", "below min_sats", "rejected", "duplicates",
+    "out of order", "long lines" };
+
+/**
+   Report labels of the stages, in HSTAT_READ order.
+*/
+static const char *const stageNames[HSTAT_NSTAGES] =
+  { "read", "parse", "filter", "average", "format" };
+
+/**
+   Start the counters and timers of a run.
+   @return Statistics, or NULL with errno set if memory runs out.
+*/
+HSTAT *hstatOpen( void )
+{
+  HSTAT *st;
+  uint64_t t, d;
+  int i;
+
+  if( (st = calloc( 1, sizeof(HSTAT) )) == NULL ) return NULL;
+  /* Cost of a counter read: the least of a few back-to-back reads */
+  st->cost = UINT64_MAX;
+  for( i = 0; i < 64; i++ )
+    {
+      t = hstatTicks();
+      if( (d = hstatTicks()-t) < st->cost ) st->cost = d;
+    }
+  clock_gettime( CLOCK_MONOTONIC, &st->time0 );
+  st->tick0 = hstatTicks();
+  return st;
+} /* hstatOpen */
+
+/**
+   Add the counters and timers of part of a run, such as one worker
+   thread's chunk, to those of the run.
+   @param[in,out] st Statistics of the run.
+   @param[in] part Statistics of the part.
+*/
+void hstatMerge( HSTAT *st, const HSTAT *part )
+{
+  int i;
+
+  for( i = 0; i < HSTAT_NCOUNTS; i++ ) st->count[i] += part->count[i];
+  for( i = 0; i < HSTAT_NSTAGES; i++ ) st->ticks[i] += part->ticks[i];
+  st->bytes += part->bytes;
+  st->nsample += part->nsample;
+} /* hstatMerge */
+
+/**
+   Write the report of a run: the line counts, the bytes and records per
+   second, and the estimated time in each stage.  Counters that are zero,
+   other than lines and records, are left out.
+   @param[in] st Statistics.
+   @param[in] fp Stream for the report.
+   @param[in] prog Program name.
+   @param[in] input Input file name.
+*/
+void hstatReport( HSTAT *st, FILE *fp, const char *prog, const char *input )
+{
+  struct timespec now;
+  double secs, rate, scale, t;
+  uint64_t ticks;
+  int i;
+
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  ticks = hstatTicks()-st->tick0;
+  secs = (now.tv_sec-st->time0.tv_sec)+(now.tv_nsec-st->time0.tv_nsec)*1e-9;
+  rate = secs > 0.0 && ticks > 0 ? ticks/secs : 1e9; /* Ticks per second */
+  scale = st->nsample ? (double) st->count[HSTAT_LINES]/st->nsample : 0.0;
+
+  fprintf( fp, "# %s stats: %s\n", prog, input );
+  for( i = 0; i < HSTAT_NCOUNTS; i++ )
+    if( i <= HSTAT_RECORDS || st->count[i] )
+      fprintf( fp, "%-16s %12lld\n", countNames[i], st->count[i] );
+  fprintf( fp, "%-16s %12lld  %.1f MB/s\n", "bytes", st->bytes,
+	   secs > 0.0 ? st->bytes/secs/1e6 : 0.0 );
+  fprintf( fp, "%-16s %12.3f s  %.0f records/s\n", "elapsed", secs,
+	   secs > 0.0 ? st->count[HSTAT_RECORDS]/secs : 0.0 );
+  for( i = 0; i < HSTAT_NSTAGES; i++ )
+    {
+      t = st->ticks[i]*scale/rate;
+      fprintf( fp, "%-16s %12.3f s  %4.1f%%\n", stageNames[i], t,
+	       secs > 0.0 ? 100.0*t/secs : 0.0 );
+    }
+} /* hstatReport */
+
+/**
+   Free the statistics of a run.
+   @param[in] st Statistics, or NULL.
+*/
+void hstatClose( HSTAT *st )
+{
+  free( st );
+} /* hstatClose */
@@ -0,0 +1,205 @@
+/** @file hstat.h
+    @brief
+    Line counters and sampled stage timers for Harbor reductions.
+
+    @details
+    An HSTAT counts the lines of a run by what became of them and
+    estimates where the time went: reading, parsing, filtering, averaging
+    and formatting.  Counting is an increment per line.  Only one line in
+    HSTAT_SAMPLE is timed, by reading the time stamp counter between its
+    stages, and the stage totals are scaled up from those samples, so
+    the timers cost a few cycles per line on average and may be left on.
+    The read time of a line is measured from the last stage of the line
+    before it, so a sample times the read that follows it too.
+
+    Stage times from the samples are estimates.  The cost of reading the
+    counter, measured by hstatOpen(), is taken off each stage so the
+    timed lines are not counted as slower than the others.  The counter
+    ticks are converted to seconds with the rate measured against the
+    clock over the whole run.  They are clock time, so a thread that is
+    descheduled during a timed line is charged for the wait; with more
+    threads than processors the stage times are inflated.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Count truncated records and long lines.
+    2026-Oct-14 Added hstatComments() for runs of comment lines.
+    2026-Oct-14 Count duplicate and out of order records.
+    @endverbatim
+*/
+#ifndef HSTAT_H
+#define HSTAT_H
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+   One line in this many is timed.  A power of two.
+*/
+#define HSTAT_SAMPLE 64
+
+/**
+   Lines this long or longer, with the newline, are counted as long: the
+   256-byte line buffer of older Harbor programs split them, so they are
+   the lines whose output differs from those programs' output.
+*/
+#define HSTAT_LONGLINE 256
+
+/**
+   What became of a line.
+*/
+enum
+{
+  HSTAT_LINES,     ///< Lines read
+  HSTAT_RECORDS,   ///< Data records averaged or written
+  HSTAT_COMMENTS,  ///< Lines not starting with a digit
+  HSTAT_MALFORMED, ///< Records with too few fields
+  HSTAT_TRUNCATED, ///< Records with too few fields and no newline, cut
+                   ///< off at the end of the input
+  HSTAT_RANGE,     ///< Records outside --from and --to
+  HSTAT_MINSATS,   ///< GPS records with too few satellites
+  HSTAT_REJECTED,  ///< Records rejected by the outlier filter
+  HSTAT_DUPLICATES, ///< Records dropped by --sort for a repeated tsecs
+  HSTAT_UNORDERED, ///< Records read before one of a later tsecs, --sort
+  HSTAT_LONG,      ///< Lines of HSTAT_LONGLINE bytes or more
+  HSTAT_NCOUNTS
+};
+
+/**
+   Timed stages of the work on a line.
+*/
+enum
+{
+  HSTAT_READ,    ///< Finding the next line
+  HSTAT_PARSE,   ///< Converting the fields
+  HSTAT_FILTER,  ///< Range, satellite and outlier checks
+  HSTAT_AVERAGE, ///< Accumulating averages
+  HSTAT_FORMAT,  ///< Formatting and writing the output
+  HSTAT_NSTAGES
+};
+
+/**
+   Counters and timers of a run.  Use hstatOpen() to create one.
+*/
+typedef struct
+{
+  long long count[HSTAT_NCOUNTS];  ///< Lines by outcome
+  long long bytes;                 ///< Bytes of lines read, with newlines
+  uint64_t ticks[HSTAT_NSTAGES];   ///< Ticks in each stage, sampled lines
+  long long nsample;               ///< Lines timed
+  int sampled;                     ///< Nonzero while timing a line
+  uint64_t last;                   ///< Tick count at the last stage end
+  uint64_t cost;                   ///< Ticks taken by reading the counter
+  uint64_t tick0;                  ///< Tick count at hstatOpen()
+  struct timespec time0;           ///< Clock time at hstatOpen()
+} HSTAT;
+
+/**
+   Read the time stamp counter, or where there is none the monotonic
+   clock in nanoseconds.
+   @return Tick count.
+*/
+static inline uint64_t hstatTicks( void )
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec*1000000000ull+ts.tv_nsec;
+#endif
+} /* hstatTicks */
+
+/**
+   Count a line just read and decide whether to time it.  Call after
+   each line is read.
+   @param[in,out] st Statistics, or NULL for none.
+   @param[in] len Length of the line, including its newline if any.
+*/
+static inline void hstatLine( HSTAT *st, size_t len )
+{
+  uint64_t now;
+
+  if( st == NULL ) return;
+  if( st->sampled || (st->count[HSTAT_LINES] & (HSTAT_SAMPLE-1)) == 0 )
+    {
+      now = hstatTicks();
+      if( st->sampled && now-st->last > st->cost )
+	st->ticks[HSTAT_READ] += now-st->last-st->cost;
+      st->last = now;
+    }
+  st->sampled = (st->count[HSTAT_LINES]++ & (HSTAT_SAMPLE-1)) == 0;
+  st->nsample += st->sampled;
+  st->count[HSTAT_LONG] += len >= HSTAT_LONGLINE;
+  st->bytes += len;
+} /* hstatLine */
+
+/**
+   Count the comment lines that hreadComments() or hreadCommentRun()
+   took along with a comment line, as hstatLine() and hstatCount() would
+   one at a time.  They are timed with that line, and the lines of a
+   run are shorter than HSTAT_LONGLINE.
+   @param[in,out] st Statistics, or NULL for none.
+   @param[in] n Lines after the first.
+   @param[in] bytes Bytes of those lines.
+*/
+static inline void hstatComments( HSTAT *st, size_t n, size_t bytes )
+{
+  if( st == NULL ) return;
+  st->count[HSTAT_LINES] += n;
+  st->count[HSTAT_COMMENTS] += n;
+  st->bytes += bytes;
+  if( st->sampled ) st->nsample += n;
+} /* hstatComments */
+
+/**
+   End a stage of the current line.  The time since the last stage ended
+   is added to @a stage if the line is being timed.
+   @param[in,out] st Statistics, or NULL for none.
+   @param[in] stage Stage that has just ended, such as HSTAT_PARSE.
+*/
+static inline void hstatLap( HSTAT *st, int stage )
+{
+  uint64_t now;
+
+  if( st == NULL || !st->sampled ) return;
+  now = hstatTicks();
+  if( now-st->last > st->cost ) st->ticks[stage] += now-st->last-st->cost;
+  st->last = now;
+} /* hstatLap */
+
+/**
+   Count the outcome of the current line.
+   @param[in,out] st Statistics, or NULL for none.
+   @param[in] which Outcome, such as HSTAT_COMMENTS.
+*/
+static inline void hstatCount( HSTAT *st, int which )
+{
+  if( st ) st->count[which]++;
+} /* hstatCount */
+
+/**
+   Count, or take back, several records of some outcome at once.
+   @param[in,out] st Statistics, or NULL for none.
+   @param[in] which Outcome, such as HSTAT_DUPLICATES.
+   @param[in] n Number of records, negative to take them back.
+*/
+static inline void hstatAdd( HSTAT *st, int which, long long n )
+{
+  if( st ) st->count[which] += n;
+} /* hstatAdd */
+
+HSTAT *hstatOpen( void );
+void hstatMerge( HSTAT *st, const HSTAT *part );
+void hstatReport( HSTAT *st, FILE *fp, const char *prog, const char *input );
+void hstatClose( HSTAT *st );
+
+#endif /* HSTAT_H */
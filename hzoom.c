@@ -0,0 +1,96 @@
+/** @file hzoom.c
+    @brief
+    Serve averages at any zoom from a Harbor pyramid file.
+
+    @details
+    The hzoom program writes the averages of a pyramid file made by
+    hgps or hsensor --pyramid (see hpyr.h) for one resolution and time
+    range, as text columns.  The level is the one with the longest
+    period no longer than the one asked for, and the range is found by
+    binary search in the mapped file, so the time taken depends only on
+    the number of averages written, not on the length of the flight.
+    @verbatim
+    Compile: gcc -Wall -O2 -o hzoom hzoom.c hpyr.c hout.c -pthread -lm
+    Use: hzoom pyramid.hpyr secs [from_tsecs to_tsecs] > output.txt
+    @endverbatim
+    @arg @c pyramid.hpyr is the pyramid file
+    @arg @c secs is the averaging period wanted, in seconds
+    @arg @c from_tsecs and @c to_tsecs limit the output to the periods
+    that overlap that range
+
+    The output starts with comments giving the command line, the level
+    used, its period and the field names, then has one line per period
+    with records: the average of each field, in the order of the file,
+    and the number of records averaged.
+
+    @author Don Rice
+    @date 2026-Oct-14 Initial version
+    @verbatim
+    History:
+    2026-Oct-14 Initial version
+    2026-Oct-14 Echo the whole command line in the header.
+    @endverbatim
+*/
+/**
+   Code modification date
+*/
+#define CODE_MOD_DATE "Mod_Date:2026-Oct-14"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include "hout.h"
+#include "hpyr.h"
+
+int main( int argc, char **argv )
+{
+  int level, nfields, i;
+  double secs, from, to;
+  uint64_t n;
+  const HPYRPERIOD *per;
+  const double *sum;
+  HPYRMAP *m;
+  HOUT *out;
+
+  if( argc != 3 && argc != 5 )
+    {
+      fprintf( stderr, "Use: %s pyramid.hpyr secs [from_tsecs to_tsecs] "
+	       "> output.txt\n", argv[0] );
+      fprintf( stderr, "[%s]\n", CODE_MOD_DATE );
+      exit(EXIT_FAILURE);
+    }
+  secs = atof( argv[2] );
+  from = argc == 5 ? atof( argv[3] ) : -HUGE_VAL;
+  to = argc == 5 ? atof( argv[4] ) : HUGE_VAL;
+  if( (m = hpyrMap( argv[1] )) == NULL )
+    {
+      perror( argv[1] );
+      exit(EXIT_FAILURE);
+    }
+  nfields = m->hdr->nfields;
+  level = hpyrLevel( m, secs );
+  out = houtOpen( STDOUT_FILENO );
+  houtPrintf( out, "# %s", argv[0] );
+  for( i = 1; i < argc; i++ ) houtPrintf( out, " %s", argv[i] );
+  houtPrintf( out, "\n# level %d, %g s periods\n#", level,
+	      m->level[level].secs );
+  for( i = 0; i < nfields; i++ )
+    houtPrintf( out, " %.16s", m->field[i].name );
+  houtPrintf( out, " count\n" );
+  for( n = hpyrFind( m, level, from ); n < m->level[level].count; n++ )
+    {
+      per = hpyrPeriod( m, level, n );
+      if( per->index*m->level[level].secs > to ) break;
+      sum = (const double *) (per+1);
+      for( i = 0; i < nfields; i++ )
+	{
+	  houtFixed( out, sum[i]/per->count, 0, 6 );
+	  houtChar( out, ' ' );
+	}
+      houtInt( out, per->count, 3 );
+      houtChar( out, '\n' );
+    }
+  houtClose( out );
+  hpyrUnmap( m );
+  exit(EXIT_SUCCESS);
+} /* main */